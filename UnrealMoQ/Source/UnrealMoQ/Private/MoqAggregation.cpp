@@ -0,0 +1,110 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqAggregation.h"
+#include "MoqEnvelope.h"
+#include "MoqHandleRegistry.h"
+#include "MoqSubscriber.h"
+#include "Hash/CityHash.h"
+#include "Misc/ScopeRWLock.h"
+
+namespace MoqAggregation
+{
+	uint32 GetRouteId(const FString& Namespace, const FString& TrackName)
+	{
+		// A zero byte cannot occur in either name, so no two tracks share a key
+		FTCHARToUTF8 NamespaceConverter(*Namespace);
+		FTCHARToUTF8 TrackNameConverter(*TrackName);
+		TArray<ANSICHAR, TInlineAllocator<128>> Key;
+		Key.Append(NamespaceConverter.Get(), NamespaceConverter.Length());
+		Key.Add('\0');
+		Key.Append(TrackNameConverter.Get(), TrackNameConverter.Length());
+		return CityHash32(Key.GetData(), Key.Num());
+	}
+
+	int32 GetObjectOverhead(int64 Size)
+	{
+		return RouteIdSize + MoqEnvelope::GetVarintSize(Size);
+	}
+
+	void AppendObject(TArray<uint8>& Out, uint32 RouteId, TConstArrayView<uint8> Data)
+	{
+		for (int32 Shift = 0; Shift < 32; Shift += 8)
+		{
+			Out.Add(static_cast<uint8>(RouteId >> Shift));
+		}
+		MoqEnvelope::WriteVarint(Out, Data.Num());
+		Out.Append(Data.GetData(), Data.Num());
+	}
+}
+
+void FMoqDatagramDemux::AddRoute(uint32 RouteId, void* SubscriberHandle)
+{
+	if (!SubscriberHandle)
+	{
+		return;
+	}
+
+	FWriteScopeLock Lock(RoutesLock);
+	TArray<void*, TInlineAllocator<1>>& Handles = Routes.FindOrAdd(RouteId);
+	Handles.RemoveAll([](void* Handle)
+	{
+		return TMoqHandleRegistry<UMoqSubscriber>::Get().Resolve(Handle) == nullptr;
+	});
+	Handles.AddUnique(SubscriberHandle);
+}
+
+bool FMoqDatagramDemux::Dispatch(TConstArrayView<uint8> Datagram)
+{
+	if (!MoqEnvelope::IsEnvelope(Datagram) || static_cast<MoqEnvelope::EKind>(Datagram[1]) != MoqEnvelope::EKind::Aggregate)
+	{
+		NumMalformed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	while (Offset < Datagram.Num())
+	{
+		uint64 Size = 0;
+		uint32 RouteId = 0;
+		if (Datagram.Num() - Offset < MoqAggregation::RouteIdSize)
+		{
+			NumMalformed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		for (int32 Shift = 0; Shift < 32; Shift += 8)
+		{
+			RouteId |= static_cast<uint32>(Datagram[Offset++]) << Shift;
+		}
+		if (!MoqEnvelope::ReadVarint(Datagram, Offset, Size) || Size > static_cast<uint64>(Datagram.Num() - Offset))
+		{
+			NumMalformed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		// Copied out, so AddRoute on the game thread never waits for a subscriber that is waiting for the game thread
+		TArray<void*, TInlineAllocator<4>> Handles;
+		{
+			FReadScopeLock Lock(RoutesLock);
+			if (const TArray<void*, TInlineAllocator<1>>* Found = Routes.Find(RouteId))
+			{
+				Handles.Append(*Found);
+			}
+		}
+
+		// Each subscriber decodes the object exactly as if it had arrived on its own track
+		if (Handles.Num() > 0)
+		{
+			for (void* Handle : Handles)
+			{
+				UMoqSubscriber::OnAggregatedDataReceived(Handle, Datagram.GetData() + Offset, static_cast<size_t>(Size));
+			}
+			NumDemuxed.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			NumUnrouted.fetch_add(1, std::memory_order_relaxed);
+		}
+		Offset += static_cast<int32>(Size);
+	}
+	return true;
+}
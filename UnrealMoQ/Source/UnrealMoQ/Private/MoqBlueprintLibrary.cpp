@@ -2,89 +2,13 @@
 
 #include "MoqBlueprintLibrary.h"
 #include "MoqClient.h"
+#include "MoqReceiveDispatcher.h"
+#include "MoqStructSerializer.h"
+#include "MoqUtf8.h"
 #include "UObject/Package.h"
+#include "UObject/UnrealType.h"
 #include "moq_ffi.h"
 
-namespace
-{
-bool IsValidUtf8(const uint8* Data, int32 Length)
-{
-	if (Length <= 0 || Data == nullptr)
-	{
-		return true;
-	}
-
-	const uint8* Ptr = Data;
-	const uint8* End = Data + Length;
-
-	while (Ptr < End)
-	{
-		const uint8 Byte = *Ptr++;
-		if ((Byte & 0x80) == 0)
-		{
-			continue; // ASCII
-		}
-
-		int32 ExpectedTrailing = 0;
-		uint32 CodePoint = 0;
-
-		if ((Byte & 0xE0) == 0xC0)
-		{
-			ExpectedTrailing = 1;
-			CodePoint = Byte & 0x1F;
-			if (CodePoint == 0)
-			{
-				return false; // Overlong encoding for ASCII
-			}
-		}
-		else if ((Byte & 0xF0) == 0xE0)
-		{
-			ExpectedTrailing = 2;
-			CodePoint = Byte & 0x0F;
-		}
-		else if ((Byte & 0xF8) == 0xF0)
-		{
-			ExpectedTrailing = 3;
-			CodePoint = Byte & 0x07;
-		}
-		else
-		{
-			return false; // Invalid leading byte
-		}
-
-		if (Ptr + ExpectedTrailing > End)
-		{
-			return false; // Truncated sequence
-		}
-
-		for (int32 Index = 0; Index < ExpectedTrailing; ++Index)
-		{
-			const uint8 Trail = *Ptr++;
-			if ((Trail & 0xC0) != 0x80)
-			{
-				return false; // Invalid continuation byte
-			}
-			CodePoint = (CodePoint << 6) | (Trail & 0x3F);
-		}
-
-		// Reject overlong encodings
-		if ((ExpectedTrailing == 1 && CodePoint < 0x80) ||
-			(ExpectedTrailing == 2 && CodePoint < 0x800) ||
-			(ExpectedTrailing == 3 && CodePoint < 0x10000))
-		{
-			return false;
-		}
-
-		if (CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
-		{
-			return false; // Outside Unicode range or surrogate pairs
-		}
-	}
-
-	return true;
-}
-}
-
 FString UMoqBlueprintLibrary::GetMoqVersion()
 {
 	const char* Version = moq_version();
@@ -112,24 +36,9 @@ FString UMoqBlueprintLibrary::BytesToString(const TArray<uint8>& Data)
 		return FString();
 	}
 
-	if (!IsValidUtf8(Data.GetData(), Data.Num()))
-	{
-		UE_LOG(LogTemp, Warning, TEXT("BytesToString: Invalid UTF-8 sequences detected (pre-validation)"));
-		return FString();
-	}
-
-	// Convert with UTF-8 validation
-	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data.GetData()), Data.Num());
-	if (Converter.Length() == 0)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("BytesToString: Failed to convert UTF-8 data"));
-		return FString();
-	}
-
-	FString Result(Converter.Length(), Converter.Get());
-	
-	// Check for replacement characters which indicate invalid UTF-8
-	if (Result.Contains(TEXT("\uFFFD")))
+	// Validate and convert in a single pass
+	FString Result;
+	if (!MoqUtf8::DecodeToString(Data, Result))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("BytesToString: Invalid UTF-8 sequences detected"));
 		return FString();
@@ -154,6 +63,47 @@ TArray<uint8> UMoqBlueprintLibrary::StringToBytes(const FString& Text)
 	return Result;
 }
 
+FMoqDispatchStats UMoqBlueprintLibrary::GetDispatchStats()
+{
+	return FMoqReceiveDispatcher::Get().GetStats();
+}
+
+bool UMoqBlueprintLibrary::DecodeStruct(const TArray<uint8>& Data, int32& OutValue)
+{
+	// Never called: Blueprint calls go through execDecodeStruct, which knows the struct type
+	check(0);
+	return false;
+}
+
+DEFINE_FUNCTION(UMoqBlueprintLibrary::execDecodeStruct)
+{
+	P_GET_TARRAY_REF(uint8, Data);
+	Stack.MostRecentProperty = nullptr;
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.StepCompiledIn<FStructProperty>(nullptr);
+	const FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+	void* Value = Stack.MostRecentPropertyAddress;
+	P_FINISH;
+
+	P_NATIVE_BEGIN;
+	bool bDecoded = false;
+	if (StructProperty && Value)
+	{
+		FString Error;
+		bDecoded = MoqStructSerializer::Deserialize(StructProperty->Struct, Data, Value, &Error);
+		if (!bDecoded)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DecodeStruct: Cannot decode %s: %s"), *StructProperty->Struct->GetName(), *Error);
+		}
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("DecodeStruct: OutValue must be a struct"));
+	}
+	*static_cast<bool*>(RESULT_PARAM) = bDecoded;
+	P_NATIVE_END;
+}
+
 UMoqClient* UMoqBlueprintLibrary::CreateMoqClient(UObject* Outer)
 {
 	UObject* SafeOuter = Outer ? Outer : GetTransientPackage();
@@ -3,16 +3,26 @@
 #include "MoqClient.h"
 #include "MoqPublisher.h"
 #include "MoqSubscriber.h"
+#include "MoqAggregation.h"
+#include "MoqDatagramAggregator.h"
+#include "MoqHandleRegistry.h"
+#include "MoqRateLimiter.h"
 #include "Async/Async.h"
 
 UMoqClient::UMoqClient()
 	: ClientHandle(nullptr)
+	, CallbackHandle(nullptr)
 	, CurrentState(EMoqConnectionState::Disconnected)
+	, PublishRateLimiter(MakeShared<FMoqRateLimiter, ESPMode::ThreadSafe>())
+	, DatagramAggregator(MakeShared<FMoqDatagramAggregator, ESPMode::ThreadSafe>())
+	, DatagramDemux(MakeShared<FMoqDatagramDemux, ESPMode::ThreadSafe>())
 {
 }
 
 UMoqClient::~UMoqClient()
 {
+	DestroyAggregationSubscriptions();
+
 	if (ClientHandle)
 	{
 		moq_client_destroy(ClientHandle);
@@ -20,8 +30,30 @@ UMoqClient::~UMoqClient()
 	}
 }
 
+void UMoqClient::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		CallbackHandle = TMoqHandleRegistry<UMoqClient>::Get().Register(this);
+	}
+}
+
 void UMoqClient::BeginDestroy()
 {
+	// Drop callbacks that arrive from now on and wait for any still running
+	if (CallbackHandle)
+	{
+		TMoqHandleRegistry<UMoqClient>::Get().Unregister(CallbackHandle);
+		CallbackHandle = nullptr;
+	}
+
+	DestroyAggregationSubscriptions();
+
+	// Packed objects are still sent before the aggregation track goes away
+	DatagramAggregator->Disable();
+
 	if (ClientHandle)
 	{
 		// Disconnect directly without calling virtual function
@@ -35,6 +67,12 @@ void UMoqClient::BeginDestroy()
 
 FMoqResult UMoqClient::Connect(const FString& Url)
 {
+	// Without a handle the connection state callbacks could never reach this client
+	if (!CallbackHandle)
+	{
+		return FMoqResult(false, TEXT("Callback handle registry is full"));
+	}
+
 	// Create client if not already created
 	if (!ClientHandle)
 	{
@@ -50,7 +88,7 @@ FMoqResult UMoqClient::Connect(const FString& Url)
 	const char* UrlCStr = UrlConverter.Get();
 
 	// Connect to the relay
-	MoqResult Result = moq_connect(ClientHandle, UrlCStr, &UMoqClient::OnConnectionStateChangedCallback, this);
+	MoqResult Result = moq_connect(ClientHandle, UrlCStr, &UMoqClient::OnConnectionStateChangedCallback, CallbackHandle);
 
 	if (Result.code == MOQ_OK)
 	{
@@ -122,6 +160,11 @@ FMoqResult UMoqClient::AnnounceNamespace(const FString& Namespace)
 }
 
 UMoqPublisher* UMoqClient::CreatePublisher(const FString& Namespace, const FString& TrackName, EMoqDeliveryMode DeliveryMode)
+{
+	return CreatePublisherWithOptions(Namespace, TrackName, DeliveryMode, FMoqPublishOptions());
+}
+
+UMoqPublisher* UMoqClient::CreatePublisherWithOptions(const FString& Namespace, const FString& TrackName, EMoqDeliveryMode DeliveryMode, const FMoqPublishOptions& Options)
 {
 	if (!ClientHandle)
 	{
@@ -149,12 +192,113 @@ UMoqPublisher* UMoqClient::CreatePublisher(const FString& Namespace, const FStri
 
 	// Create UObject wrapper
 	UMoqPublisher* Publisher = NewObject<UMoqPublisher>(this);
+	Publisher->ApplyOptions(Options);
+	Publisher->SetAggregationRoute(MoqAggregation::GetRouteId(Namespace, TrackName));
 	Publisher->InitializeFromHandle(PublisherHandle);
 
 	return Publisher;
 }
 
+void UMoqClient::SetPublishRateLimit(const FMoqRateLimit& Limit)
+{
+	PublishRateLimiter->SetLimit(Limit);
+}
+
+FMoqRateLimit UMoqClient::GetPublishRateLimit() const
+{
+	return PublishRateLimiter->GetLimit();
+}
+
+FMoqPacingStats UMoqClient::GetPacingStats() const
+{
+	return PublishRateLimiter->GetStats();
+}
+
+FMoqResult UMoqClient::EnableDatagramAggregation(const FString& Namespace, const FMoqAggregationOptions& Options)
+{
+	if (!ClientHandle)
+	{
+		return FMoqResult(false, TEXT("Client not initialized"));
+	}
+
+	FTCHARToUTF8 NamespaceConverter(*Namespace);
+	FTCHARToUTF8 TrackNameConverter(*Options.TrackName);
+
+	MoqPublisher* AggregationHandle = moq_create_publisher_ex(ClientHandle, NamespaceConverter.Get(), TrackNameConverter.Get(), MOQ_DELIVERY_DATAGRAM);
+	if (!AggregationHandle)
+	{
+		const FString ErrorMsg = FString::Printf(TEXT("Failed to create aggregation track %s/%s"), *Namespace, *Options.TrackName);
+		UE_LOG(LogTemp, Error, TEXT("%s"), *ErrorMsg);
+		return FMoqResult(false, ErrorMsg);
+	}
+
+	DatagramAggregator->Enable(AggregationHandle, Options);
+	return FMoqResult(true);
+}
+
+void UMoqClient::DisableDatagramAggregation()
+{
+	DatagramAggregator->Disable();
+}
+
+FMoqResult UMoqClient::SubscribeAggregationTrack(const FString& Namespace, const FString& TrackName)
+{
+	if (!ClientHandle)
+	{
+		return FMoqResult(false, TEXT("Client not initialized"));
+	}
+	if (!CallbackHandle)
+	{
+		return FMoqResult(false, TEXT("Callback handle registry is full"));
+	}
+
+	FTCHARToUTF8 NamespaceConverter(*Namespace);
+	FTCHARToUTF8 TrackNameConverter(*TrackName);
+
+	MoqSubscriber* SubscriberHandle = moq_subscribe(
+		ClientHandle,
+		NamespaceConverter.Get(),
+		TrackNameConverter.Get(),
+		&UMoqClient::OnAggregateDataCallback,
+		CallbackHandle
+	);
+
+	if (!SubscriberHandle)
+	{
+		const char* LastError = moq_last_error();
+		const FString LastErrorMessage = LastError ? UTF8_TO_TCHAR(LastError) : TEXT("Unknown error");
+		return FMoqResult(false, FString::Printf(TEXT("Failed to subscribe to aggregation track %s/%s (LastError: %s)"), *Namespace, *TrackName, *LastErrorMessage));
+	}
+
+	AggregationSubscriptions.Add(SubscriberHandle);
+	return FMoqResult(true);
+}
+
+FMoqAggregationStats UMoqClient::GetAggregationStats() const
+{
+	FMoqAggregationStats Stats;
+	DatagramAggregator->GetStats(Stats);
+	Stats.DemuxedObjects = DatagramDemux->GetNumDemuxed();
+	Stats.UnroutedObjects = DatagramDemux->GetNumUnrouted();
+	Stats.MalformedDatagrams = DatagramDemux->GetNumMalformed();
+	return Stats;
+}
+
+void UMoqClient::DestroyAggregationSubscriptions()
+{
+	for (MoqSubscriber* SubscriberHandle : AggregationSubscriptions)
+	{
+		moq_subscriber_destroy(SubscriberHandle);
+	}
+	AggregationSubscriptions.Reset();
+}
+
 UMoqSubscriber* UMoqClient::Subscribe(const FString& Namespace, const FString& TrackName)
+{
+	return SubscribeWithOptions(Namespace, TrackName, FMoqSubscribeOptions());
+}
+
+UMoqSubscriber* UMoqClient::SubscribeWithOptions(const FString& Namespace, const FString& TrackName, const FMoqSubscribeOptions& Options)
 {
 	if (!ClientHandle)
 	{
@@ -162,8 +306,15 @@ UMoqSubscriber* UMoqClient::Subscribe(const FString& Namespace, const FString& T
 		return nullptr;
 	}
 
-	// Create UObject wrapper first so we can pass it as user data
+	// Create UObject wrapper first so we can pass its callback handle as user data
 	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>(this);
+	Subscriber->ApplyOptions(Options);
+
+	if (!Subscriber->GetCallbackUserData())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Cannot subscribe to %s/%s: Callback handle registry is full"), *Namespace, *TrackName);
+		return nullptr;
+	}
 	
 	FTCHARToUTF8 NamespaceConverter(*Namespace);
 	FTCHARToUTF8 TrackNameConverter(*TrackName);
@@ -173,7 +324,7 @@ UMoqSubscriber* UMoqClient::Subscribe(const FString& Namespace, const FString& T
 		NamespaceConverter.Get(),
 		TrackNameConverter.Get(),
 		&UMoqSubscriber::OnDataReceivedCallback,
-		Subscriber
+		Subscriber->GetCallbackUserData()
 	);
 
 	if (!SubscriberHandle)
@@ -186,6 +337,9 @@ UMoqSubscriber* UMoqClient::Subscribe(const FString& Namespace, const FString& T
 
 	Subscriber->InitializeFromHandle(SubscriberHandle);
 
+	// Objects of this track packed into a publisher's shared datagrams arrive through the aggregation track
+	DatagramDemux->AddRoute(MoqAggregation::GetRouteId(Namespace, TrackName), Subscriber->GetCallbackUserData());
+
 	return Subscriber;
 }
 
@@ -195,10 +349,9 @@ void UMoqClient::OnConnectionStateChangedCallback(void* UserData, MoqConnectionS
 	{
 		return;
 	}
-	
-	UMoqClient* Client = static_cast<UMoqClient*>(UserData);
-	// Validate that the object is still valid
-	if (!IsValid(Client))
+
+	// Drop callbacks for clients that have already been destroyed without touching UObject state
+	if (!TMoqHandleRegistry<UMoqClient>::Get().Pin(UserData))
 	{
 		return;
 	}
@@ -223,14 +376,13 @@ void UMoqClient::OnConnectionStateChangedCallback(void* UserData, MoqConnectionS
 		UE_LOG(LogTemp, Warning, TEXT("Unknown MoQ connection state: %d"), (int)State);
 		return;
 	}
-	
-	Client->CurrentState = NewState;
 
-	// Broadcast on game thread
-	AsyncTask(ENamedThreads::GameThread, [Client, NewState]()
+	// Update state and broadcast on game thread, resolving the handle again in case the client went away
+	AsyncTask(ENamedThreads::GameThread, [UserData, NewState]()
 	{
-		if (IsValid(Client))
+		if (UMoqClient* Client = TMoqHandleRegistry<UMoqClient>::Get().Resolve(UserData))
 		{
+			Client->CurrentState = NewState;
 			Client->OnConnectionStateChanged.Broadcast(NewState);
 		}
 	});
@@ -242,10 +394,9 @@ void UMoqClient::OnTrackAnnouncedCallback(void* UserData, const char* Namespace,
 	{
 		return;
 	}
-	
-	UMoqClient* Client = static_cast<UMoqClient*>(UserData);
-	// Validate that the object is still valid
-	if (!IsValid(Client))
+
+	// Drop callbacks for clients that have already been destroyed without touching UObject state
+	if (!TMoqHandleRegistry<UMoqClient>::Get().Pin(UserData))
 	{
 		return;
 	}
@@ -254,11 +405,28 @@ void UMoqClient::OnTrackAnnouncedCallback(void* UserData, const char* Namespace,
 	FString TrackNameStr = UTF8_TO_TCHAR(TrackName);
 
 	// Broadcast on game thread
-	AsyncTask(ENamedThreads::GameThread, [Client, NamespaceStr, TrackNameStr]()
+	AsyncTask(ENamedThreads::GameThread, [UserData, NamespaceStr, TrackNameStr]()
 	{
-		if (IsValid(Client))
+		if (UMoqClient* Client = TMoqHandleRegistry<UMoqClient>::Get().Resolve(UserData))
 		{
 			Client->OnTrackAnnounced.Broadcast(NamespaceStr, TrackNameStr);
 		}
 	});
 }
+
+void UMoqClient::OnAggregateDataCallback(void* UserData, const uint8_t* Data, size_t DataLen)
+{
+	if (!UserData || !Data || DataLen == 0 || DataLen > static_cast<size_t>(MAX_int32))
+	{
+		return;
+	}
+
+	// The pin keeps the client, and so its demultiplexer, alive until every object is handed over
+	TMoqHandleRegistry<UMoqClient>::FPin Client = TMoqHandleRegistry<UMoqClient>::Get().Pin(UserData);
+	if (!Client)
+	{
+		return;
+	}
+
+	Client->DatagramDemux->Dispatch(MakeArrayView(Data, static_cast<int32>(DataLen)));
+}
@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqCompression.h"
+#include "Hash/CityHash.h"
+#include "Misc/Compression.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+namespace
+{
+/** Training granularity: recurring runs shorter than this are not worth a dictionary slot */
+constexpr int32 TrainSegmentSize = 16;
+
+FName GetFormatName(EMoqCompression Codec)
+{
+	switch (Codec)
+	{
+	case EMoqCompression::Zlib:
+		return NAME_Zlib;
+	case EMoqCompression::LZ4:
+		return NAME_LZ4;
+	case EMoqCompression::Oodle:
+		return NAME_Oodle;
+	default:
+		return NAME_None;
+	}
+}
+
+/**
+ * Deflate and inflate streams are a few hundred KB each, so every thread keeps one of each and
+ * resets it per object instead of paying for init and teardown on the publish path.
+ */
+struct FZlibStreams
+{
+	z_stream Deflate = {};
+	z_stream Inflate = {};
+	bool bDeflateReady = false;
+	bool bInflateReady = false;
+
+	~FZlibStreams()
+	{
+		if (bDeflateReady)
+		{
+			deflateEnd(&Deflate);
+		}
+		if (bInflateReady)
+		{
+			inflateEnd(&Inflate);
+		}
+	}
+
+	z_stream* GetDeflate()
+	{
+		if (!bDeflateReady)
+		{
+			bDeflateReady = deflateInit2(&Deflate, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+			return bDeflateReady ? &Deflate : nullptr;
+		}
+		return deflateReset(&Deflate) == Z_OK ? &Deflate : nullptr;
+	}
+
+	z_stream* GetInflate()
+	{
+		if (!bInflateReady)
+		{
+			bInflateReady = inflateInit2(&Inflate, -MAX_WBITS) == Z_OK;
+			return bInflateReady ? &Inflate : nullptr;
+		}
+		return inflateReset(&Inflate) == Z_OK ? &Inflate : nullptr;
+	}
+};
+
+FZlibStreams& GetThreadZlibStreams()
+{
+	static thread_local FZlibStreams Streams;
+	return Streams;
+}
+
+bool DeflateWithDictionary(TConstArrayView<uint8> Data, TConstArrayView<uint8> Dictionary, TArray<uint8>& Out)
+{
+	z_stream* Stream = GetThreadZlibStreams().GetDeflate();
+	if (!Stream || (Dictionary.Num() > 0 && deflateSetDictionary(Stream, Dictionary.GetData(), Dictionary.Num()) != Z_OK))
+	{
+		return false;
+	}
+
+	// Anything that does not come out smaller is sent raw, so the output never needs more room than the input
+	const int32 Start = Out.Num();
+	Out.AddUninitialized(Data.Num() - 1);
+
+	Stream->next_in = const_cast<Bytef*>(Data.GetData());
+	Stream->avail_in = Data.Num();
+	Stream->next_out = Out.GetData() + Start;
+	Stream->avail_out = Data.Num() - 1;
+
+	const bool bDone = deflate(Stream, Z_FINISH) == Z_STREAM_END;
+	Out.SetNum(Start + (bDone ? static_cast<int32>(Stream->total_out) : 0), EAllowShrinking::No);
+	return bDone;
+}
+
+bool InflateWithDictionary(TConstArrayView<uint8> Compressed, TConstArrayView<uint8> Dictionary, uint8* Out, int64 OutSize)
+{
+	z_stream* Stream = GetThreadZlibStreams().GetInflate();
+	if (!Stream || (Dictionary.Num() > 0 && inflateSetDictionary(Stream, Dictionary.GetData(), Dictionary.Num()) != Z_OK))
+	{
+		return false;
+	}
+
+	Stream->next_in = const_cast<Bytef*>(Compressed.GetData());
+	Stream->avail_in = Compressed.Num();
+	Stream->next_out = Out;
+	Stream->avail_out = static_cast<uInt>(OutSize);
+
+	return inflate(Stream, Z_FINISH) == Z_STREAM_END && Stream->total_out == static_cast<uLong>(OutSize);
+}
+}
+
+namespace MoqCompression
+{
+	TArray<uint8> TrainDictionary(TConstArrayView<TConstArrayView<uint8>> Samples, int32 MaxBytes)
+	{
+		struct FSegment
+		{
+			int32 Count = 0;
+			int32 SampleIndex = 0;
+			int32 Offset = 0;
+		};
+
+		// Count every segment once per sample so one long, self-similar sample cannot dominate
+		TMap<uint64, FSegment> Segments;
+		for (int32 SampleIndex = 0; SampleIndex < Samples.Num(); ++SampleIndex)
+		{
+			const TConstArrayView<uint8> Sample = Samples[SampleIndex];
+			TSet<uint64> SeenInSample;
+			for (int32 Offset = 0; Offset + TrainSegmentSize <= Sample.Num(); ++Offset)
+			{
+				const uint64 Hash = CityHash64(reinterpret_cast<const char*>(Sample.GetData() + Offset), TrainSegmentSize);
+				bool bAlreadySeen = false;
+				SeenInSample.Add(Hash, &bAlreadySeen);
+				if (bAlreadySeen)
+				{
+					continue;
+				}
+
+				FSegment& Segment = Segments.FindOrAdd(Hash);
+				if (Segment.Count++ == 0)
+				{
+					Segment.SampleIndex = SampleIndex;
+					Segment.Offset = Offset;
+				}
+			}
+		}
+
+		TArray<FSegment> Ranked;
+		for (const TPair<uint64, FSegment>& Pair : Segments)
+		{
+			if (Pair.Value.Count > 1)
+			{
+				Ranked.Add(Pair.Value);
+			}
+		}
+		Ranked.Sort([](const FSegment& A, const FSegment& B) { return A.Count > B.Count; });
+
+		// Overlapping segments of the same sample would mostly repeat each other
+		const int32 Budget = FMath::Clamp(MaxBytes, 0, MaxDictionarySize);
+		TArray<const FSegment*> Chosen;
+		TSet<TPair<int32, int32>> Covered;
+		for (const FSegment& Segment : Ranked)
+		{
+			if ((Chosen.Num() + 1) * TrainSegmentSize > Budget)
+			{
+				break;
+			}
+
+			const int32 Bucket = Segment.Offset / TrainSegmentSize;
+			if (Covered.Contains(TPair<int32, int32>(Segment.SampleIndex, Bucket)) || Covered.Contains(TPair<int32, int32>(Segment.SampleIndex, Bucket + 1)))
+			{
+				continue;
+			}
+			Covered.Add(TPair<int32, int32>(Segment.SampleIndex, Bucket));
+			Chosen.Add(&Segment);
+		}
+
+		// Deflate finds the end of the dictionary at the shortest distances, so the most frequent segments go last
+		TArray<uint8> Dictionary;
+		Dictionary.Reserve(Chosen.Num() * TrainSegmentSize);
+		for (int32 Index = Chosen.Num() - 1; Index >= 0; --Index)
+		{
+			Dictionary.Append(Samples[Chosen[Index]->SampleIndex].GetData() + Chosen[Index]->Offset, TrainSegmentSize);
+		}
+		return Dictionary;
+	}
+
+	uint32 GetDictionaryId(TConstArrayView<uint8> Dictionary)
+	{
+		const uint64 Hash = CityHash64(reinterpret_cast<const char*>(Dictionary.GetData()), Dictionary.Num());
+		const uint32 Id = static_cast<uint32>(Hash ^ (Hash >> 32));
+		return Id != 0 ? Id : 1;
+	}
+
+	bool Compress(EMoqCompression Codec, TConstArrayView<uint8> Data, TConstArrayView<uint8> Dictionary, TArray<uint8>& Out)
+	{
+		if (Data.Num() < 2)
+		{
+			return false;
+		}
+
+		if (Codec == EMoqCompression::ZlibDictionary)
+		{
+			return DeflateWithDictionary(Data, Dictionary, Out);
+		}
+
+		const FName Format = GetFormatName(Codec);
+		if (Format.IsNone())
+		{
+			return false;
+		}
+
+		const int32 Start = Out.Num();
+		int32 CompressedSize = FCompression::CompressMemoryBound(Format, Data.Num());
+		Out.AddUninitialized(CompressedSize);
+		if (!FCompression::CompressMemory(Format, Out.GetData() + Start, CompressedSize, Data.GetData(), Data.Num()) || CompressedSize >= Data.Num())
+		{
+			Out.SetNum(Start, EAllowShrinking::No);
+			return false;
+		}
+
+		Out.SetNum(Start + CompressedSize, EAllowShrinking::No);
+		return true;
+	}
+
+	bool Decompress(EMoqCompression Codec, TConstArrayView<uint8> Compressed, TConstArrayView<uint8> Dictionary, uint8* Out, int64 OutSize)
+	{
+		if (OutSize <= 0 || OutSize > MAX_int32)
+		{
+			return false;
+		}
+
+		if (Codec == EMoqCompression::ZlibDictionary)
+		{
+			return InflateWithDictionary(Compressed, Dictionary, Out, OutSize);
+		}
+
+		const FName Format = GetFormatName(Codec);
+		return !Format.IsNone() && FCompression::UncompressMemory(Format, Out, static_cast<int32>(OutSize), Compressed.GetData(), Compressed.Num());
+	}
+}
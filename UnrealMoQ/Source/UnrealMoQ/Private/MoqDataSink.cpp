@@ -0,0 +1,88 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqDataSink.h"
+#include "MoqDataSinkBinding.h"
+
+namespace
+{
+class FMoqFunctionDataSink : public IMoqDataSink
+{
+public:
+	explicit FMoqFunctionDataSink(TUniqueFunction<void(const FSharedBuffer&)>&& InFunction)
+		: Function(MoveTemp(InFunction))
+	{
+	}
+
+	virtual void OnMoqDataReceived(const FSharedBuffer& Payload) override
+	{
+		Function(Payload);
+	}
+
+private:
+	TUniqueFunction<void(const FSharedBuffer&)> Function;
+};
+}
+
+TSharedRef<IMoqDataSink, ESPMode::ThreadSafe> MakeMoqDataSink(TUniqueFunction<void(const FSharedBuffer&)>&& Function)
+{
+	return MakeShared<FMoqFunctionDataSink, ESPMode::ThreadSafe>(MoveTemp(Function));
+}
+
+FMoqDataSinkBinding::FMoqDataSinkBinding(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& InSink, const FMoqDataSinkOptions& InOptions)
+	: Sink(InSink)
+	, Options(InOptions)
+	, Pending(InOptions.Thread == EMoqSinkThread::Worker ? InOptions.QueueCapacity : 2)
+{
+}
+
+void FMoqDataSinkBinding::Deliver(const FSharedBuffer& Payload, EMoqOverflowPolicy Policy)
+{
+	if (bClosed.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	if (Options.Thread == EMoqSinkThread::CallbackThread)
+	{
+		Sink->OnMoqDataReceived(Payload);
+		return;
+	}
+
+	if (!Pending.Enqueue(CopyTemp(Payload), Policy))
+	{
+		return;
+	}
+
+	// Only the push that finds the sink idle schedules a drain; the running drain picks up the rest
+	if (!bDrainScheduled.exchange(true))
+	{
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [This = AsShared()]() { This->Drain(); }, Options.Priority);
+	}
+}
+
+void FMoqDataSinkBinding::Close()
+{
+	bClosed.store(true, std::memory_order_release);
+	Pending.Close();
+}
+
+void FMoqDataSinkBinding::Drain()
+{
+	FSharedBuffer Payload;
+	for (;;)
+	{
+		while (Pending.TryDequeue(Payload))
+		{
+			Sink->OnMoqDataReceived(Payload);
+			Payload.Reset();
+		}
+
+		bDrainScheduled.store(false);
+
+		// A push that landed after the last dequeue but saw the flag still set is ours to deliver
+		if (Pending.Num() == 0 || bDrainScheduled.exchange(true))
+		{
+			break;
+		}
+	}
+}
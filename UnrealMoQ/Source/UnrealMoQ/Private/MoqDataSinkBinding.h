@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoqDataSink.h"
+#include "MoqReceiveQueue.h"
+#include <atomic>
+
+/**
+ * A data sink registered on a subscriber, together with the state needed to run it on a worker.
+ *
+ * Worker sinks are serialised without a pipe or lock: the callback thread pushes into a bounded
+ * ring and launches a drain task only when none is scheduled, and the drain task keeps going until
+ * the ring is empty. In-flight tasks hold a reference to the binding, so removing a sink never
+ * waits for them.
+ */
+class FMoqDataSinkBinding : public TSharedFromThis<FMoqDataSinkBinding, ESPMode::ThreadSafe>
+{
+public:
+	FMoqDataSinkBinding(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& InSink, const FMoqDataSinkOptions& InOptions);
+
+	/** Hand one object to the sink (moq-ffi callback thread) */
+	void Deliver(const FSharedBuffer& Payload, EMoqOverflowPolicy Policy);
+
+	/** Stop accepting objects; anything already queued for a worker is still delivered */
+	void Close();
+
+	const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& GetSink() const { return Sink; }
+
+	/** Objects dropped because the worker queue was full */
+	int64 GetNumDropped() const { return Pending.GetNumDropped(); }
+
+private:
+	void Drain();
+
+	TSharedRef<IMoqDataSink, ESPMode::ThreadSafe> Sink;
+	FMoqDataSinkOptions Options;
+
+	/** Objects waiting for the worker (EMoqSinkThread::Worker only) */
+	TMoqBoundedRing<FSharedBuffer> Pending;
+
+	/** Set while a drain task is queued or running */
+	std::atomic<bool> bDrainScheduled{ false };
+
+	std::atomic<bool> bClosed{ false };
+};
+
+/** Immutable list of bindings, swapped as a whole when sinks are added or removed */
+using FMoqDataSinkList = TArray<TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>>;
@@ -0,0 +1,208 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqDatagramAggregator.h"
+#include "MoqAggregation.h"
+#include "MoqEnvelope.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+FMoqDatagramAggregator::~FMoqDatagramAggregator()
+{
+	Disable();
+}
+
+void FMoqDatagramAggregator::Enable(MoqPublisher* InHandle, const FMoqAggregationOptions& Options)
+{
+	{
+		FScopeLock ScopeLock(&Lock);
+		const double Now = FPlatformTime::Seconds();
+		Flush(Now);
+		if (Handle && Handle != InHandle)
+		{
+			moq_publisher_destroy(Handle);
+		}
+
+		Handle = InHandle;
+		MaxDatagramSize = FMath::Max(Options.MaxDatagramSize, 64);
+		MaxDelaySeconds = FMath::Max(Options.MaxDelayMs, 0.0f) / 1000.0;
+
+		// An object is only taken if it fits an empty datagram on its own
+		const int32 MaxFitting = MaxDatagramSize - MoqEnvelope::HeaderSize - MoqAggregation::GetObjectOverhead(MaxDatagramSize);
+		MaxObjectSize.store(FMath::Clamp(Options.MaxObjectSize, 0, MaxFitting), std::memory_order_relaxed);
+		bEnabled.store(Handle != nullptr, std::memory_order_relaxed);
+	}
+
+	if (InHandle && !Thread)
+	{
+		bStopping.store(false, std::memory_order_relaxed);
+		{
+			FScopeLock ScopeLock(&Lock);
+			WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		}
+		Thread = FRunnableThread::Create(this, TEXT("MoqDatagramAggregator"), 0, TPri_AboveNormal);
+	}
+}
+
+void FMoqDatagramAggregator::Disable()
+{
+	bEnabled.store(false, std::memory_order_relaxed);
+	StopThread();
+
+	FScopeLock ScopeLock(&Lock);
+	Flush(FPlatformTime::Seconds());
+	if (Handle)
+	{
+		moq_publisher_destroy(Handle);
+		Handle = nullptr;
+	}
+}
+
+bool FMoqDatagramAggregator::TryAdd(uint32 RouteId, TConstArrayView<uint8> Data)
+{
+	if (!bEnabled.load(std::memory_order_relaxed) || Data.Num() > MaxObjectSize.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	FScopeLock ScopeLock(&Lock);
+	if (!Handle)
+	{
+		return false;
+	}
+
+	// The open datagram goes first if this object would overflow it or its delay is already up
+	const double Now = FPlatformTime::Seconds();
+	const int32 ObjectBytes = MoqAggregation::GetObjectOverhead(Data.Num()) + Data.Num();
+	if (NumObjects > 0 && (Datagram.Num() + ObjectBytes > MaxDatagramSize || Now - FirstObjectTime >= MaxDelaySeconds))
+	{
+		Flush(Now);
+	}
+
+	const bool bOpened = NumObjects == 0;
+	if (bOpened)
+	{
+		MoqEnvelope::WriteHeader(Datagram, MoqEnvelope::EKind::Aggregate);
+		FirstObjectTime = Now;
+	}
+	MoqAggregation::AppendObject(Datagram, RouteId, Data);
+	++NumObjects;
+
+	// Send at once if not even a one-byte object fits any more, or there is no window to wait in
+	if (MaxDelaySeconds <= 0.0 || Datagram.Num() + MoqAggregation::GetObjectOverhead(1) + 1 > MaxDatagramSize)
+	{
+		Flush(Now);
+	}
+	else if (bOpened && WakeEvent)
+	{
+		// The flush thread only needs to hear about a datagram that was just opened
+		WakeEvent->Trigger();
+	}
+	return true;
+}
+
+void FMoqDatagramAggregator::GetStats(FMoqAggregationStats& Stats) const
+{
+	Stats.AggregatedObjects = NumAggregated.load(std::memory_order_relaxed);
+	Stats.SentDatagrams = NumSent.load(std::memory_order_relaxed);
+	Stats.SentBytes = NumSentBytes.load(std::memory_order_relaxed);
+	Stats.FailedDatagrams = NumFailed.load(std::memory_order_relaxed);
+	Stats.MaxAddedDelayMs = static_cast<float>(MaxAddedDelayUs.load(std::memory_order_relaxed) / 1000.0);
+}
+
+void FMoqDatagramAggregator::Flush(double Now)
+{
+	if (NumObjects == 0)
+	{
+		return;
+	}
+
+	MoqResult Result = moq_publish_data(Handle, Datagram.GetData(), static_cast<size_t>(Datagram.Num()), MOQ_DELIVERY_DATAGRAM);
+	if (Result.code == MOQ_OK)
+	{
+		NumSent.fetch_add(1, std::memory_order_relaxed);
+		NumSentBytes.fetch_add(Datagram.Num(), std::memory_order_relaxed);
+		NumAggregated.fetch_add(NumObjects, std::memory_order_relaxed);
+	}
+	else
+	{
+		NumFailed.fetch_add(1, std::memory_order_relaxed);
+		moq_free_str(Result.message);
+	}
+
+	const int64 DelayUs = static_cast<int64>((Now - FirstObjectTime) * 1000000.0);
+	if (DelayUs > MaxAddedDelayUs.load(std::memory_order_relaxed))
+	{
+		MaxAddedDelayUs.store(DelayUs, std::memory_order_relaxed);
+	}
+
+	Datagram.Reset();
+	NumObjects = 0;
+}
+
+void FMoqDatagramAggregator::StopThread()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	// Publishers trigger the event under the lock, so it is only returned once none can
+	FEvent* Event = nullptr;
+	{
+		FScopeLock ScopeLock(&Lock);
+		Swap(Event, WakeEvent);
+	}
+	if (Event)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(Event);
+	}
+}
+
+uint32 FMoqDatagramAggregator::Run()
+{
+	while (!bStopping.load(std::memory_order_acquire))
+	{
+		double WaitSeconds = -1.0;
+		{
+			FScopeLock ScopeLock(&Lock);
+			if (NumObjects > 0)
+			{
+				const double Now = FPlatformTime::Seconds();
+				WaitSeconds = FirstObjectTime + MaxDelaySeconds - Now;
+				if (WaitSeconds <= 0.0)
+				{
+					Flush(Now);
+					continue;
+				}
+			}
+		}
+
+		if (WaitSeconds < 0.0)
+		{
+			WakeEvent->Wait();
+		}
+		else if (WaitSeconds > 0.001)
+		{
+			// Sleep for the bulk of the window and wake up early enough to spend the rest yielding
+			WakeEvent->Wait(static_cast<uint32>(FMath::FloorToInt((WaitSeconds - 0.001) * 1000.0)));
+		}
+		else
+		{
+			FPlatformProcess::YieldThread();
+		}
+	}
+	return 0;
+}
+
+void FMoqDatagramAggregator::Stop()
+{
+	bStopping.store(true, std::memory_order_release);
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
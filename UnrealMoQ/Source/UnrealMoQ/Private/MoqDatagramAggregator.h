@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "moq_ffi.h"
+#include "MoqTypes.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+/**
+ * Publisher side of MoqAggregation, shared by every publisher of a UMoqClient.
+ *
+ * Small datagram objects are appended to one open aggregate datagram, which is sent as soon as the
+ * next object would not fit or the first object in it has waited the configured delay. A flush
+ * thread enforces the delay while publishers are idle; it yields instead of sleeping for the last
+ * millisecond, since OS sleeps are too coarse for sub-millisecond windows. Safe to use from any thread.
+ */
+class FMoqDatagramAggregator : public FRunnable
+{
+public:
+	virtual ~FMoqDatagramAggregator() override;
+
+	/**
+	 * Start packing objects into datagrams on the track of InHandle, taking ownership of it.
+	 * Anything packed for a previous track is sent there first and that track is destroyed.
+	 */
+	void Enable(MoqPublisher* InHandle, const FMoqAggregationOptions& Options);
+
+	/** Send what is packed, stop the flush thread and destroy the aggregation track */
+	void Disable();
+
+	bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+
+	/**
+	 * Pack one datagram object published on the track with RouteId.
+	 * @return False if aggregation is off or the object is too large, in which case the caller sends it itself
+	 */
+	bool TryAdd(uint32 RouteId, TConstArrayView<uint8> Data);
+
+	/** Fill in the publishing counters of Stats */
+	void GetStats(FMoqAggregationStats& Stats) const;
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/** Send the open datagram, if any (Lock held) */
+	void Flush(double Now);
+
+	/** Stop and join the flush thread */
+	void StopThread();
+
+	FCriticalSection Lock;
+	MoqPublisher* Handle = nullptr;
+	TArray<uint8> Datagram;
+	int32 NumObjects = 0;
+	double FirstObjectTime = 0.0;
+	int32 MaxDatagramSize = 0;
+	double MaxDelaySeconds = 0.0;
+
+	std::atomic<bool> bEnabled{ false };
+	std::atomic<int32> MaxObjectSize{ 0 };
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bStopping{ false };
+
+	std::atomic<int64> NumAggregated{ 0 };
+	std::atomic<int64> NumSent{ 0 };
+	std::atomic<int64> NumSentBytes{ 0 };
+	std::atomic<int64> NumFailed{ 0 };
+	std::atomic<int64> MaxAddedDelayUs{ 0 };
+};
@@ -0,0 +1,128 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqDelta.h"
+#include "MoqEnvelope.h"
+
+namespace
+{
+/** Unchanged runs shorter than this cost more as two varints than as XORed zeros inside a changed run */
+constexpr int32 MinUnchangedRun = 3;
+
+uint8 GetBaseByte(TConstArrayView<uint8> Base, int32 Index)
+{
+	return Index < Base.Num() ? Base[Index] : 0;
+}
+
+/** Index of the first byte at or after Start where Target differs from Base */
+int32 SkipUnchanged(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, int32 Start)
+{
+	int32 Index = Start;
+
+	// State snapshots mostly repeat, so compare a word at a time while both buffers have one
+	const int32 Common = FMath::Min(Base.Num(), Target.Num());
+	while (Index + static_cast<int32>(sizeof(uint64)) <= Common)
+	{
+		uint64 BaseWord;
+		uint64 TargetWord;
+		FMemory::Memcpy(&BaseWord, Base.GetData() + Index, sizeof(uint64));
+		FMemory::Memcpy(&TargetWord, Target.GetData() + Index, sizeof(uint64));
+		if (BaseWord != TargetWord)
+		{
+			break;
+		}
+		Index += sizeof(uint64);
+	}
+
+	while (Index < Target.Num() && Target[Index] == GetBaseByte(Base, Index))
+	{
+		++Index;
+	}
+	return Index;
+}
+}
+
+namespace MoqDelta
+{
+	bool Encode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, TArray<uint8>& Out)
+	{
+		const int32 Start = Out.Num();
+		const int32 Limit = Start + Target.Num();
+
+		int32 Index = 0;
+		while (true)
+		{
+			const int32 ChangedStart = SkipUnchanged(Base, Target, Index);
+			if (ChangedStart >= Target.Num())
+			{
+				break;
+			}
+
+			// Extend the changed run across short unchanged gaps
+			int32 ChangedEnd = ChangedStart + 1;
+			while (ChangedEnd < Target.Num())
+			{
+				const int32 NextChange = SkipUnchanged(Base, Target, ChangedEnd);
+				if (NextChange - ChangedEnd >= MinUnchangedRun || NextChange >= Target.Num())
+				{
+					break;
+				}
+				ChangedEnd = NextChange + 1;
+			}
+
+			MoqEnvelope::WriteVarint(Out, ChangedStart - Index);
+			MoqEnvelope::WriteVarint(Out, ChangedEnd - ChangedStart);
+			for (int32 Byte = ChangedStart; Byte < ChangedEnd; ++Byte)
+			{
+				Out.Add(Target[Byte] ^ GetBaseByte(Base, Byte));
+			}
+			Index = ChangedEnd;
+
+			if (Out.Num() >= Limit)
+			{
+				Out.SetNum(Start, EAllowShrinking::No);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool Apply(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, uint8* Out, int64 OutSize)
+	{
+		if (OutSize < 0 || OutSize > MAX_int32)
+		{
+			return false;
+		}
+
+		const int32 Size = static_cast<int32>(OutSize);
+		const int32 Copied = FMath::Min(Base.Num(), Size);
+		FMemory::Memcpy(Out, Base.GetData(), Copied);
+		FMemory::Memzero(Out + Copied, Size - Copied);
+
+		int32 Offset = 0;
+		int64 Index = 0;
+		while (Offset < Delta.Num())
+		{
+			uint64 Unchanged;
+			uint64 Changed;
+			if (!MoqEnvelope::ReadVarint(Delta, Offset, Unchanged) || !MoqEnvelope::ReadVarint(Delta, Offset, Changed)
+				|| Changed == 0 || Changed > static_cast<uint64>(Delta.Num() - Offset))
+			{
+				return false;
+			}
+
+			// Checked one at a time: run lengths come off the network as full 64-bit values, so their sum can wrap
+			const uint64 Remaining = static_cast<uint64>(Size - Index);
+			if (Unchanged > Remaining || Changed > Remaining - Unchanged)
+			{
+				return false;
+			}
+
+			Index += static_cast<int64>(Unchanged);
+			for (uint64 Byte = 0; Byte < Changed; ++Byte)
+			{
+				Out[Index++] ^= Delta[Offset++];
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqDeltaEncoder.h"
+#include "MoqDelta.h"
+#include "MoqEnvelope.h"
+
+void FMoqDeltaEncoder::Configure(int32 InKeyframeInterval, double InKeyframeIntervalSeconds)
+{
+	KeyframeInterval = FMath::Max(InKeyframeInterval, 0);
+	KeyframeIntervalSeconds = FMath::Max(InKeyframeIntervalSeconds, 0.0);
+}
+
+void FMoqDeltaEncoder::Encode(TConstArrayView<uint8> Data, double Now, TArray<uint8>& Out)
+{
+	const bool bKeyframeDue = bKeyframeRequested
+		|| (KeyframeInterval > 0 && ObjectsSinceKeyframe >= KeyframeInterval)
+		|| (KeyframeIntervalSeconds > 0.0 && Now - LastKeyframeTime >= KeyframeIntervalSeconds);
+
+	bool bEncoded = false;
+	if (!bKeyframeDue)
+	{
+		Out.Reset();
+		MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::Delta);
+		MoqEnvelope::WriteVarint(Out, NextSequence);
+		MoqEnvelope::WriteVarint(Out, Data.Num());
+
+		// A delta that is no smaller than the object would not save anything, so send the object as a keyframe instead
+		const int32 KeyframeSize = MoqEnvelope::HeaderSize + MoqEnvelope::GetVarintSize(NextSequence) + Data.Num();
+		bEncoded = MoqDelta::Encode(Previous, Data, Out) && Out.Num() < KeyframeSize;
+	}
+
+	if (bEncoded)
+	{
+		++NumDeltas;
+		++ObjectsSinceKeyframe;
+	}
+	else
+	{
+		WriteKeyframe(Data, Now, Out);
+	}
+
+	Previous.Reset();
+	Previous.Append(Data.GetData(), Data.Num());
+	++NextSequence;
+
+	BytesIn += Data.Num();
+	BytesOut += Out.Num();
+}
+
+void FMoqDeltaEncoder::WriteKeyframe(TConstArrayView<uint8> Data, double Now, TArray<uint8>& Out)
+{
+	Out.Reset();
+	MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::Keyframe);
+	MoqEnvelope::WriteVarint(Out, NextSequence);
+	Out.Append(Data.GetData(), Data.Num());
+
+	++NumKeyframes;
+	ObjectsSinceKeyframe = 1;
+	LastKeyframeTime = Now;
+	bKeyframeRequested = false;
+}
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Turns consecutive objects of a publisher into MoqEnvelope::EKind::Keyframe and EKind::Delta objects.
+ *
+ * Every object carries a sequence number, so a subscriber that misses one notices the gap and waits
+ * for the next keyframe instead of applying a delta to the wrong state. Not thread safe on its own;
+ * FMoqPublisherSendState guards it with a lock held until the object is sent.
+ */
+class FMoqDeltaEncoder
+{
+public:
+	/**
+	 * @param InKeyframeInterval Objects per keyframe, counting the keyframe, 0 for no object limit
+	 * @param InKeyframeIntervalSeconds Longest time between keyframes, 0 for no time limit
+	 */
+	void Configure(int32 InKeyframeInterval, double InKeyframeIntervalSeconds);
+
+	/** Make the next object a keyframe, e.g. after it became unknown whether the last one arrived */
+	void RequestKeyframe() { bKeyframeRequested = true; }
+
+	/** Replace Out with the enveloped form of Data: a delta against the previous object, or a keyframe when one is due */
+	void Encode(TConstArrayView<uint8> Data, double Now, TArray<uint8>& Out);
+
+	int64 GetNumKeyframes() const { return NumKeyframes; }
+	int64 GetNumDeltas() const { return NumDeltas; }
+	int64 GetBytesIn() const { return BytesIn; }
+	int64 GetBytesOut() const { return BytesOut; }
+
+private:
+	void WriteKeyframe(TConstArrayView<uint8> Data, double Now, TArray<uint8>& Out);
+
+	/** Last object encoded, the base of the next delta */
+	TArray<uint8> Previous;
+	uint64 NextSequence = 0;
+	int32 KeyframeInterval = 30;
+	double KeyframeIntervalSeconds = 0.5;
+	int32 ObjectsSinceKeyframe = 0;
+	double LastKeyframeTime = 0.0;
+	bool bKeyframeRequested = true;
+
+	int64 NumKeyframes = 0;
+	int64 NumDeltas = 0;
+	int64 BytesIn = 0;
+	int64 BytesOut = 0;
+};
@@ -0,0 +1,128 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqEnvelope.h"
+
+namespace MoqEnvelope
+{
+	void WriteVarint(TArray<uint8>& Out, uint64 Value)
+	{
+		do
+		{
+			uint8 Byte = static_cast<uint8>(Value & 0x7F);
+			Value >>= 7;
+			if (Value != 0)
+			{
+				Byte |= 0x80;
+			}
+			Out.Add(Byte);
+		}
+		while (Value != 0);
+	}
+
+	bool ReadVarint(TConstArrayView<uint8> Data, int32& Offset, uint64& OutValue)
+	{
+		uint64 Value = 0;
+		for (int32 Shift = 0; Shift < 70; Shift += 7)
+		{
+			if (Offset >= Data.Num())
+			{
+				return false;
+			}
+
+			const uint8 Byte = Data[Offset++];
+			Value |= static_cast<uint64>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0)
+			{
+				OutValue = Value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int32 GetVarintSize(uint64 Value)
+	{
+		int32 Size = 1;
+		while (Value >= 0x80)
+		{
+			Value >>= 7;
+			++Size;
+		}
+		return Size;
+	}
+
+	void WriteHeader(TArray<uint8>& Out, EKind Kind)
+	{
+		Out.Add(MagicByte);
+		Out.Add(static_cast<uint8>(Kind));
+	}
+
+	bool ReadGroupHeader(TConstArrayView<uint8> Data, uint64& OutGroupId, uint64& OutObjectId, int32& OutPayloadOffset)
+	{
+		if (!IsEnvelope(Data) || static_cast<EKind>(Data[1]) != EKind::Grouped)
+		{
+			return false;
+		}
+
+		int32 Offset = HeaderSize;
+		if (!ReadVarint(Data, Offset, OutGroupId) || !ReadVarint(Data, Offset, OutObjectId) || Offset >= Data.Num())
+		{
+			return false;
+		}
+
+		OutPayloadOffset = Offset;
+		return true;
+	}
+
+	bool IsGroupStart(TConstArrayView<uint8> Data)
+	{
+		uint64 GroupId;
+		uint64 ObjectId;
+		int32 PayloadOffset;
+		return ReadGroupHeader(Data, GroupId, ObjectId, PayloadOffset) && ObjectId == 0;
+	}
+
+	bool Unpack(const FSharedBuffer& Envelope, TArray<FSharedBuffer>& OutPayloads)
+	{
+		const TConstArrayView<uint8> Data(static_cast<const uint8*>(Envelope.GetData()), static_cast<int32>(Envelope.GetSize()));
+		if (!IsEnvelope(Data))
+		{
+			return false;
+		}
+
+		auto MakePayload = [&Envelope, &Data](int32 Offset, int32 Size)
+		{
+			return FSharedBuffer::MakeView(Data.GetData() + Offset, Size, Envelope);
+		};
+
+		switch (static_cast<EKind>(Data[1]))
+		{
+		case EKind::Raw:
+			OutPayloads.Add(MakePayload(HeaderSize, Data.Num() - HeaderSize));
+			return true;
+
+		case EKind::Coalesced:
+		{
+			// Validate the whole envelope before handing anything out, so a bad one delivers nothing
+			const int32 FirstNew = OutPayloads.Num();
+			int32 Offset = HeaderSize;
+			while (Offset < Data.Num())
+			{
+				uint64 Size;
+				if (!ReadVarint(Data, Offset, Size) || Size == 0 || Size > static_cast<uint64>(Data.Num() - Offset))
+				{
+					OutPayloads.SetNum(FirstNew);
+					return false;
+				}
+
+				OutPayloads.Add(MakePayload(Offset, static_cast<int32>(Size)));
+				Offset += static_cast<int32>(Size);
+			}
+			return OutPayloads.Num() > FirstNew;
+		}
+
+		default:
+			return false;
+		}
+	}
+}
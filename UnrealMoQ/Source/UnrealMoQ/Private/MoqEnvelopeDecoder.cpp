@@ -0,0 +1,291 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqEnvelopeDecoder.h"
+#include "MoqCompression.h"
+#include "MoqDelta.h"
+#include "MoqEnvelope.h"
+#include "MoqPayloadPool.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+/** Cap on the size a compressed or delta object may claim, so a corrupt header cannot trigger a huge allocation */
+constexpr uint64 MaxDecodedSize = 64 * 1024 * 1024;
+
+TConstArrayView<uint8> ViewOf(const FSharedBuffer& Buffer)
+{
+	return TConstArrayView<uint8>(static_cast<const uint8*>(Buffer.GetData()), static_cast<int32>(Buffer.GetSize()));
+}
+
+/**
+ * Split a stateless object into its payloads. Raw and Grouped framing is per payload, also inside
+ * coalesced objects, so it is kept here and removed in one place once every payload is known.
+ */
+bool SplitStateless(const FSharedBuffer& Object, TArray<FSharedBuffer>& OutPayloads)
+{
+	const TConstArrayView<uint8> Data = ViewOf(Object);
+	const MoqEnvelope::EKind Kind = MoqEnvelope::IsEnvelope(Data) ? static_cast<MoqEnvelope::EKind>(Data[1]) : MoqEnvelope::EKind::Raw;
+	if (!MoqEnvelope::IsEnvelope(Data) || Kind == MoqEnvelope::EKind::Raw || Kind == MoqEnvelope::EKind::Grouped)
+	{
+		OutPayloads.Add(Object);
+		return true;
+	}
+	return MoqEnvelope::Unpack(Object, OutPayloads);
+}
+}
+
+bool FMoqEnvelopeDecoder::Decode(const FSharedBuffer& Received, TArray<FMoqDecodedObject>& OutObjects)
+{
+	// FEC protects datagrams exactly as they would otherwise have been sent, so it is undone first
+	const TConstArrayView<uint8> Data = ViewOf(Received);
+	const MoqEnvelope::EKind Kind = MoqEnvelope::IsEnvelope(Data) ? static_cast<MoqEnvelope::EKind>(Data[1]) : MoqEnvelope::EKind::Raw;
+	if (Kind != MoqEnvelope::EKind::FecData && Kind != MoqEnvelope::EKind::FecParity)
+	{
+		return DecodeObject(Received, OutObjects);
+	}
+
+	TArray<FSharedBuffer> Unwrapped;
+	if (!FecDecoder.Add(Received, Unwrapped))
+	{
+		return false;
+	}
+
+	bool bDecoded = true;
+	for (const FSharedBuffer& Datagram : Unwrapped)
+	{
+		bDecoded &= DecodeObject(Datagram, OutObjects);
+	}
+	return bDecoded;
+}
+
+bool FMoqEnvelopeDecoder::DecodeObject(const FSharedBuffer& Received, TArray<FMoqDecodedObject>& OutObjects)
+{
+	// Fragmentation comes after everything but FEC on the publisher, so the whole object is rebuilt before anything else
+	FSharedBuffer Object = Received;
+	const TConstArrayView<uint8> ReceivedData = ViewOf(Received);
+	if (MoqEnvelope::IsEnvelope(ReceivedData) && static_cast<MoqEnvelope::EKind>(ReceivedData[1]) == MoqEnvelope::EKind::Fragment)
+	{
+		Object.Reset();
+		if (!Reassembler.Add(Received, FPlatformTime::Seconds(), Object))
+		{
+			return false;
+		}
+		if (Object.IsNull())
+		{
+			return true;
+		}
+	}
+
+	TArray<FSharedBuffer> Payloads;
+	const TConstArrayView<uint8> Data = ViewOf(Object);
+	if (!MoqEnvelope::IsEnvelope(Data) || static_cast<MoqEnvelope::EKind>(Data[1]) != MoqEnvelope::EKind::Compressed)
+	{
+		if (!DecodeUncompressed(Object, Payloads))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// Compression comes after everything but fragmentation and FEC, so whatever it wraps is decoded as if it had been sent as-is
+		FSharedBuffer Decompressed;
+		if (!Decompress(Object, Decompressed) || !DecodeUncompressed(Decompressed, Payloads))
+		{
+			return false;
+		}
+	}
+
+	// Group framing is applied first by the publisher, to each publish, so it is removed last
+	const int32 FirstNew = OutObjects.Num();
+	for (FSharedBuffer& Payload : Payloads)
+	{
+		FMoqDecodedObject& Decoded = OutObjects.AddDefaulted_GetRef();
+		const TConstArrayView<uint8> PayloadData = ViewOf(Payload);
+		if (!MoqEnvelope::IsEnvelope(PayloadData))
+		{
+			Decoded.Payload = MoveTemp(Payload);
+			continue;
+		}
+
+		// Payloads packed into a coalesced object keep their own Raw or Grouped framing
+		uint64 GroupId;
+		uint64 ObjectId;
+		int32 PayloadOffset = MoqEnvelope::HeaderSize;
+		if (static_cast<MoqEnvelope::EKind>(PayloadData[1]) == MoqEnvelope::EKind::Grouped)
+		{
+			if (!MoqEnvelope::ReadGroupHeader(PayloadData, GroupId, ObjectId, PayloadOffset))
+			{
+				OutObjects.SetNum(FirstNew);
+				return false;
+			}
+			Decoded.GroupId = static_cast<int64>(GroupId);
+			Decoded.ObjectId = static_cast<int64>(ObjectId);
+		}
+		else if (static_cast<MoqEnvelope::EKind>(PayloadData[1]) != MoqEnvelope::EKind::Raw)
+		{
+			OutObjects.SetNum(FirstNew);
+			return false;
+		}
+
+		Decoded.Payload = FSharedBuffer::MakeView(PayloadData.GetData() + PayloadOffset, PayloadData.Num() - PayloadOffset, Payload);
+	}
+	return true;
+}
+
+bool FMoqEnvelopeDecoder::DecodeUncompressed(const FSharedBuffer& Object, TArray<FSharedBuffer>& OutPayloads)
+{
+	const TConstArrayView<uint8> Data = ViewOf(Object);
+	if (!MoqEnvelope::IsEnvelope(Data))
+	{
+		OutPayloads.Add(Object);
+		return true;
+	}
+
+	const MoqEnvelope::EKind Kind = static_cast<MoqEnvelope::EKind>(Data[1]);
+	if (Kind != MoqEnvelope::EKind::Keyframe && Kind != MoqEnvelope::EKind::Delta)
+	{
+		return SplitStateless(Object, OutPayloads);
+	}
+
+	FSharedBuffer State;
+	if (!ApplyDelta(Object, State))
+	{
+		return false;
+	}
+	if (State.IsNull())
+	{
+		// Waiting for a keyframe; nothing to deliver, but nothing wrong with the object either
+		return true;
+	}
+
+	// The state is what would have been sent without delta encoding, so only stateless kinds can be inside
+	return SplitStateless(State, OutPayloads);
+}
+
+bool FMoqEnvelopeDecoder::Decompress(const FSharedBuffer& Object, FSharedBuffer& OutDecompressed)
+{
+	const TConstArrayView<uint8> Data = ViewOf(Object);
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	if (Offset >= Data.Num())
+	{
+		return false;
+	}
+	const EMoqCompression Codec = static_cast<EMoqCompression>(Data[Offset++]);
+
+	uint64 DictionaryId = 0;
+	uint64 Size = 0;
+	if (!MoqEnvelope::ReadVarint(Data, Offset, DictionaryId) || !MoqEnvelope::ReadVarint(Data, Offset, Size) || Size == 0 || Size > MaxDecodedSize)
+	{
+		return false;
+	}
+
+	TSharedPtr<const TMap<uint32, TArray<uint8>>, ESPMode::ThreadSafe> DictionarySnapshot;
+	TConstArrayView<uint8> Dictionary;
+	if (DictionaryId != 0)
+	{
+		{
+			FScopeLock Lock(&DictionariesLock);
+			DictionarySnapshot = Dictionaries;
+		}
+		const TArray<uint8>* Found = DictionarySnapshot.IsValid() ? DictionarySnapshot->Find(static_cast<uint32>(DictionaryId)) : nullptr;
+		if (!Found)
+		{
+			return false;
+		}
+		Dictionary = *Found;
+	}
+
+	const TConstArrayView<uint8> Compressed = Data.RightChop(Offset);
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	bool bDecompressed = false;
+	FSharedBuffer Decompressed = FMoqPayloadPool::Get().Allocate(Size, [&](uint8* Block)
+	{
+		bDecompressed = MoqCompression::Decompress(Codec, Compressed, Dictionary, Block, static_cast<int64>(Size));
+	});
+	DecompressionCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+
+	if (!bDecompressed)
+	{
+		return false;
+	}
+
+	CompressedBytes.fetch_add(Data.Num(), std::memory_order_relaxed);
+	DecompressedBytes.fetch_add(static_cast<int64>(Size), std::memory_order_relaxed);
+	OutDecompressed = MoveTemp(Decompressed);
+	return true;
+}
+
+bool FMoqEnvelopeDecoder::ApplyDelta(const FSharedBuffer& Object, FSharedBuffer& OutState)
+{
+	const TConstArrayView<uint8> Data = ViewOf(Object);
+	const bool bKeyframe = static_cast<MoqEnvelope::EKind>(Data[1]) == MoqEnvelope::EKind::Keyframe;
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	uint64 Sequence = 0;
+	if (!MoqEnvelope::ReadVarint(Data, Offset, Sequence))
+	{
+		return false;
+	}
+
+	if (bKeyframe)
+	{
+		if (Offset >= Data.Num())
+		{
+			return false;
+		}
+
+		OutState = FSharedBuffer::MakeView(Data.GetData() + Offset, Data.Num() - Offset, Object);
+		NumKeyframes.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		uint64 Size = 0;
+		if (!MoqEnvelope::ReadVarint(Data, Offset, Size) || Size == 0 || Size > MaxDecodedSize)
+		{
+			return false;
+		}
+
+		// A lost or reordered object breaks the chain; everything up to the next keyframe would decode to garbage
+		if (!bDeltaSynced || Sequence != DeltaSequence + 1)
+		{
+			bDeltaSynced = false;
+			NumSkippedDeltas.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		const TConstArrayView<uint8> Delta = Data.RightChop(Offset);
+		const TConstArrayView<uint8> Base = ViewOf(DeltaBase);
+		bool bApplied = false;
+		FSharedBuffer State = FMoqPayloadPool::Get().Allocate(Size, [&](uint8* Block)
+		{
+			bApplied = MoqDelta::Apply(Base, Delta, Block, static_cast<int64>(Size));
+		});
+
+		if (!bApplied)
+		{
+			bDeltaSynced = false;
+			return false;
+		}
+
+		OutState = MoveTemp(State);
+		NumDeltas.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	DeltaBase = OutState;
+	DeltaSequence = Sequence;
+	bDeltaSynced = true;
+	return true;
+}
+
+void FMoqEnvelopeDecoder::AddDictionary(TConstArrayView<uint8> Dictionary)
+{
+	const uint32 Id = MoqCompression::GetDictionaryId(Dictionary);
+
+	FScopeLock Lock(&DictionariesLock);
+	TSharedRef<TMap<uint32, TArray<uint8>>, ESPMode::ThreadSafe> NewDictionaries = Dictionaries.IsValid()
+		? MakeShared<TMap<uint32, TArray<uint8>>, ESPMode::ThreadSafe>(*Dictionaries)
+		: MakeShared<TMap<uint32, TArray<uint8>>, ESPMode::ThreadSafe>();
+	NewDictionaries->Add(Id, TArray<uint8>(Dictionary));
+	Dictionaries = NewDictionaries;
+}
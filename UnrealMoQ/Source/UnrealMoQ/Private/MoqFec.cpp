@@ -0,0 +1,251 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqFec.h"
+#include "MoqEnvelope.h"
+#include "MoqPayloadPool.h"
+
+namespace
+{
+/** XOR Data into Accumulator, growing it with zeros as needed */
+void XorInto(TArray<uint8>& Accumulator, TConstArrayView<uint8> Data)
+{
+	if (Accumulator.Num() < Data.Num())
+	{
+		Accumulator.AddZeroed(Data.Num() - Accumulator.Num());
+	}
+
+	uint8* Out = Accumulator.GetData();
+	int32 Index = 0;
+	for (; Index + static_cast<int32>(sizeof(uint64)) <= Data.Num(); Index += sizeof(uint64))
+	{
+		uint64 Word;
+		uint64 Source;
+		FMemory::Memcpy(&Word, Out + Index, sizeof(uint64));
+		FMemory::Memcpy(&Source, Data.GetData() + Index, sizeof(uint64));
+		Word ^= Source;
+		FMemory::Memcpy(Out + Index, &Word, sizeof(uint64));
+	}
+	for (; Index < Data.Num(); ++Index)
+	{
+		Out[Index] ^= Data[Index];
+	}
+}
+}
+
+void FMoqFecEncoder::SetBlockSize(int32 InBlockSize)
+{
+	const int32 NewBlockSize = FMath::Clamp(InBlockSize, 0, MoqFec::MaxBlockSize);
+	if (NewBlockSize != BlockSize)
+	{
+		BlockSize = NewBlockSize;
+		if (NextIndex > 0)
+		{
+			StartBlock();
+		}
+	}
+}
+
+void FMoqFecEncoder::WrapData(TConstArrayView<uint8> Datagram, TArray<uint8>& Out)
+{
+	Out.Reset();
+	MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::FecData);
+	MoqEnvelope::WriteVarint(Out, BlockId);
+	MoqEnvelope::WriteVarint(Out, NextIndex);
+	Out.Append(Datagram.GetData(), Datagram.Num());
+
+	XorInto(Parity, Datagram);
+	SizeParity ^= static_cast<uint64>(Datagram.Num());
+	++NextIndex;
+}
+
+bool FMoqFecEncoder::TakeParity(TArray<uint8>& Out)
+{
+	if (NextIndex < BlockSize)
+	{
+		return false;
+	}
+
+	Out.Reset();
+	MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::FecParity);
+	MoqEnvelope::WriteVarint(Out, BlockId);
+	MoqEnvelope::WriteVarint(Out, NextIndex);
+	MoqEnvelope::WriteVarint(Out, SizeParity);
+	Out.Append(Parity);
+
+	StartBlock();
+	return true;
+}
+
+void FMoqFecEncoder::StartBlock()
+{
+	++BlockId;
+	NextIndex = 0;
+	Parity.Reset();
+	SizeParity = 0;
+}
+
+bool FMoqFecDecoder::Add(const FSharedBuffer& Datagram, TArray<FSharedBuffer>& OutDatagrams)
+{
+	const TConstArrayView<uint8> Data(static_cast<const uint8*>(Datagram.GetData()), static_cast<int32>(Datagram.GetSize()));
+	const bool bParity = static_cast<MoqEnvelope::EKind>(Data[1]) == MoqEnvelope::EKind::FecParity;
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	uint64 BlockId = 0;
+	uint64 IndexOrCount = 0;
+	if (!MoqEnvelope::ReadVarint(Data, Offset, BlockId) || !MoqEnvelope::ReadVarint(Data, Offset, IndexOrCount))
+	{
+		return false;
+	}
+
+	if (!bParity)
+	{
+		if (IndexOrCount >= static_cast<uint64>(MoqFec::MaxBlockSize) || Offset >= Data.Num())
+		{
+			return false;
+		}
+
+		const int32 Index = static_cast<int32>(IndexOrCount);
+		const TConstArrayView<uint8> Payload = Data.RightChop(Offset);
+		FBlock* Block = FindOrAddBlock(BlockId);
+		if (!Block)
+		{
+			OutDatagrams.Add(FSharedBuffer::MakeView(Payload.GetData(), Payload.Num(), Datagram));
+			return true;
+		}
+		if (Block->Count > 0 && Index >= Block->Count)
+		{
+			return false;
+		}
+
+		// Already rebuilt from parity, so this copy arrived late and was delivered once
+		if (Index < Block->Received.Num() && Block->Received[Index])
+		{
+			return true;
+		}
+
+		if (Block->Received.Num() <= Index)
+		{
+			Block->Received.Add(false, Index + 1 - Block->Received.Num());
+		}
+		Block->Received[Index] = true;
+		++Block->NumReceived;
+		Block->MaxIndex = FMath::Max(Block->MaxIndex, Index);
+		XorInto(Block->Xor, Payload);
+		Block->SizeXor ^= static_cast<uint64>(Payload.Num());
+
+		OutDatagrams.Add(FSharedBuffer::MakeView(Payload.GetData(), Payload.Num(), Datagram));
+		TryRecover(*Block, OutDatagrams);
+		return true;
+	}
+
+	uint64 SizeParity = 0;
+	if (IndexOrCount == 0 || IndexOrCount > static_cast<uint64>(MoqFec::MaxBlockSize) || !MoqEnvelope::ReadVarint(Data, Offset, SizeParity))
+	{
+		return false;
+	}
+
+	FBlock* Block = FindOrAddBlock(BlockId);
+	if (!Block || Block->Count > 0)
+	{
+		return true;
+	}
+	if (Block->MaxIndex >= static_cast<int32>(IndexOrCount))
+	{
+		return false;
+	}
+
+	Block->Count = static_cast<int32>(IndexOrCount);
+	XorInto(Block->Xor, Data.RightChop(Offset));
+	Block->SizeXor ^= SizeParity;
+	TryRecover(*Block, OutDatagrams);
+	return true;
+}
+
+FMoqFecDecoder::FBlock* FMoqFecDecoder::FindOrAddBlock(uint64 BlockId)
+{
+	// Reordering never reaches back past the window, so this is a recreated publisher rather than a late datagram
+	if (BlockId < NewestBlockId && NewestBlockId - BlockId > MaxBlocks)
+	{
+		UE_LOG(LogTemp, Log, TEXT("MoQ FEC block id dropped from %llu to %llu; assuming the publisher restarted"), NewestBlockId, BlockId);
+		Restart();
+	}
+
+	if (BlockId < EvictedBelow)
+	{
+		return nullptr;
+	}
+
+	if (FBlock* Block = Blocks.Find(BlockId))
+	{
+		return Block;
+	}
+
+	while (Blocks.Num() >= MaxBlocks)
+	{
+		EvictOldest();
+	}
+	if (BlockId < EvictedBelow)
+	{
+		return nullptr;
+	}
+
+	NewestBlockId = FMath::Max(NewestBlockId, BlockId);
+	return &Blocks.Add(BlockId);
+}
+
+void FMoqFecDecoder::Restart()
+{
+	while (Blocks.Num() > 0)
+	{
+		EvictOldest();
+	}
+	EvictedBelow = 0;
+	NewestBlockId = 0;
+}
+
+void FMoqFecDecoder::EvictOldest()
+{
+	uint64 OldestId = MAX_uint64;
+	for (const TPair<uint64, FBlock>& Pair : Blocks)
+	{
+		OldestId = FMath::Min(OldestId, Pair.Key);
+	}
+
+	// Without the parity the block size is unknown; datagrams after the last one received are not counted
+	const FBlock& Oldest = Blocks.FindChecked(OldestId);
+	const int32 Expected = Oldest.Count > 0 ? Oldest.Count : Oldest.MaxIndex + 1;
+	NumLost.fetch_add(FMath::Max(Expected - Oldest.NumReceived, 0), std::memory_order_relaxed);
+
+	Blocks.Remove(OldestId);
+	EvictedBelow = FMath::Max(EvictedBelow, OldestId + 1);
+}
+
+void FMoqFecDecoder::TryRecover(FBlock& Block, TArray<FSharedBuffer>& OutDatagrams)
+{
+	if (Block.Count == 0 || Block.NumReceived != Block.Count - 1)
+	{
+		return;
+	}
+
+	// Every other datagram and the parity are XORed together, leaving exactly the missing one
+	const uint64 Size = Block.SizeXor;
+	if (Size == 0 || Size > static_cast<uint64>(Block.Xor.Num()))
+	{
+		return;
+	}
+
+	int32 Missing = 0;
+	while (Missing < Block.Received.Num() && Block.Received[Missing])
+	{
+		++Missing;
+	}
+	if (Block.Received.Num() <= Missing)
+	{
+		Block.Received.Add(false, Missing + 1 - Block.Received.Num());
+	}
+
+	Block.Received[Missing] = true;
+	++Block.NumReceived;
+	NumRecovered.fetch_add(1, std::memory_order_relaxed);
+	OutDatagrams.Add(FMoqPayloadPool::Get().CopyFrom(Block.Xor.GetData(), Size));
+}
@@ -0,0 +1,180 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqFragment.h"
+#include "MoqEnvelope.h"
+
+namespace
+{
+/** Largest object a fragment header may claim; anything bigger is treated as corrupt */
+constexpr uint64 MaxObjectSize = 64 * 1024 * 1024;
+
+/** Fragment header size for an object split into Count fragments; the index is never wider than the count */
+int32 GetHeaderSize(int64 Size, uint64 ObjectId, int32 Count)
+{
+	return MoqEnvelope::HeaderSize + MoqEnvelope::GetVarintSize(ObjectId) + MoqEnvelope::GetVarintSize(Size) + 2 * MoqEnvelope::GetVarintSize(Count);
+}
+
+int64 GetChunkSize(int64 Size, int32 Count)
+{
+	return (Size + Count - 1) / Count;
+}
+}
+
+namespace MoqFragment
+{
+	int32 GetFragmentCount(int64 Size, uint64 ObjectId, int32 MaxDatagramSize)
+	{
+		// More fragments can mean a wider count varint and so less room per fragment; settles within a step or two
+		int32 Count = 1;
+		for (;;)
+		{
+			const int64 Room = MaxDatagramSize - GetHeaderSize(Size, ObjectId, Count);
+			if (Room <= 0)
+			{
+				return 0;
+			}
+
+			const int64 Needed = (Size + Room - 1) / Room;
+			if (Needed > MAX_int32)
+			{
+				return 0;
+			}
+			if (Needed <= Count)
+			{
+				// Equal chunks of the rounded-up size may need fewer fragments than that, but never leave one empty
+				return static_cast<int32>((Size + GetChunkSize(Size, Count) - 1) / GetChunkSize(Size, Count));
+			}
+			Count = static_cast<int32>(Needed);
+		}
+	}
+
+	void WriteFragment(TConstArrayView<uint8> Data, uint64 ObjectId, int32 Index, int32 Count, TArray<uint8>& Out)
+	{
+		const int64 ChunkSize = GetChunkSize(Data.Num(), Count);
+		const int64 Offset = Index * ChunkSize;
+		const int64 Size = FMath::Min<int64>(ChunkSize, Data.Num() - Offset);
+
+		Out.Reset();
+		MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::Fragment);
+		MoqEnvelope::WriteVarint(Out, ObjectId);
+		MoqEnvelope::WriteVarint(Out, Data.Num());
+		MoqEnvelope::WriteVarint(Out, Index);
+		MoqEnvelope::WriteVarint(Out, Count);
+		Out.Append(Data.GetData() + Offset, static_cast<int32>(Size));
+	}
+}
+
+void FMoqFragmentReassembler::SetLimits(int64 InMaxBytes, double InTimeoutSeconds)
+{
+	MaxBytes.store(FMath::Max<int64>(InMaxBytes, 0), std::memory_order_relaxed);
+	TimeoutSeconds.store(FMath::Max(InTimeoutSeconds, 0.0), std::memory_order_relaxed);
+}
+
+bool FMoqFragmentReassembler::Add(const FSharedBuffer& Fragment, double Now, FSharedBuffer& OutObject)
+{
+	const TConstArrayView<uint8> Data(static_cast<const uint8*>(Fragment.GetData()), static_cast<int32>(Fragment.GetSize()));
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	uint64 ObjectId = 0;
+	uint64 Size = 0;
+	uint64 Index = 0;
+	uint64 Count = 0;
+	if (!MoqEnvelope::ReadVarint(Data, Offset, ObjectId) || !MoqEnvelope::ReadVarint(Data, Offset, Size) || !MoqEnvelope::ReadVarint(Data, Offset, Index)
+		|| !MoqEnvelope::ReadVarint(Data, Offset, Count) || Size == 0 || Size > MaxObjectSize || Count == 0 || Count > Size || Index >= Count)
+	{
+		return false;
+	}
+
+	const int64 ChunkSize = GetChunkSize(static_cast<int64>(Size), static_cast<int32>(Count));
+	const int64 ChunkOffset = static_cast<int64>(Index) * ChunkSize;
+	if (ChunkOffset >= static_cast<int64>(Size) || Data.Num() - Offset != FMath::Min<int64>(ChunkSize, static_cast<int64>(Size) - ChunkOffset))
+	{
+		return false;
+	}
+
+	NumFragments.fetch_add(1, std::memory_order_relaxed);
+
+	FPendingObject* Object = Pending.Find(ObjectId);
+	if (!Object)
+	{
+		if (static_cast<int64>(Size) > MaxBytes.load(std::memory_order_relaxed))
+		{
+			// Could never complete within the memory cap
+			NumFailed.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		MakeRoom(static_cast<int64>(Size), Now);
+		Object = &Pending.Add(ObjectId);
+		Object->Buffer = FUniqueBuffer::Alloc(Size);
+		Object->Received.Init(false, static_cast<int32>(Count));
+		Object->FirstArrival = Now;
+		PendingBytes.fetch_add(static_cast<int64>(Size), std::memory_order_relaxed);
+	}
+	else if (Object->Buffer.GetSize() != Size || Object->Received.Num() != static_cast<int32>(Count))
+	{
+		Discard(ObjectId);
+		return false;
+	}
+
+	// Duplicates are harmless: the bytes are the same
+	if (Object->Received[static_cast<int32>(Index)])
+	{
+		return true;
+	}
+
+	FMemory::Memcpy(static_cast<uint8*>(Object->Buffer.GetData()) + ChunkOffset, Data.GetData() + Offset, Data.Num() - Offset);
+	Object->Received[static_cast<int32>(Index)] = true;
+	if (++Object->NumReceived < Object->Received.Num())
+	{
+		return true;
+	}
+
+	OutObject = Object->Buffer.MoveToShared();
+	PendingBytes.fetch_sub(static_cast<int64>(Size), std::memory_order_relaxed);
+	Pending.Remove(ObjectId);
+	NumReassembled.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void FMoqFragmentReassembler::Discard(uint64 ObjectId)
+{
+	if (const FPendingObject* Object = Pending.Find(ObjectId))
+	{
+		PendingBytes.fetch_sub(static_cast<int64>(Object->Buffer.GetSize()), std::memory_order_relaxed);
+		NumFailed.fetch_add(1, std::memory_order_relaxed);
+		Pending.Remove(ObjectId);
+	}
+}
+
+void FMoqFragmentReassembler::MakeRoom(int64 Size, double Now)
+{
+	// A datagram lost on the way leaves its object incomplete forever
+	const double Timeout = TimeoutSeconds.load(std::memory_order_relaxed);
+	for (auto It = Pending.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().FirstArrival > Timeout)
+		{
+			PendingBytes.fetch_sub(static_cast<int64>(It.Value().Buffer.GetSize()), std::memory_order_relaxed);
+			NumFailed.fetch_add(1, std::memory_order_relaxed);
+			It.RemoveCurrent();
+		}
+	}
+
+	// Newer objects are worth more than old ones on a lossy real-time track
+	const int64 ByteLimit = MaxBytes.load(std::memory_order_relaxed);
+	while (Pending.Num() > 0 && (Pending.Num() >= MaxPendingObjects || PendingBytes.load(std::memory_order_relaxed) + Size > ByteLimit))
+	{
+		uint64 OldestId = 0;
+		double OldestArrival = TNumericLimits<double>::Max();
+		for (const TPair<uint64, FPendingObject>& Pair : Pending)
+		{
+			if (Pair.Value.FirstArrival < OldestArrival)
+			{
+				OldestId = Pair.Key;
+				OldestArrival = Pair.Value.FirstArrival;
+			}
+		}
+		Discard(OldestId);
+	}
+}
@@ -0,0 +1,120 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqPayloadPool.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+namespace
+{
+/** Upper bound on idle memory kept per size class */
+constexpr uint64 MaxCachedBytesPerBucket = 4 * 1024 * 1024;
+
+/** Keep at least this many blocks per size class even for the largest buckets */
+constexpr int32 MinCachedBlocksPerBucket = 4;
+
+constexpr uint32 BlockAlignment = 16;
+}
+
+FMoqPayloadPool& FMoqPayloadPool::Get()
+{
+	static FMoqPayloadPool Instance;
+	return Instance;
+}
+
+FMoqPayloadPool::~FMoqPayloadPool()
+{
+	Trim();
+}
+
+int32 FMoqPayloadPool::GetBucketIndex(uint64 Size)
+{
+	const uint64 BlockSize = FMath::Max<uint64>(Size, 1ull << MinBlockShift);
+	const int32 Shift = static_cast<int32>(FMath::CeilLogTwo64(BlockSize));
+	return Shift <= MaxBlockShift ? Shift - MinBlockShift : INDEX_NONE;
+}
+
+uint64 FMoqPayloadPool::GetBlockSize(int32 BucketIndex)
+{
+	return 1ull << (BucketIndex + MinBlockShift);
+}
+
+int32 FMoqPayloadPool::GetMaxCachedBlocks(int32 BucketIndex)
+{
+	return FMath::Max(MinCachedBlocksPerBucket, static_cast<int32>(MaxCachedBytesPerBucket / GetBlockSize(BucketIndex)));
+}
+
+FSharedBuffer FMoqPayloadPool::CopyFrom(const void* Data, uint64 Size)
+{
+	if (!Data)
+	{
+		return FSharedBuffer();
+	}
+
+	return Allocate(Size, [Data, Size](uint8* Block)
+	{
+		FMemory::Memcpy(Block, Data, Size);
+	});
+}
+
+FSharedBuffer FMoqPayloadPool::Allocate(uint64 Size, TFunctionRef<void(uint8*)> Fill)
+{
+	if (Size == 0)
+	{
+		return FSharedBuffer();
+	}
+
+	const int32 BucketIndex = GetBucketIndex(Size);
+	if (BucketIndex == INDEX_NONE)
+	{
+		NumAllocated.fetch_add(1, std::memory_order_relaxed);
+		FUniqueBuffer Buffer = FUniqueBuffer::Alloc(Size);
+		Fill(static_cast<uint8*>(Buffer.GetData()));
+		return Buffer.MoveToShared();
+	}
+
+	FBucket& Bucket = Buckets[BucketIndex];
+	uint8* Block = Bucket.FreeBlocks.Pop();
+	if (Block)
+	{
+		Bucket.NumCached.fetch_sub(1, std::memory_order_relaxed);
+		NumReused.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		Block = static_cast<uint8*>(FMemory::Malloc(GetBlockSize(BucketIndex), BlockAlignment));
+		NumAllocated.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Fill(Block);
+
+	return FSharedBuffer::TakeOwnership(Block, Size, [BucketIndex](void* Memory)
+	{
+		FMoqPayloadPool::Get().Release(static_cast<uint8*>(Memory), BucketIndex);
+	});
+}
+
+void FMoqPayloadPool::Release(uint8* Block, int32 BucketIndex)
+{
+	FBucket& Bucket = Buckets[BucketIndex];
+	if (Bucket.NumCached.fetch_add(1, std::memory_order_relaxed) < GetMaxCachedBlocks(BucketIndex))
+	{
+		Bucket.FreeBlocks.Push(Block);
+	}
+	else
+	{
+		Bucket.NumCached.fetch_sub(1, std::memory_order_relaxed);
+		FMemory::Free(Block);
+	}
+}
+
+void FMoqPayloadPool::Trim()
+{
+	for (FBucket& Bucket : Buckets)
+	{
+		while (uint8* Block = Bucket.FreeBlocks.Pop())
+		{
+			Bucket.NumCached.fetch_sub(1, std::memory_order_relaxed);
+			FMemory::Free(Block);
+		}
+	}
+}
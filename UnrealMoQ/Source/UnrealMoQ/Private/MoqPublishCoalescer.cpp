@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqPublishCoalescer.h"
+#include "MoqEnvelope.h"
+
+void FMoqPublishCoalescer::Configure(int32 InMaxBytes, double InMaxDelaySeconds)
+{
+	MaxBytes = FMath::Max(InMaxBytes, MoqEnvelope::HeaderSize + 2);
+	MaxDelaySeconds = FMath::Max(InMaxDelaySeconds, 0.0);
+}
+
+bool FMoqPublishCoalescer::WouldOverflow(int64 Size) const
+{
+	const int64 PackedSize = (NumPending == 0 ? MoqEnvelope::HeaderSize : Packed.Num()) + MoqEnvelope::GetVarintSize(Size) + Size;
+	return PackedSize > MaxBytes;
+}
+
+bool FMoqPublishCoalescer::Add(TConstArrayView<uint8> Data, double Now)
+{
+	if (NumPending == 0)
+	{
+		Packed.Reset();
+		Packed.Reserve(MaxBytes);
+		MoqEnvelope::WriteHeader(Packed, MoqEnvelope::EKind::Coalesced);
+		FirstPendingTime = Now;
+	}
+
+	MoqEnvelope::WriteVarint(Packed, Data.Num());
+	Packed.Append(Data.GetData(), Data.Num());
+	++NumPending;
+
+	return Packed.Num() >= MaxBytes || (MaxDelaySeconds > 0.0 && Now - FirstPendingTime >= MaxDelaySeconds);
+}
+
+FSharedBuffer FMoqPublishCoalescer::Take()
+{
+	if (NumPending == 0)
+	{
+		return FSharedBuffer();
+	}
+
+	int32 Offset = 0;
+	if (NumPending == 1)
+	{
+		// A lone publish goes out as published; anything that looks like an envelope was framed before it was added
+		uint64 Size = 0;
+		Offset = MoqEnvelope::HeaderSize;
+		MoqEnvelope::ReadVarint(Packed, Offset, Size);
+	}
+	else
+	{
+		NumCoalesced += NumPending;
+	}
+	NumPending = 0;
+
+	// Moving a heap-allocated TArray keeps its allocation, so the buffer can point into the array it owns
+	const uint8* Bytes = Packed.GetData();
+	const int64 Size = Packed.Num();
+	FSharedBuffer Whole = FSharedBuffer::TakeOwnership(Bytes, Size, [Owned = MoveTemp(Packed)](void*) {});
+	return Offset == 0 ? Whole : FSharedBuffer::MakeView(Bytes + Offset, Size - Offset, Whole);
+}
@@ -0,0 +1,48 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+
+/**
+ * Packs stream publishes made between flushes into one MoqEnvelope::EKind::Coalesced object.
+ *
+ * Not thread safe on its own; FMoqPublisherSendState guards it with a lock. Payloads that start with
+ * MoqEnvelope::MagicByte must already be envelopes (Raw or Grouped) when they are added, so a flush
+ * that holds a single publish can send it as-is instead of paying for the envelope.
+ */
+class FMoqPublishCoalescer
+{
+public:
+	/**
+	 * @param InMaxBytes Packed size at which the buffer is flushed before taking more
+	 * @param InMaxDelaySeconds Age of the oldest buffered publish at which Add asks for a flush, 0 to wait for the end of the frame
+	 */
+	void Configure(int32 InMaxBytes, double InMaxDelaySeconds);
+
+	/** True if Size bytes would push the packed object past the size threshold */
+	bool WouldOverflow(int64 Size) const;
+
+	/**
+	 * Buffer one publish.
+	 * @return True if the size or time threshold has been reached and the caller should flush now
+	 */
+	bool Add(TConstArrayView<uint8> Data, double Now);
+
+	/** Hand over everything buffered as one object, or an empty buffer if nothing is waiting */
+	FSharedBuffer Take();
+
+	bool IsEmpty() const { return NumPending == 0; }
+
+	/** Publishes taken so far that shared an object with another publish */
+	int64 GetNumCoalesced() const { return NumCoalesced; }
+
+private:
+	TArray<uint8> Packed;
+	int32 NumPending = 0;
+	int32 MaxBytes = 16 * 1024;
+	double MaxDelaySeconds = 0.0;
+	double FirstPendingTime = 0.0;
+	int64 NumCoalesced = 0;
+};
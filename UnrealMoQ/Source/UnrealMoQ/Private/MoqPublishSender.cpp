@@ -0,0 +1,1023 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqPublishSender.h"
+#include "MoqPublisher.h"
+#include "MoqCompression.h"
+#include "MoqDatagramAggregator.h"
+#include "MoqEnvelope.h"
+#include "MoqFragment.h"
+#include "MoqPayloadPool.h"
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+MoqDeliveryMode ToNativeDeliveryMode(EMoqDeliveryMode DeliveryMode)
+{
+	return (DeliveryMode == EMoqDeliveryMode::Datagram) ? MOQ_DELIVERY_DATAGRAM : MOQ_DELIVERY_STREAM;
+}
+
+/** True if an object about to be sent starts a group, alone or as the first publish packed into it */
+bool StartsGroup(TConstArrayView<uint8> Data)
+{
+	if (MoqEnvelope::IsGroupStart(Data))
+	{
+		return true;
+	}
+	if (!MoqEnvelope::IsEnvelope(Data) || static_cast<MoqEnvelope::EKind>(Data[1]) != MoqEnvelope::EKind::Coalesced)
+	{
+		return false;
+	}
+
+	int32 Offset = MoqEnvelope::HeaderSize;
+	uint64 FirstSize = 0;
+	return MoqEnvelope::ReadVarint(Data, Offset, FirstSize) && FirstSize <= static_cast<uint64>(Data.Num() - Offset)
+		&& MoqEnvelope::IsGroupStart(Data.Slice(Offset, static_cast<int32>(FirstSize)));
+}
+}
+
+FMoqPublisherSendState::FMoqPublisherSendState(MoqPublisher* InHandle, UMoqPublisher* InOwner, const FMoqPublishOptions& InOptions,
+	TSharedPtr<FMoqRateLimiter, ESPMode::ThreadSafe> InClientRateLimiter)
+	: Handle(InHandle)
+	, Owner(InOwner)
+	, Pending(InOptions.MaxQueuedObjects)
+	, ClientRateLimiter(MoveTemp(InClientRateLimiter))
+	, Mode(InOptions.Mode)
+	, Policy(InOptions.BackpressurePolicy)
+	, Priority(InOptions.Priority)
+{
+	SetSendWindow(InOptions.MaxQueuedObjects, InOptions.MaxQueuedBytes);
+	SetMaxQueueDelay(InOptions.MaxQueueDelayMs);
+	RateLimiter.SetLimit(InOptions.RateLimit);
+}
+
+FMoqPublisherSendState::~FMoqPublisherSendState()
+{
+	if (Handle)
+	{
+		moq_publisher_destroy(Handle);
+		Handle = nullptr;
+	}
+}
+
+FMoqResult FMoqPublisherSendState::PublishNow(const uint8* Data, int64 Size, EMoqDeliveryMode DeliveryMode)
+{
+	FString ErrorMsg;
+	if (SendObject(Data, Size, ToNativeDeliveryMode(DeliveryMode), &ErrorMsg))
+	{
+		return FMoqResult(true);
+	}
+	return FMoqResult(false, ErrorMsg);
+}
+
+FMoqBatchPublishResult FMoqPublisherSendState::PublishBatchNow(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode)
+{
+	FMoqBatchPublishResult Result;
+	const MoqDeliveryMode NativeDeliveryMode = ToNativeDeliveryMode(DeliveryMode);
+
+	for (int32 Index = 0; Index < Objects.Num(); ++Index)
+	{
+		const TConstArrayView<uint8> Object = Objects[Index];
+		FString* ErrorMsg = Result.FailedIndices.Num() == 0 ? &Result.FirstErrorMessage : nullptr;
+
+		if (Object.Num() == 0)
+		{
+			if (ErrorMsg)
+			{
+				*ErrorMsg = TEXT("Cannot publish empty data");
+			}
+			Result.FailedIndices.Add(Index);
+		}
+		else if (SendObject(Object.GetData(), Object.Num(), NativeDeliveryMode, ErrorMsg))
+		{
+			++Result.NumSucceeded;
+		}
+		else
+		{
+			Result.FailedIndices.Add(Index);
+		}
+	}
+
+	return Result;
+}
+
+FMoqResult FMoqPublisherSendState::Enqueue(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode)
+{
+	FMoqResult Result = TryEnqueueObject(MoveTemp(Payload), DeliveryMode);
+	if (Result.bSuccess)
+	{
+		ScheduleSend();
+	}
+	return Result;
+}
+
+FMoqBatchPublishResult FMoqPublisherSendState::EnqueueBatch(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode)
+{
+	FMoqBatchPublishResult Result;
+
+	for (int32 Index = 0; Index < Objects.Num(); ++Index)
+	{
+		const TConstArrayView<uint8> Object = Objects[Index];
+		const FMoqResult ObjectResult = Object.Num() == 0
+			? FMoqResult(false, TEXT("Cannot publish empty data"))
+			: TryEnqueueObject(FMoqPayloadPool::Get().CopyFrom(Object.GetData(), Object.Num()), DeliveryMode);
+
+		if (!ObjectResult.bSuccess)
+		{
+			if (Result.FailedIndices.Num() == 0)
+			{
+				Result.FirstErrorMessage = ObjectResult.ErrorMessage;
+			}
+			Result.FailedIndices.Add(Index);
+		}
+		else
+		{
+			++Result.NumSucceeded;
+		}
+	}
+
+	if (Result.NumSucceeded > 0)
+	{
+		ScheduleSend();
+	}
+	return Result;
+}
+
+FMoqResult FMoqPublisherSendState::TryEnqueueObject(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode)
+{
+	if (bClosed.load(std::memory_order_acquire))
+	{
+		return FMoqResult(false, TEXT("Publisher is closed"));
+	}
+
+	const int64 Size = static_cast<int64>(Payload.GetSize());
+	int32 Depth;
+	for (;;)
+	{
+		// Reserve room first so concurrent publishers cannot overshoot the window
+		Depth = NumQueued.fetch_add(1, std::memory_order_relaxed) + 1;
+		const int64 Bytes = QueuedBytes.fetch_add(Size, std::memory_order_relaxed) + Size;
+		const int64 ByteLimit = MaxQueuedBytes.load(std::memory_order_relaxed);
+
+		// An object larger than the whole byte window is still let through on its own
+		if (Depth <= MaxQueuedObjects.load(std::memory_order_relaxed) && (ByteLimit <= 0 || Bytes <= ByteLimit || Depth == 1))
+		{
+			break;
+		}
+
+		NumQueued.fetch_sub(1, std::memory_order_relaxed);
+		QueuedBytes.fetch_sub(Size, std::memory_order_relaxed);
+		SetBackpressured(true);
+
+		const EMoqBackpressurePolicy CurrentPolicy = Policy.load(std::memory_order_relaxed);
+		switch (CurrentPolicy)
+		{
+		case EMoqBackpressurePolicy::DropOldest:
+		case EMoqBackpressurePolicy::CoalesceLatest:
+			if (EvictOldest())
+			{
+				while (CurrentPolicy == EMoqBackpressurePolicy::CoalesceLatest && EvictOldest())
+				{
+				}
+				continue;
+			}
+			// The window is taken by objects other producers reserved but have not pushed yet; drop this one rather than spin
+			[[fallthrough]];
+
+		case EMoqBackpressurePolicy::DropNewest:
+			NumDropped.fetch_add(1, std::memory_order_relaxed);
+			return FMoqResult(false, TEXT("Publish dropped by backpressure"));
+
+		case EMoqBackpressurePolicy::FailFast:
+		default:
+			NumDropped.fetch_add(1, std::memory_order_relaxed);
+			return FMoqResult(false, TEXT("Publish queue is full"));
+		}
+	}
+
+	int32 Peak = PeakQueued.load(std::memory_order_relaxed);
+	while (Depth > Peak && !PeakQueued.compare_exchange_weak(Peak, Depth, std::memory_order_relaxed))
+	{
+	}
+
+	FPendingObject Object{ MoveTemp(Payload), DeliveryMode, FPlatformTime::Seconds() };
+	if (!Pending.TryEnqueue(Object))
+	{
+		// Not expected: the ring is never smaller than the window and objects leave the window only after leaving the ring
+		ReleaseWindow(Object);
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return FMoqResult(false, TEXT("Publish dropped by backpressure"));
+	}
+	return FMoqResult(true);
+}
+
+bool FMoqPublisherSendState::EvictOldest()
+{
+	FPendingObject Evicted;
+	if (!Pending.TryDequeue(Evicted))
+	{
+		return false;
+	}
+
+	ReleaseWindow(Evicted);
+	NumDropped.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+void FMoqPublisherSendState::ReleaseWindow(const FPendingObject& Object)
+{
+	const int32 Depth = NumQueued.fetch_sub(1, std::memory_order_relaxed) - 1;
+	const int64 Bytes = QueuedBytes.fetch_sub(static_cast<int64>(Object.Payload.GetSize()), std::memory_order_relaxed) - static_cast<int64>(Object.Payload.GetSize());
+
+	// Release backpressure only once the queue is down to half the window, so the signal does not flap
+	if (bBackpressured.load(std::memory_order_relaxed))
+	{
+		const int64 ByteLimit = MaxQueuedBytes.load(std::memory_order_relaxed);
+		if (Depth <= MaxQueuedObjects.load(std::memory_order_relaxed) / 2 && (ByteLimit <= 0 || Bytes <= ByteLimit / 2))
+		{
+			SetBackpressured(false);
+		}
+	}
+}
+
+void FMoqPublisherSendState::ResetHeldObject()
+{
+	HeldObject.Reset();
+	NumHeld.store(0, std::memory_order_relaxed);
+	HeldBytes.store(0, std::memory_order_relaxed);
+}
+
+void FMoqPublisherSendState::SetBackpressured(bool bInBackpressured)
+{
+	if (bBackpressured.exchange(bInBackpressured, std::memory_order_acq_rel) == bInBackpressured)
+	{
+		return;
+	}
+
+	// Always deferred, so listeners never run inside PublishData; the owner broadcasts the latest state only
+	AsyncTask(ENamedThreads::GameThread, [WeakOwner = Owner]()
+	{
+		if (UMoqPublisher* Publisher = WeakOwner.Get())
+		{
+			Publisher->UpdateBackpressureState();
+		}
+	});
+}
+
+void FMoqPublisherSendState::SetSendWindow(int32 InMaxQueuedObjects, int64 InMaxQueuedBytes)
+{
+	MaxQueuedObjects.store(FMath::Clamp(InMaxQueuedObjects, 1, Pending.Capacity()), std::memory_order_relaxed);
+	MaxQueuedBytes.store(FMath::Max<int64>(InMaxQueuedBytes, 0), std::memory_order_relaxed);
+}
+
+void FMoqPublisherSendState::ScheduleSend()
+{
+	// Only the publish that finds the state idle needs to wake the sender
+	if (!bScheduled.exchange(true, std::memory_order_acq_rel))
+	{
+		FMoqPublishSender::Get().Schedule(AsShared());
+	}
+}
+
+bool FMoqPublisherSendState::TryPublishFramed(TConstArrayView<uint8> Data, EMoqDeliveryMode DeliveryMode, FMoqResult& OutResult)
+{
+	if (!UsesEnvelopes())
+	{
+		return false;
+	}
+
+	// Each publish is framed on its own first: with its group ids, or escaped if the subscriber could mistake it for an envelope
+	FSharedBuffer Framed;
+	if (bGrouping.load(std::memory_order_relaxed))
+	{
+		Framed = FrameGroupObject(Data);
+	}
+	else if (Data[0] == MoqEnvelope::MagicByte)
+	{
+		Framed = FMoqPayloadPool::Get().Allocate(MoqEnvelope::HeaderSize + Data.Num(), [Data](uint8* Block)
+		{
+			Block[0] = MoqEnvelope::MagicByte;
+			Block[1] = static_cast<uint8>(MoqEnvelope::EKind::Raw);
+			FMemory::Memcpy(Block + MoqEnvelope::HeaderSize, Data.GetData(), Data.Num());
+		});
+	}
+
+	// Datagrams are never coalesced
+	if (DeliveryMode != EMoqDeliveryMode::Stream || !bCoalescing.load(std::memory_order_relaxed))
+	{
+		if (Framed.IsNull())
+		{
+			return false;
+		}
+		OutResult = SendFramed(MoveTemp(Framed), DeliveryMode);
+		return true;
+	}
+
+	const TConstArrayView<uint8> Packed = Framed.IsNull()
+		? Data
+		: TConstArrayView<uint8>(static_cast<const uint8*>(Framed.GetData()), static_cast<int32>(Framed.GetSize()));
+
+	FScopeLock Lock(&CoalesceLock);
+	OutResult = FMoqResult(true);
+
+	// A group start opens a new object, so the object carrying it is a point subscribers can start from
+	if (!Coalescer.IsEmpty() && (Coalescer.WouldOverflow(Packed.Num()) || MoqEnvelope::IsGroupStart(Packed)))
+	{
+		OutResult = SendFramed(Coalescer.Take(), EMoqDeliveryMode::Stream);
+	}
+
+	if (Coalescer.Add(Packed, FPlatformTime::Seconds()))
+	{
+		const FMoqResult FlushResult = SendFramed(Coalescer.Take(), EMoqDeliveryMode::Stream);
+		if (OutResult.bSuccess)
+		{
+			OutResult = FlushResult;
+		}
+	}
+	return true;
+}
+
+int64 FMoqPublisherSendState::StartGroup()
+{
+	FScopeLock Lock(&GroupLock);
+	CurrentGroupId = bGrouping.load(std::memory_order_relaxed) ? CurrentGroupId + 1 : 0;
+	NextObjectId = 0;
+	bGrouping.store(true, std::memory_order_relaxed);
+	return CurrentGroupId;
+}
+
+int64 FMoqPublisherSendState::GetCurrentGroupId() const
+{
+	FScopeLock Lock(&GroupLock);
+	return bGrouping.load(std::memory_order_relaxed) ? CurrentGroupId : INDEX_NONE;
+}
+
+FSharedBuffer FMoqPublisherSendState::FrameGroupObject(TConstArrayView<uint8> Data)
+{
+	int64 GroupId;
+	int64 ObjectId;
+	{
+		FScopeLock Lock(&GroupLock);
+		GroupId = CurrentGroupId;
+		ObjectId = NextObjectId++;
+	}
+
+	TArray<uint8> Header;
+	Header.Reserve(MoqEnvelope::HeaderSize + 20);
+	MoqEnvelope::WriteHeader(Header, MoqEnvelope::EKind::Grouped);
+	MoqEnvelope::WriteVarint(Header, GroupId);
+	MoqEnvelope::WriteVarint(Header, ObjectId);
+
+	return FMoqPayloadPool::Get().Allocate(Header.Num() + Data.Num(), [&Header, Data](uint8* Block)
+	{
+		FMemory::Memcpy(Block, Header.GetData(), Header.Num());
+		FMemory::Memcpy(Block + Header.Num(), Data.GetData(), Data.Num());
+	});
+}
+
+FMoqResult FMoqPublisherSendState::FlushCoalesced()
+{
+	FScopeLock Lock(&CoalesceLock);
+	if (Coalescer.IsEmpty())
+	{
+		return FMoqResult(true);
+	}
+	return SendFramed(Coalescer.Take(), EMoqDeliveryMode::Stream);
+}
+
+void FMoqPublisherSendState::SetCoalescing(bool bEnabled, int32 MaxBytes, float MaxDelayMs)
+{
+	check(IsInGameThread());
+
+	{
+		FScopeLock Lock(&CoalesceLock);
+		Coalescer.Configure(MaxBytes, MaxDelayMs / 1000.0);
+	}
+
+	if (bEnabled && !EndFrameHandle.IsValid())
+	{
+		EndFrameHandle = FCoreDelegates::OnEndFrame.AddSP(AsShared(), &FMoqPublisherSendState::OnEndFrame);
+	}
+	else if (!bEnabled && EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+
+	bCoalescing.store(bEnabled, std::memory_order_relaxed);
+
+	// Publishes buffered before coalescing was turned off must not wait for a flush that never comes
+	if (!bEnabled)
+	{
+		FlushCoalesced();
+	}
+}
+
+void FMoqPublisherSendState::OnEndFrame()
+{
+	const FMoqResult Result = FlushCoalesced();
+	if (!Result.bSuccess)
+	{
+		if (UMoqPublisher* Publisher = Owner.Get())
+		{
+			Publisher->OnPublishFailed.Broadcast(Result.ErrorMessage);
+		}
+	}
+}
+
+FMoqResult FMoqPublisherSendState::SendFramed(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode)
+{
+	if (ShouldQueue())
+	{
+		return Enqueue(MoveTemp(Payload), DeliveryMode);
+	}
+
+	return PublishNow(static_cast<const uint8*>(Payload.GetData()), static_cast<int64>(Payload.GetSize()), DeliveryMode);
+}
+
+double FMoqPublisherSendState::AcquirePacing(int64 Bytes)
+{
+	if (!IsPaced())
+	{
+		return 0.0;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	double WaitSeconds = RateLimiter.GetWaitSeconds(Bytes, Now);
+	if (ClientRateLimiter.IsValid())
+	{
+		WaitSeconds = FMath::Max(WaitSeconds, ClientRateLimiter->GetWaitSeconds(Bytes, Now));
+	}
+	if (WaitSeconds > 0.0)
+	{
+		return WaitSeconds;
+	}
+
+	RateLimiter.Consume(Bytes, Now);
+	if (ClientRateLimiter.IsValid())
+	{
+		ClientRateLimiter->Consume(Bytes, Now);
+	}
+	return 0.0;
+}
+
+FMoqPublisherSendState::FSendPass FMoqPublisherSendState::SendPending(int32 MaxObjects)
+{
+	// Clear first so a publish racing with this drain schedules another one instead of being stranded; the
+	// acquire half makes every object enqueued before the clear visible to the drain below
+	bScheduled.exchange(false, std::memory_order_acq_rel);
+
+	FSendPass Pass;
+	int32 NumSentThisPass = 0;
+	while (true)
+	{
+		if (NumSentThisPass >= MaxObjects)
+		{
+			// Let the sender look for more urgent publishers; a publish that already rescheduled this state will resume it
+			Pass.bMorePending = !bScheduled.exchange(true, std::memory_order_acq_rel);
+			return Pass;
+		}
+
+		if (!HeldObject.IsSet())
+		{
+			FPendingObject Next;
+			if (!Pending.TryDequeue(Next))
+			{
+				break;
+			}
+			// Leaves the window as soon as it leaves the ring, so producers can always evict what is left to make room
+			ReleaseWindow(Next);
+			NumHeld.store(1, std::memory_order_relaxed);
+			HeldBytes.store(static_cast<int64>(Next.Payload.GetSize()), std::memory_order_relaxed);
+			HeldObject.Emplace(MoveTemp(Next));
+			bHeldObjectDeferred = false;
+		}
+
+		// An object that waited behind more urgent tracks for longer than it is useful is discarded instead of sent late
+		const int64 MaxDelayUs = MaxQueueDelayUs.load(std::memory_order_relaxed);
+		if (MaxDelayUs > 0 && (FPlatformTime::Seconds() - HeldObject->EnqueueTime) * 1000000.0 > MaxDelayUs)
+		{
+			ResetHeldObject();
+			NumExpired.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+
+		const int64 Size = static_cast<int64>(HeldObject->Payload.GetSize());
+		const double WaitSeconds = AcquirePacing(Size);
+		if (WaitSeconds > 0.0)
+		{
+			if (!bHeldObjectDeferred)
+			{
+				bHeldObjectDeferred = true;
+				NumDeferred.fetch_add(1, std::memory_order_relaxed);
+				DeferredBytes.fetch_add(Size, std::memory_order_relaxed);
+				if (ClientRateLimiter.IsValid())
+				{
+					ClientRateLimiter->RecordDeferred(Size);
+				}
+			}
+
+			// A publish that already put this state back on the ready queue will retry it; otherwise the sender parks it
+			if (!bScheduled.exchange(true, std::memory_order_acq_rel))
+			{
+				Pass.WaitSeconds = WaitSeconds;
+			}
+			return Pass;
+		}
+
+		FPendingObject Object = MoveTemp(HeldObject.GetValue());
+		ResetHeldObject();
+
+		// Queued publishes already returned success to their caller, so failures can only be reported through the event
+		const FMoqResult Result = PublishNow(static_cast<const uint8*>(Object.Payload.GetData()), static_cast<int64>(Object.Payload.GetSize()), Object.DeliveryMode);
+		if (!Result.bSuccess)
+		{
+			AsyncTask(ENamedThreads::GameThread, [WeakOwner = Owner, ErrorMessage = Result.ErrorMessage]()
+			{
+				if (UMoqPublisher* Publisher = WeakOwner.Get())
+				{
+					Publisher->OnPublishFailed.Broadcast(ErrorMessage);
+				}
+			});
+		}
+		Object.Payload.Reset();
+		++NumSentThisPass;
+
+		const int64 LatencyUs = static_cast<int64>((FPlatformTime::Seconds() - Object.EnqueueTime) * 1000000.0);
+		NumTimed.fetch_add(1, std::memory_order_relaxed);
+		TotalLatencyUs.fetch_add(LatencyUs, std::memory_order_relaxed);
+		int64 MaxLatency = MaxLatencyUs.load(std::memory_order_relaxed);
+		while (LatencyUs > MaxLatency && !MaxLatencyUs.compare_exchange_weak(MaxLatency, LatencyUs, std::memory_order_relaxed))
+		{
+		}
+	}
+	return Pass;
+}
+
+void FMoqPublisherSendState::Close()
+{
+	if (EndFrameHandle.IsValid())
+	{
+		FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+		EndFrameHandle.Reset();
+	}
+	FlushCoalesced();
+
+	bClosed.store(true, std::memory_order_release);
+}
+
+FMoqPublisherStats FMoqPublisherSendState::GetStats() const
+{
+	FMoqPublisherStats Stats;
+	Stats.QueuedObjects = FMath::Max(NumQueued.load(std::memory_order_relaxed), 0) + NumHeld.load(std::memory_order_relaxed);
+	Stats.PeakQueuedObjects = PeakQueued.load(std::memory_order_relaxed);
+	Stats.QueuedBytes = FMath::Max<int64>(QueuedBytes.load(std::memory_order_relaxed), 0) + HeldBytes.load(std::memory_order_relaxed);
+	Stats.bBackpressured = IsBackpressured();
+	{
+		FScopeLock Lock(&CoalesceLock);
+		Stats.CoalescedObjects = Coalescer.GetNumCoalesced();
+	}
+	Stats.CompressedObjects = NumCompressed.load(std::memory_order_relaxed);
+	Stats.UncompressedBytes = BytesBeforeCompression.load(std::memory_order_relaxed);
+	Stats.CompressedBytes = BytesAfterCompression.load(std::memory_order_relaxed);
+	Stats.CompressionTimeMs = static_cast<float>(CompressionCycles.load(std::memory_order_relaxed) * FPlatformTime::GetSecondsPerCycle64() * 1000.0);
+	{
+		FScopeLock Lock(&DeltaLock);
+		Stats.KeyframeObjects = DeltaEncoder.GetNumKeyframes();
+		Stats.DeltaObjects = DeltaEncoder.GetNumDeltas();
+		if (Stats.KeyframeObjects > 0)
+		{
+			Stats.AverageKeyframeInterval = static_cast<float>(static_cast<double>(Stats.KeyframeObjects + Stats.DeltaObjects) / Stats.KeyframeObjects);
+		}
+		if (DeltaEncoder.GetBytesIn() > 0)
+		{
+			Stats.DeltaRatio = static_cast<float>(static_cast<double>(DeltaEncoder.GetBytesOut()) / DeltaEncoder.GetBytesIn());
+		}
+	}
+	Stats.SentObjects = NumSent.load(std::memory_order_relaxed);
+	Stats.SentBytes = NumSentBytes.load(std::memory_order_relaxed);
+	Stats.DeferredObjects = NumDeferred.load(std::memory_order_relaxed);
+	Stats.DeferredBytes = DeferredBytes.load(std::memory_order_relaxed);
+	Stats.FragmentedObjects = NumFragmented.load(std::memory_order_relaxed);
+	Stats.SentFragments = NumFragmentsSent.load(std::memory_order_relaxed);
+	Stats.FecParityObjects = NumFecParity.load(std::memory_order_relaxed);
+	Stats.FecParityBytes = FecParityBytes.load(std::memory_order_relaxed);
+	Stats.FailedObjects = NumFailed.load(std::memory_order_relaxed);
+	Stats.DroppedObjects = NumDropped.load(std::memory_order_relaxed);
+	Stats.ExpiredObjects = NumExpired.load(std::memory_order_relaxed);
+
+	const int64 Timed = NumTimed.load(std::memory_order_relaxed);
+	if (Timed > 0)
+	{
+		Stats.AverageSendLatencyMs = static_cast<float>(TotalLatencyUs.load(std::memory_order_relaxed) / static_cast<double>(Timed) / 1000.0);
+	}
+	Stats.MaxSendLatencyMs = static_cast<float>(MaxLatencyUs.load(std::memory_order_relaxed) / 1000.0);
+	return Stats;
+}
+
+void FMoqPublisherSendState::SetCompression(EMoqCompression Codec, int32 MinBytes, TConstArrayView<uint8> Dictionary)
+{
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> NewDictionary;
+	if (Codec == EMoqCompression::ZlibDictionary && Dictionary.Num() > 0)
+	{
+		NewDictionary = MakeShared<const TArray<uint8>, ESPMode::ThreadSafe>(Dictionary);
+	}
+
+	{
+		FScopeLock Lock(&CompressionLock);
+		CompressionDictionary = MoveTemp(NewDictionary);
+		CompressionDictionaryId = CompressionDictionary.IsValid() ? MoqCompression::GetDictionaryId(*CompressionDictionary) : 0;
+	}
+
+	CompressionMinBytes.store(FMath::Max(MinBytes, 0), std::memory_order_relaxed);
+	Compression.store(Codec, std::memory_order_relaxed);
+}
+
+bool FMoqPublisherSendState::CompressObject(EMoqCompression Codec, TConstArrayView<uint8> Data, TArray<uint8>& Out)
+{
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> Dictionary;
+	uint32 DictionaryId = 0;
+	{
+		FScopeLock Lock(&CompressionLock);
+		Dictionary = CompressionDictionary;
+		DictionaryId = CompressionDictionaryId;
+	}
+
+	Out.Reset();
+	MoqEnvelope::WriteHeader(Out, MoqEnvelope::EKind::Compressed);
+	Out.Add(static_cast<uint8>(Codec));
+	MoqEnvelope::WriteVarint(Out, DictionaryId);
+	MoqEnvelope::WriteVarint(Out, Data.Num());
+	const int32 HeaderBytes = Out.Num();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const bool bCompressed = MoqCompression::Compress(Codec, Data, Dictionary.IsValid() ? TConstArrayView<uint8>(*Dictionary) : TConstArrayView<uint8>(), Out);
+	CompressionCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+
+	// The envelope header has to pay for itself too
+	if (!bCompressed || Out.Num() >= Data.Num() || Out.Num() == HeaderBytes)
+	{
+		return false;
+	}
+
+	NumCompressed.fetch_add(1, std::memory_order_relaxed);
+	BytesBeforeCompression.fetch_add(Data.Num(), std::memory_order_relaxed);
+	BytesAfterCompression.fetch_add(Out.Num(), std::memory_order_relaxed);
+	return true;
+}
+
+void FMoqPublisherSendState::SetDeltaEncoding(bool bEnabled, int32 KeyframeInterval, float KeyframeIntervalMs)
+{
+	FScopeLock Lock(&DeltaLock);
+	DeltaEncoder.Configure(KeyframeInterval, KeyframeIntervalMs / 1000.0);
+	if (bEnabled && !bDeltaEncoding.load(std::memory_order_relaxed))
+	{
+		DeltaEncoder.RequestKeyframe();
+	}
+	bDeltaEncoding.store(bEnabled, std::memory_order_relaxed);
+}
+
+void FMoqPublisherSendState::SetFragmentation(bool bEnabled, int32 MaxDatagramSize)
+{
+	MaxDatagramBytes.store(FMath::Max(MaxDatagramSize, 64), std::memory_order_relaxed);
+	bFragmenting.store(bEnabled, std::memory_order_relaxed);
+}
+
+void FMoqPublisherSendState::SetFec(int32 BlockSize)
+{
+	FScopeLock Lock(&FecLock);
+	FecEncoder.SetBlockSize(BlockSize);
+	bFec.store(FecEncoder.IsEnabled(), std::memory_order_relaxed);
+}
+
+void FMoqPublisherSendState::SetAggregation(TSharedPtr<FMoqDatagramAggregator, ESPMode::ThreadSafe> InAggregator, uint32 InRouteId)
+{
+	Aggregator = MoveTemp(InAggregator);
+	AggregationRouteId = InRouteId;
+}
+
+void FMoqPublisherSendState::RequestKeyframe()
+{
+	FScopeLock Lock(&DeltaLock);
+	DeltaEncoder.RequestKeyframe();
+}
+
+bool FMoqPublisherSendState::SendObject(const uint8* Data, int64 Size, MoqDeliveryMode NativeDeliveryMode, FString* OutError)
+{
+	if (!bDeltaEncoding.load(std::memory_order_relaxed))
+	{
+		return SendEncoded(Data, Size, NativeDeliveryMode, OutError);
+	}
+
+	FScopeLock Lock(&DeltaLock);
+
+	// A subscriber joining at a group start must be able to decode it without anything sent before
+	if (StartsGroup(MakeArrayView(Data, static_cast<int32>(Size))))
+	{
+		DeltaEncoder.RequestKeyframe();
+	}
+
+	static thread_local TArray<uint8> DeltaScratch;
+	DeltaEncoder.Encode(MakeArrayView(Data, static_cast<int32>(Size)), FPlatformTime::Seconds(), DeltaScratch);
+
+	if (SendEncoded(DeltaScratch.GetData(), DeltaScratch.Num(), NativeDeliveryMode, OutError))
+	{
+		return true;
+	}
+
+	// Subscribers never see this object, so the next one must not be a delta against it
+	DeltaEncoder.RequestKeyframe();
+	return false;
+}
+
+bool FMoqPublisherSendState::SendEncoded(const uint8* Data, int64 Size, MoqDeliveryMode NativeDeliveryMode, FString* OutError)
+{
+	// Compress at the last moment, so coalesced objects are compressed as a whole and async ones on the sender thread
+	const EMoqCompression Codec = Compression.load(std::memory_order_relaxed);
+	if (Codec != EMoqCompression::None && Size >= CompressionMinBytes.load(std::memory_order_relaxed))
+	{
+		static thread_local TArray<uint8> CompressedScratch;
+		if (CompressObject(Codec, MakeArrayView(Data, static_cast<int32>(Size)), CompressedScratch))
+		{
+			Data = CompressedScratch.GetData();
+			Size = CompressedScratch.Num();
+		}
+	}
+
+	// Small datagrams share the client's aggregate datagrams. FEC tracks keep their own, so their parity still covers
+	// every object; so do delta-encoded and grouped tracks, whose decoders expect their objects in their own order
+	if (NativeDeliveryMode == MOQ_DELIVERY_DATAGRAM && Aggregator.IsValid() && !bFec.load(std::memory_order_relaxed)
+		&& !bDeltaEncoding.load(std::memory_order_relaxed) && !bGrouping.load(std::memory_order_relaxed)
+		&& Aggregator->TryAdd(AggregationRouteId, MakeArrayView(Data, static_cast<int32>(Size))))
+	{
+		NumSent.fetch_add(1, std::memory_order_relaxed);
+		NumSentBytes.fetch_add(Size, std::memory_order_relaxed);
+		return true;
+	}
+
+	// Fragment last of all: the pieces of an object are only ever reassembled, never decoded on their own
+	if (NativeDeliveryMode == MOQ_DELIVERY_DATAGRAM && bFragmenting.load(std::memory_order_relaxed) && Size > GetMaxDatagramPayload())
+	{
+		return SendFragmented(Data, Size, OutError);
+	}
+
+	int64 WireBytes = Size;
+	MoqResult Result = (NativeDeliveryMode == MOQ_DELIVERY_DATAGRAM)
+		? PublishDatagram(Data, Size, WireBytes)
+		: moq_publish_data(Handle, Data, static_cast<size_t>(Size), NativeDeliveryMode);
+
+	if (Result.code == MOQ_OK)
+	{
+		NumSent.fetch_add(1, std::memory_order_relaxed);
+		NumSentBytes.fetch_add(WireBytes, std::memory_order_relaxed);
+		return true;
+	}
+
+	NumFailed.fetch_add(1, std::memory_order_relaxed);
+
+	if (OutError)
+	{
+		*OutError = UTF8_TO_TCHAR(Result.message);
+	}
+	moq_free_str(Result.message);
+	return false;
+}
+
+bool FMoqPublisherSendState::SendFragmented(const uint8* Data, int64 Size, FString* OutError)
+{
+	const TConstArrayView<uint8> Object = MakeArrayView(Data, static_cast<int32>(Size));
+	const uint64 ObjectId = NextFragmentedId.fetch_add(1, std::memory_order_relaxed);
+	const int32 Count = MoqFragment::GetFragmentCount(Size, ObjectId, GetMaxDatagramPayload());
+
+	static thread_local TArray<uint8> FragmentScratch;
+	int64 SentBytes = 0;
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		MoqFragment::WriteFragment(Object, ObjectId, Index, Count, FragmentScratch);
+		int64 WireBytes = FragmentScratch.Num();
+		MoqResult Result = PublishDatagram(FragmentScratch.GetData(), FragmentScratch.Num(), WireBytes);
+		if (Result.code != MOQ_OK)
+		{
+			// The rest would only waste bandwidth: the subscriber discards the object without this fragment
+			NumFailed.fetch_add(1, std::memory_order_relaxed);
+			if (OutError)
+			{
+				*OutError = UTF8_TO_TCHAR(Result.message);
+			}
+			moq_free_str(Result.message);
+			return false;
+		}
+
+		SentBytes += WireBytes;
+		NumFragmentsSent.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	NumFragmented.fetch_add(1, std::memory_order_relaxed);
+	NumSent.fetch_add(1, std::memory_order_relaxed);
+	NumSentBytes.fetch_add(SentBytes, std::memory_order_relaxed);
+	return true;
+}
+
+MoqResult FMoqPublisherSendState::PublishDatagram(const uint8* Data, int64 Size, int64& OutWireBytes)
+{
+	if (!bFec.load(std::memory_order_relaxed))
+	{
+		return moq_publish_data(Handle, Data, static_cast<size_t>(Size), MOQ_DELIVERY_DATAGRAM);
+	}
+
+	// Held until the parity is out, so a block's datagrams and its parity are not interleaved with another block's
+	FScopeLock Lock(&FecLock);
+	if (!FecEncoder.IsEnabled())
+	{
+		return moq_publish_data(Handle, Data, static_cast<size_t>(Size), MOQ_DELIVERY_DATAGRAM);
+	}
+
+	static thread_local TArray<uint8> FecScratch;
+	FecEncoder.WrapData(MakeArrayView(Data, static_cast<int32>(Size)), FecScratch);
+	OutWireBytes = FecScratch.Num();
+	MoqResult Result = moq_publish_data(Handle, FecScratch.GetData(), static_cast<size_t>(FecScratch.Num()), MOQ_DELIVERY_DATAGRAM);
+
+	// A datagram moq-ffi refused still counts towards its block: the parity lets the subscriber rebuild it
+	if (FecEncoder.TakeParity(FecScratch))
+	{
+		MoqResult ParityResult = moq_publish_data(Handle, FecScratch.GetData(), static_cast<size_t>(FecScratch.Num()), MOQ_DELIVERY_DATAGRAM);
+		if (ParityResult.code == MOQ_OK)
+		{
+			NumFecParity.fetch_add(1, std::memory_order_relaxed);
+			FecParityBytes.fetch_add(FecScratch.Num(), std::memory_order_relaxed);
+		}
+		else
+		{
+			moq_free_str(ParityResult.message);
+		}
+	}
+	return Result;
+}
+
+FMoqPublishSender& FMoqPublishSender::Get()
+{
+	static FMoqPublishSender Instance;
+	return Instance;
+}
+
+void FMoqPublishSender::Schedule(TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State)
+{
+	EnsureThread();
+
+	ReadyStates.Enqueue(MoveTemp(State));
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+void FMoqPublishSender::EnsureThread()
+{
+	if (bRunning.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	FScopeLock Lock(&ThreadLock);
+	if (!bRunning.load(std::memory_order_relaxed) && !bStopping.load(std::memory_order_relaxed))
+	{
+		WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+		Thread = FRunnableThread::Create(this, TEXT("MoqPublishSender"), 0, TPri_AboveNormal);
+		bRunning.store(true, std::memory_order_release);
+	}
+}
+
+void FMoqPublishSender::Shutdown()
+{
+	FScopeLock Lock(&ThreadLock);
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WakeEvent)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+		WakeEvent = nullptr;
+	}
+
+	// Release publishers that were still waiting; their handles are destroyed with them
+	while (ReadyStates.Dequeue())
+	{
+	}
+
+	bRunning.store(false, std::memory_order_release);
+}
+
+void FMoqPublishSender::SetPaused(bool bInPaused)
+{
+	bPaused.store(bInPaused, std::memory_order_relaxed);
+
+	// Wait out a pass that started before the flag changed
+	{
+		FScopeLock PassScope(&PassLock);
+	}
+
+	if (!bInPaused && WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+uint32 FMoqPublishSender::Run()
+{
+	struct FParkedState
+	{
+		double DueTime;
+		TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe> State;
+
+		bool operator<(const FParkedState& Other) const { return DueTime < Other.DueTime; }
+	};
+
+	// Publishers waiting for rate limit tokens, earliest first, and publishers with objects to send,
+	// most urgent first (this thread only)
+	TArray<FParkedState> Parked;
+	TMoqSendOrder<TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe>> Runnable;
+
+	auto MakeRunnable = [&Runnable](TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe>&& State)
+	{
+		const uint8 Priority = State->GetPriority();
+		Runnable.Push(Priority, MoveTemp(State));
+	};
+
+	while (!bStopping.load(std::memory_order_acquire))
+	{
+		// How long to sleep once the pass is over, MAX_uint32 until woken
+		uint32 WaitMs = 0;
+		{
+			FScopeLock PassScope(&PassLock);
+			if (bPaused.load(std::memory_order_relaxed))
+			{
+				WaitMs = MAX_uint32;
+			}
+			else
+			{
+				const double Now = FPlatformTime::Seconds();
+				while (Parked.Num() > 0 && Parked.HeapTop().DueTime <= Now)
+				{
+					FParkedState Due;
+					Parked.HeapPop(Due, EAllowShrinking::No);
+					MakeRunnable(MoveTemp(Due.State));
+				}
+
+				while (TOptional<TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe>> State = ReadyStates.Dequeue())
+				{
+					MakeRunnable(MoveTemp(*State));
+				}
+
+				// Send a slice of the most urgent publisher, then look again, so a newly ready
+				// high-priority track never waits behind more than one slice of bulk traffic
+				if (Runnable.Num() > 0)
+				{
+					TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe> Next = Runnable.Pop();
+
+					const FMoqPublisherSendState::FSendPass Pass = Next->SendPending(SendSliceObjects);
+					if (Pass.WaitSeconds > 0.0)
+					{
+						Parked.HeapPush(FParkedState{ FPlatformTime::Seconds() + Pass.WaitSeconds, MoveTemp(Next) });
+					}
+					else if (Pass.bMorePending)
+					{
+						MakeRunnable(MoveTemp(Next));
+					}
+				}
+				else if (Parked.Num() > 0)
+				{
+					// Round up so the tokens have refilled by the time the thread wakes
+					const double SleepSeconds = Parked.HeapTop().DueTime - FPlatformTime::Seconds();
+					WaitMs = static_cast<uint32>(FMath::CeilToInt(FMath::Max(SleepSeconds, 0.0) * 1000.0));
+				}
+				else
+				{
+					WaitMs = MAX_uint32;
+				}
+			}
+		}
+
+		if (WaitMs > 0)
+		{
+			WakeEvent->Wait(WaitMs);
+		}
+	}
+	return 0;
+}
+
+void FMoqPublishSender::Stop()
+{
+	bStopping.store(true, std::memory_order_release);
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
@@ -0,0 +1,419 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/MpscQueue.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "Memory/SharedBuffer.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "moq_ffi.h"
+#include "MoqDeltaEncoder.h"
+#include "MoqFec.h"
+#include "MoqPublishCoalescer.h"
+#include "MoqRateLimiter.h"
+#include "MoqReceiveQueue.h"
+#include "MoqTypes.h"
+#include <atomic>
+
+class FEvent;
+class FMoqDatagramAggregator;
+class FRunnableThread;
+class UMoqPublisher;
+
+/**
+ * Native side of a UMoqPublisher: owns the moq-ffi publisher handle and the async send queue.
+ *
+ * The state is shared between the UObject and the sender thread, so the handle is destroyed only
+ * once neither uses it any more, and objects queued before the publisher is destroyed are still sent.
+ * The queue is a bounded ring so producers can evict queued objects themselves when the send window
+ * (objects and bytes) is full and the backpressure policy asks for it. With coalescing on, stream
+ * publishes are packed into one enveloped object per frame before they reach either path; delta
+ * encoding and compression are applied, in that order, to each object as it is handed to moq-ffi.
+ * A rate limit (the publisher's own, or its client's aggregate one) makes every publish queue, and
+ * the sender thread releases the queue only as fast as the token buckets allow. Small datagram
+ * objects go to the client's datagram aggregator, when it is enabled, instead of their own track.
+ */
+class FMoqPublisherSendState : public TSharedFromThis<FMoqPublisherSendState, ESPMode::ThreadSafe>
+{
+public:
+	/** @param InClientRateLimiter Aggregate limit shared with the other publishers of the client, if any */
+	FMoqPublisherSendState(MoqPublisher* InHandle, UMoqPublisher* InOwner, const FMoqPublishOptions& InOptions,
+		TSharedPtr<FMoqRateLimiter, ESPMode::ThreadSafe> InClientRateLimiter = nullptr);
+	~FMoqPublisherSendState();
+
+	/** Call moq_publish_data on the calling thread */
+	FMoqResult PublishNow(const uint8* Data, int64 Size, EMoqDeliveryMode DeliveryMode);
+
+	/** Publish every object on the calling thread with one mode conversion, keeping only the first error */
+	FMoqBatchPublishResult PublishBatchNow(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode);
+
+	/**
+	 * Queue a payload for the sender thread, applying the backpressure policy if the window is full.
+	 * Safe to call from any thread.
+	 * @return Failure if the publish was refused (EMoqBackpressurePolicy::FailFast, or the publisher is closed)
+	 *         or the object itself was dropped (EMoqBackpressurePolicy::DropNewest)
+	 */
+	FMoqResult Enqueue(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode);
+
+	/** Queue every object for the sender thread, waking it once for the whole batch */
+	FMoqBatchPublishResult EnqueueBatch(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode);
+
+	/**
+	 * Route a publish through the envelope stage when coalescing is on: stream publishes are buffered,
+	 * other publishes that could be mistaken for an envelope are wrapped. Safe to call from any thread.
+	 * @return False if the publish needs no framing and should take the normal path
+	 */
+	bool TryPublishFramed(TConstArrayView<uint8> Data, EMoqDeliveryMode DeliveryMode, FMoqResult& OutResult);
+
+	/**
+	 * Start a new MoQ group: every publish from now on carries the group id and its object id within
+	 * the group, and the next object sent is a delta keyframe. Safe to call from any thread.
+	 * @return Id of the new group; groups are numbered from 0
+	 */
+	int64 StartGroup();
+
+	/** Id of the group being published, INDEX_NONE before the first StartGroup */
+	int64 GetCurrentGroupId() const;
+
+	/** Send everything buffered for coalescing as one object. Safe to call from any thread. */
+	FMoqResult FlushCoalesced();
+
+	/** Turn coalescing on or off and hook the end-of-frame flush (game thread) */
+	void SetCoalescing(bool bEnabled, int32 MaxBytes, float MaxDelayMs);
+
+	bool IsCoalescing() const { return bCoalescing.load(std::memory_order_relaxed); }
+
+	/** Set the codec applied to every object just before it is handed to moq-ffi. Safe to call at any time. */
+	void SetCompression(EMoqCompression Codec, int32 MinBytes, TConstArrayView<uint8> Dictionary);
+
+	/** Turn delta encoding on or off; the first object after turning it on is a keyframe. Safe to call at any time. */
+	void SetDeltaEncoding(bool bEnabled, int32 KeyframeInterval, float KeyframeIntervalMs);
+
+	/** Split datagram objects above MaxDatagramSize bytes into fragments. Safe to call at any time. */
+	void SetFragmentation(bool bEnabled, int32 MaxDatagramSize);
+
+	/** Send an XOR parity datagram after every BlockSize datagrams, 0 to stop. Safe to call at any time. */
+	void SetFec(int32 BlockSize);
+
+	/**
+	 * Hand small datagram objects to the client's aggregator while it is enabled, tagged with RouteId
+	 * (MoqAggregation::GetRouteId of this track). Call before the first publish.
+	 */
+	void SetAggregation(TSharedPtr<FMoqDatagramAggregator, ESPMode::ThreadSafe> InAggregator, uint32 InRouteId);
+
+	/** Make the next object sent a keyframe. Safe to call from any thread. */
+	void RequestKeyframe();
+
+	/** True if objects may reach the wire framed, so plain payloads that look like an envelope must be escaped */
+	bool UsesEnvelopes() const
+	{
+		return IsCoalescing() || bGrouping.load(std::memory_order_relaxed) || bDeltaEncoding.load(std::memory_order_relaxed)
+			|| Compression.load(std::memory_order_relaxed) != EMoqCompression::None || bFragmenting.load(std::memory_order_relaxed)
+			|| bFec.load(std::memory_order_relaxed);
+	}
+
+	/** How a SendPending call ended, when it did not drain the queue */
+	struct FSendPass
+	{
+		/** The object budget ran out; the caller must call SendPending again */
+		bool bMorePending = false;
+
+		/** Pacing stopped the drain; the caller must call SendPending again after this long */
+		double WaitSeconds = 0.0;
+	};
+
+	/**
+	 * Send up to MaxObjects queued objects, as far as the rate limits allow (sender thread only).
+	 * Objects older than the maximum queue delay are discarded instead of sent.
+	 */
+	FSendPass SendPending(int32 MaxObjects);
+
+	/** Reject further publishes; anything already queued or buffered for coalescing is still sent (game thread) */
+	void Close();
+
+	void SetMode(EMoqPublishMode InMode) { Mode.store(InMode, std::memory_order_relaxed); }
+	EMoqPublishMode GetMode() const { return Mode.load(std::memory_order_relaxed); }
+
+	/** Update the send window; the object limit cannot grow past the queue allocated at creation */
+	void SetSendWindow(int32 InMaxQueuedObjects, int64 InMaxQueuedBytes);
+
+	void SetBackpressurePolicy(EMoqBackpressurePolicy InPolicy) { Policy.store(InPolicy, std::memory_order_relaxed); }
+
+	/** Sender thread priority; lower values are sent first */
+	void SetPriority(uint8 InPriority) { Priority.store(InPriority, std::memory_order_relaxed); }
+	uint8 GetPriority() const { return Priority.load(std::memory_order_relaxed); }
+
+	/** Age at which queued objects are discarded instead of sent, 0 to always send them */
+	void SetMaxQueueDelay(float MaxDelayMs) { MaxQueueDelayUs.store(static_cast<int64>(FMath::Max(MaxDelayMs, 0.0f) * 1000.0f), std::memory_order_relaxed); }
+
+	void SetRateLimit(const FMoqRateLimit& Limit) { RateLimiter.SetLimit(Limit); }
+
+	/** True if a rate limit applies, so publishes must go through the queue whatever the mode */
+	bool IsPaced() const { return RateLimiter.IsLimited() || (ClientRateLimiter.IsValid() && ClientRateLimiter->IsLimited()); }
+
+	/** True if publishes are queued for the sender thread rather than sent on the calling thread */
+	bool ShouldQueue() const { return GetMode() == EMoqPublishMode::Async || IsPaced(); }
+
+	bool IsBackpressured() const { return bBackpressured.load(std::memory_order_acquire); }
+
+	FMoqPublisherStats GetStats() const;
+
+private:
+	struct FPendingObject
+	{
+		FSharedBuffer Payload;
+		EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream;
+		double EnqueueTime = 0.0;
+	};
+
+	/**
+	 * Delta encode and compress an object as configured, call moq_publish_data and update the sent/failed counters.
+	 * @param OutError Receives the moq-ffi error text on failure; the string is only built when this is set
+	 */
+	bool SendObject(const uint8* Data, int64 Size, MoqDeliveryMode NativeDeliveryMode, FString* OutError);
+
+	/** SendObject after the delta stage */
+	bool SendEncoded(const uint8* Data, int64 Size, MoqDeliveryMode NativeDeliveryMode, FString* OutError);
+
+	/** Publish an object too large for one datagram as a series of fragment datagrams */
+	bool SendFragmented(const uint8* Data, int64 Size, FString* OutError);
+
+	/**
+	 * Call moq_publish_data for one datagram, wrapped for FEC and followed by its block's parity when enabled.
+	 * @param OutWireBytes Receives the size of the datagram as sent, parity not included
+	 */
+	MoqResult PublishDatagram(const uint8* Data, int64 Size, int64& OutWireBytes);
+
+	/** Largest object sent as a single datagram, leaving room for the FEC headers when FEC is on */
+	int32 GetMaxDatagramPayload() const
+	{
+		return MaxDatagramBytes.load(std::memory_order_relaxed) - (bFec.load(std::memory_order_relaxed) ? MoqFec::MaxOverhead : 0);
+	}
+
+	/** Flush the coalescing buffer at the end of every frame */
+	void OnEndFrame();
+
+	/** Copy a publish into a Grouped envelope with the next object id of the current group */
+	FSharedBuffer FrameGroupObject(TConstArrayView<uint8> Data);
+
+	/** Publish an object produced by the envelope stage according to the current mode */
+	FMoqResult SendFramed(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode);
+
+	/**
+	 * Build a compressed envelope for Data in Out.
+	 * @return False if compression would not make the object smaller
+	 */
+	bool CompressObject(EMoqCompression Codec, TConstArrayView<uint8> Data, TArray<uint8>& Out);
+
+	/** Reserve room in the send window, applying the backpressure policy, and push one payload without waking the sender */
+	FMoqResult TryEnqueueObject(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode);
+
+	/** Discard the oldest queued object to make room; false if the queue was already empty */
+	bool EvictOldest();
+
+	/** Remove a dequeued object from the window accounting */
+	void ReleaseWindow(const FPendingObject& Object);
+
+	/** Drop the held object, sent or expired, and its share of the queue stats (sender thread only) */
+	void ResetHeldObject();
+
+	/** Flip the backpressure flag and tell the owner on the game thread when it changes */
+	void SetBackpressured(bool bInBackpressured);
+
+	/** Wake the sender thread unless this state is already waiting for it */
+	void ScheduleSend();
+
+	/**
+	 * Take the rate limit tokens for an object about to be sent.
+	 * @return Seconds to wait first, in which case nothing was taken
+	 */
+	double AcquirePacing(int64 Bytes);
+
+	MoqPublisher* Handle;
+
+	/** Created on the game thread; only dereferenced there */
+	TWeakObjectPtr<UMoqPublisher> Owner;
+
+	TMoqBoundedRing<FPendingObject> Pending;
+
+	/**
+	 * Object dequeued but still waiting for rate limit tokens (sender thread only). It is already out of
+	 * the send window, so the backpressure policies only ever have to evict from the ring.
+	 */
+	TOptional<FPendingObject> HeldObject;
+	bool bHeldObjectDeferred = false;
+
+	/** The held object as counted in the queue stats */
+	std::atomic<int32> NumHeld{ 0 };
+	std::atomic<int64> HeldBytes{ 0 };
+
+	FMoqRateLimiter RateLimiter;
+	TSharedPtr<FMoqRateLimiter, ESPMode::ThreadSafe> ClientRateLimiter;
+
+	std::atomic<EMoqPublishMode> Mode;
+	std::atomic<EMoqBackpressurePolicy> Policy;
+	std::atomic<uint8> Priority;
+	std::atomic<int64> MaxQueueDelayUs{ 0 };
+	std::atomic<int32> MaxQueuedObjects;
+	std::atomic<int64> MaxQueuedBytes;
+
+	/** Set while this state is waiting in the sender's ready queue */
+	std::atomic<bool> bScheduled{ false };
+	std::atomic<bool> bClosed{ false };
+	std::atomic<bool> bBackpressured{ false };
+	std::atomic<bool> bCoalescing{ false };
+
+	/** Held while buffering and while sending a flush, so packed objects go out in publish order */
+	mutable FCriticalSection CoalesceLock;
+	FMoqPublishCoalescer Coalescer;
+
+	/** FCoreDelegates::OnEndFrame binding while coalescing (game thread only) */
+	FDelegateHandle EndFrameHandle;
+
+	/** Set by the first StartGroup; publishes are group-framed from then on */
+	std::atomic<bool> bGrouping{ false };
+	int64 CurrentGroupId = 0;
+	int64 NextObjectId = 0;
+	mutable FCriticalSection GroupLock;
+
+	std::atomic<bool> bDeltaEncoding{ false };
+
+	/** Held from delta encoding until the object is sent, so sequence numbers reach the wire in order */
+	mutable FCriticalSection DeltaLock;
+	FMoqDeltaEncoder DeltaEncoder;
+
+	std::atomic<EMoqCompression> Compression{ EMoqCompression::None };
+	std::atomic<int32> CompressionMinBytes{ 0 };
+
+	/** Preset dictionary and its wire id; replaced as a whole under CompressionLock */
+	TSharedPtr<const TArray<uint8>, ESPMode::ThreadSafe> CompressionDictionary;
+	uint32 CompressionDictionaryId = 0;
+	FCriticalSection CompressionLock;
+
+	std::atomic<int64> NumCompressed{ 0 };
+	std::atomic<int64> BytesBeforeCompression{ 0 };
+	std::atomic<int64> BytesAfterCompression{ 0 };
+	std::atomic<uint64> CompressionCycles{ 0 };
+
+	std::atomic<bool> bFragmenting{ false };
+	std::atomic<int32> MaxDatagramBytes{ 0 };
+	std::atomic<uint64> NextFragmentedId{ 0 };
+	std::atomic<int64> NumFragmented{ 0 };
+	std::atomic<int64> NumFragmentsSent{ 0 };
+
+	std::atomic<bool> bFec{ false };
+	FCriticalSection FecLock;
+	FMoqFecEncoder FecEncoder;
+	std::atomic<int64> NumFecParity{ 0 };
+	std::atomic<int64> FecParityBytes{ 0 };
+
+	/** Set once before the first publish */
+	TSharedPtr<FMoqDatagramAggregator, ESPMode::ThreadSafe> Aggregator;
+	uint32 AggregationRouteId = 0;
+
+	std::atomic<int32> NumQueued{ 0 };
+	std::atomic<int64> QueuedBytes{ 0 };
+	std::atomic<int32> PeakQueued{ 0 };
+	std::atomic<int64> NumSent{ 0 };
+	std::atomic<int64> NumSentBytes{ 0 };
+	std::atomic<int64> NumDeferred{ 0 };
+	std::atomic<int64> DeferredBytes{ 0 };
+	std::atomic<int64> NumFailed{ 0 };
+	std::atomic<int64> NumDropped{ 0 };
+	std::atomic<int64> NumExpired{ 0 };
+	std::atomic<int64> NumTimed{ 0 };
+	std::atomic<int64> TotalLatencyUs{ 0 };
+	std::atomic<int64> MaxLatencyUs{ 0 };
+};
+
+/**
+ * Ready list of the sender thread: lowest priority value first, then first come first served, so
+ * publishers of equal priority take turns when each is pushed back after its slice. Not thread safe.
+ */
+template <typename ItemType>
+class TMoqSendOrder
+{
+public:
+	void Push(uint8 Priority, ItemType Item)
+	{
+		Heap.HeapPush(FEntry{ Priority, NextOrder++, MoveTemp(Item) });
+	}
+
+	/** Remove the most urgent item; the list must not be empty */
+	ItemType Pop()
+	{
+		FEntry Top;
+		Heap.HeapPop(Top, EAllowShrinking::No);
+		return MoveTemp(Top.Item);
+	}
+
+	int32 Num() const { return Heap.Num(); }
+
+private:
+	struct FEntry
+	{
+		uint8 Priority = 0;
+		uint64 Order = 0;
+		ItemType Item;
+
+		bool operator<(const FEntry& Other) const
+		{
+			return Priority != Other.Priority ? Priority < Other.Priority : Order < Other.Order;
+		}
+	};
+
+	TArray<FEntry> Heap;
+	uint64 NextOrder = 0;
+};
+
+/**
+ * Module-wide sender thread for publishers in EMoqPublishMode::Async.
+ *
+ * Publishers with queued objects are pushed onto a lock-free ready queue and the thread is woken;
+ * it then sends from ready publishers a slice at a time, lowest priority value first, so the game
+ * thread never waits on moq-ffi and bulk tracks cannot hold back latency-critical ones. Publishers
+ * stopped by a rate limit are parked until their tokens refill, and the thread sleeps until the
+ * earliest of them is due. The thread is started on first use.
+ */
+class FMoqPublishSender : public FRunnable
+{
+public:
+	static FMoqPublishSender& Get();
+
+	/** Wake the sender thread for State. Safe to call from any thread. */
+	void Schedule(TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State);
+
+	/** Stop and join the thread (called from module shutdown) */
+	void Shutdown();
+
+	/**
+	 * Stop taking publishers off the ready queue, or start again. Returns once the thread is outside
+	 * its send pass, so automation tests can drive FMoqPublisherSendState::SendPending themselves.
+	 */
+	void SetPaused(bool bInPaused);
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	/** Objects sent from one publisher before the thread looks for a more urgent one */
+	static constexpr int32 SendSliceObjects = 8;
+
+	void EnsureThread();
+
+	TMpscQueue<TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe>> ReadyStates;
+
+	FCriticalSection ThreadLock;
+
+	/** Held by the thread for each pass of its loop, waits excluded */
+	FCriticalSection PassLock;
+	std::atomic<bool> bPaused{ false };
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WakeEvent = nullptr;
+	std::atomic<bool> bRunning{ false };
+	std::atomic<bool> bStopping{ false };
+};
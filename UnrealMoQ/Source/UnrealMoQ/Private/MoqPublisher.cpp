@@ -2,35 +2,170 @@
 
 #include "MoqPublisher.h"
 #include "MoqClient.h"
+#include "MoqPayloadPool.h"
+#include "MoqPublishSender.h"
+#include "MoqStructSerializer.h"
+#include "UObject/UnrealType.h"
 
 UMoqPublisher::UMoqPublisher()
-	: PublisherHandle(nullptr)
 {
 }
 
 UMoqPublisher::~UMoqPublisher()
 {
-	if (PublisherHandle)
-	{
-		moq_publisher_destroy(PublisherHandle);
-		PublisherHandle = nullptr;
-	}
 }
 
 void UMoqPublisher::BeginDestroy()
 {
-	if (PublisherHandle)
+	if (SendState)
 	{
-		moq_publisher_destroy(PublisherHandle);
-		PublisherHandle = nullptr;
+		// Objects already queued are still sent; the handle is destroyed once the sender thread lets go
+		SendState->Close();
+		SendState.Reset();
 	}
 
 	Super::BeginDestroy();
 }
 
+void UMoqPublisher::ApplyOptions(const FMoqPublishOptions& Options)
+{
+	PublishOptions = Options;
+
+	if (SendState)
+	{
+		SendState->SetMode(Options.Mode);
+		SendState->SetSendWindow(Options.MaxQueuedObjects, Options.MaxQueuedBytes);
+		SendState->SetBackpressurePolicy(Options.BackpressurePolicy);
+		SendState->SetRateLimit(Options.RateLimit);
+		SendState->SetPriority(Options.Priority);
+		SendState->SetMaxQueueDelay(Options.MaxQueueDelayMs);
+		SendState->SetCoalescing(Options.bCoalesce, Options.CoalesceMaxBytes, Options.CoalesceMaxDelayMs);
+		SendState->SetDeltaEncoding(Options.bDeltaEncoding, Options.KeyframeInterval, Options.KeyframeIntervalMs);
+		SendState->SetCompression(Options.Compression, Options.CompressionMinBytes, Options.CompressionDictionary);
+		SendState->SetFragmentation(Options.bFragmentDatagrams, Options.MaxDatagramSize);
+		SendState->SetFec(Options.FecBlockSize);
+	}
+}
+
 void UMoqPublisher::InitializeFromHandle(MoqPublisher* Handle)
 {
-	PublisherHandle = Handle;
+	if (SendState)
+	{
+		SendState->Close();
+		SendState.Reset();
+	}
+
+	if (Handle)
+	{
+		// Publishers created by a client share its aggregate rate limit and datagram aggregation
+		const UMoqClient* Client = GetTypedOuter<UMoqClient>();
+		SendState = MakeShared<FMoqPublisherSendState, ESPMode::ThreadSafe>(Handle, this, PublishOptions, Client ? Client->PublishRateLimiter : nullptr);
+		if (Client)
+		{
+			SendState->SetAggregation(Client->DatagramAggregator, AggregationRouteId);
+		}
+		if (PublishOptions.bCoalesce)
+		{
+			SendState->SetCoalescing(true, PublishOptions.CoalesceMaxBytes, PublishOptions.CoalesceMaxDelayMs);
+		}
+		SendState->SetDeltaEncoding(PublishOptions.bDeltaEncoding, PublishOptions.KeyframeInterval, PublishOptions.KeyframeIntervalMs);
+		SendState->SetCompression(PublishOptions.Compression, PublishOptions.CompressionMinBytes, PublishOptions.CompressionDictionary);
+		SendState->SetFragmentation(PublishOptions.bFragmentDatagrams, PublishOptions.MaxDatagramSize);
+		SendState->SetFec(PublishOptions.FecBlockSize);
+	}
+}
+
+void UMoqPublisher::SetPublishMode(EMoqPublishMode Mode)
+{
+	PublishOptions.Mode = Mode;
+
+	if (SendState)
+	{
+		SendState->SetMode(Mode);
+	}
+}
+
+EMoqPublishMode UMoqPublisher::GetPublishMode() const
+{
+	return PublishOptions.Mode;
+}
+
+void UMoqPublisher::SetPriority(uint8 Priority)
+{
+	PublishOptions.Priority = Priority;
+
+	if (SendState)
+	{
+		SendState->SetPriority(Priority);
+	}
+}
+
+uint8 UMoqPublisher::GetPriority() const
+{
+	return PublishOptions.Priority;
+}
+
+void UMoqPublisher::SetRateLimit(const FMoqRateLimit& Limit)
+{
+	PublishOptions.RateLimit = Limit;
+
+	if (SendState)
+	{
+		SendState->SetRateLimit(Limit);
+	}
+}
+
+FMoqResult UMoqPublisher::FlushCoalesced()
+{
+	if (!SendState)
+	{
+		return FMoqResult(false, TEXT("Publisher not initialized"));
+	}
+
+	return SendState->FlushCoalesced();
+}
+
+void UMoqPublisher::RequestKeyframe()
+{
+	if (SendState)
+	{
+		SendState->RequestKeyframe();
+	}
+}
+
+int64 UMoqPublisher::StartGroup()
+{
+	if (!SendState)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UMoqPublisher::StartGroup: Publisher not initialized"));
+		return INDEX_NONE;
+	}
+	return SendState->StartGroup();
+}
+
+int64 UMoqPublisher::GetCurrentGroupId() const
+{
+	return SendState ? SendState->GetCurrentGroupId() : INDEX_NONE;
+}
+
+bool UMoqPublisher::IsBackpressured() const
+{
+	return SendState && SendState->IsBackpressured();
+}
+
+void UMoqPublisher::UpdateBackpressureState()
+{
+	const bool bBackpressured = IsBackpressured();
+	if (bBackpressured != bBackpressureBroadcast)
+	{
+		bBackpressureBroadcast = bBackpressured;
+		OnBackpressureChanged.Broadcast(bBackpressured);
+	}
+}
+
+FMoqPublisherStats UMoqPublisher::GetPublisherStats() const
+{
+	return SendState ? SendState->GetStats() : FMoqPublisherStats();
 }
 
 FMoqResult UMoqPublisher::PublishData(const TArray<uint8>& Data, EMoqDeliveryMode DeliveryMode)
@@ -40,30 +175,51 @@ FMoqResult UMoqPublisher::PublishData(const TArray<uint8>& Data, EMoqDeliveryMod
 		return FMoqResult(false, TEXT("Cannot publish empty data"));
 	}
 
-	if (!PublisherHandle)
+	return PublishBytes(Data.GetData(), Data.Num(), DeliveryMode);
+}
+
+FMoqResult UMoqPublisher::PublishData(TConstArrayView<uint8> Data, EMoqDeliveryMode DeliveryMode)
+{
+	if (Data.Num() == 0)
 	{
-		return FMoqResult(false, TEXT("Publisher not initialized"));
+		return FMoqResult(false, TEXT("Cannot publish empty data"));
 	}
 
-	MoqDeliveryMode NativeDeliveryMode = (DeliveryMode == EMoqDeliveryMode::Datagram) ? MOQ_DELIVERY_DATAGRAM : MOQ_DELIVERY_STREAM;
+	return PublishBytes(Data.GetData(), Data.Num(), DeliveryMode);
+}
 
-	MoqResult Result = moq_publish_data(
-		PublisherHandle,
-		Data.GetData(),
-		Data.Num(),
-		NativeDeliveryMode
-	);
+FMoqResult UMoqPublisher::PublishData(const FSharedBuffer& Payload, EMoqDeliveryMode DeliveryMode)
+{
+	if (Payload.GetSize() == 0)
+	{
+		return FMoqResult(false, TEXT("Cannot publish empty data"));
+	}
 
-	if (Result.code == MOQ_OK)
+	if (!SendState || !SendState->ShouldQueue())
 	{
-		return FMoqResult(true);
+		return PublishBytes(static_cast<const uint8*>(Payload.GetData()), static_cast<int64>(Payload.GetSize()), DeliveryMode);
 	}
-	else
+
+	// A non-owning view must not outlive the call, so only an owned buffer can be queued as-is
+	return PublishBuffer(FSharedBuffer::MakeOwned(CopyTemp(Payload)), DeliveryMode);
+}
+
+FMoqResult UMoqPublisher::PublishData(TArray<uint8>&& Data, EMoqDeliveryMode DeliveryMode)
+{
+	if (Data.Num() == 0)
 	{
-		FString ErrorMsg = UTF8_TO_TCHAR(Result.message);
-		moq_free_str(Result.message);
-		return FMoqResult(false, ErrorMsg);
+		return FMoqResult(false, TEXT("Cannot publish empty data"));
 	}
+
+	if (!SendState || !SendState->ShouldQueue())
+	{
+		return PublishBytes(Data.GetData(), Data.Num(), DeliveryMode);
+	}
+
+	// Moving a heap-allocated TArray keeps its allocation, so the buffer can point into the array it owns
+	const uint8* Bytes = Data.GetData();
+	const int64 Size = Data.Num();
+	return PublishBuffer(FSharedBuffer::TakeOwnership(Bytes, Size, [Owned = MoveTemp(Data)](void*) {}), DeliveryMode);
 }
 
 FMoqResult UMoqPublisher::PublishText(const FString& Text, EMoqDeliveryMode DeliveryMode)
@@ -73,33 +229,177 @@ FMoqResult UMoqPublisher::PublishText(const FString& Text, EMoqDeliveryMode Deli
 		return FMoqResult(false, TEXT("Cannot publish empty text"));
 	}
 
-	if (!PublisherHandle)
+	if (!SendState)
 	{
 		return FMoqResult(false, TEXT("Publisher not initialized"));
 	}
 
+	if (SendState->ShouldQueue())
+	{
+		// Convert straight into the pooled block that gets queued instead of through a temporary
+		const int32 Utf8Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Text, Text.Len());
+		FSharedBuffer Payload = FMoqPayloadPool::Get().Allocate(Utf8Length, [&Text, Utf8Length](uint8* Block)
+		{
+			FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Block), Utf8Length, *Text, Text.Len());
+		});
+		return PublishBuffer(MoveTemp(Payload), DeliveryMode);
+	}
+
 	// Convert to UTF-8
-	FTCHARToUTF8 Converter(*Text);
+	FTCHARToUTF8 Converter(*Text, Text.Len());
 	const uint8* Data = reinterpret_cast<const uint8*>(Converter.Get());
-	size_t DataLen = Converter.Length();
 
-	MoqDeliveryMode NativeDeliveryMode = (DeliveryMode == EMoqDeliveryMode::Datagram) ? MOQ_DELIVERY_DATAGRAM : MOQ_DELIVERY_STREAM;
+	return PublishBytes(Data, Converter.Length(), DeliveryMode);
+}
+
+FMoqBatchPublishResult UMoqPublisher::PublishBatch(const TArray<FMoqPublishPayload>& Objects, EMoqDeliveryMode DeliveryMode)
+{
+	TArray<TConstArrayView<uint8>, TInlineAllocator<32>> Views;
+	Views.Reserve(Objects.Num());
+	for (const FMoqPublishPayload& Object : Objects)
+	{
+		Views.Add(Object.Data);
+	}
+
+	return PublishBatch(TConstArrayView<TConstArrayView<uint8>>(Views), DeliveryMode);
+}
+
+FMoqBatchPublishResult UMoqPublisher::PublishBatch(const TArray<TArray<uint8>>& Objects, EMoqDeliveryMode DeliveryMode)
+{
+	TArray<TConstArrayView<uint8>, TInlineAllocator<32>> Views;
+	Views.Reserve(Objects.Num());
+	for (const TArray<uint8>& Object : Objects)
+	{
+		Views.Add(Object);
+	}
+
+	return PublishBatch(TConstArrayView<TConstArrayView<uint8>>(Views), DeliveryMode);
+}
+
+FMoqBatchPublishResult UMoqPublisher::PublishBatch(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode)
+{
+	if (!SendState)
+	{
+		FMoqBatchPublishResult Result;
+		if (Objects.Num() > 0)
+		{
+			Result.FailedIndices.Reserve(Objects.Num());
+			for (int32 Index = 0; Index < Objects.Num(); ++Index)
+			{
+				Result.FailedIndices.Add(Index);
+			}
+			Result.FirstErrorMessage = TEXT("Publisher not initialized");
+		}
+		return Result;
+	}
+
+	if (SendState->UsesEnvelopes())
+	{
+		// Framed publishes are coalesced or escaped one by one anyway
+		FMoqBatchPublishResult Result;
+		for (int32 Index = 0; Index < Objects.Num(); ++Index)
+		{
+			const FMoqResult ObjectResult = PublishData(Objects[Index], DeliveryMode);
+			if (ObjectResult.bSuccess)
+			{
+				++Result.NumSucceeded;
+			}
+			else
+			{
+				if (Result.FailedIndices.Num() == 0)
+				{
+					Result.FirstErrorMessage = ObjectResult.ErrorMessage;
+				}
+				Result.FailedIndices.Add(Index);
+			}
+		}
+		return Result;
+	}
+
+	if (SendState->ShouldQueue())
+	{
+		return SendState->EnqueueBatch(Objects, DeliveryMode);
+	}
 
-	MoqResult Result = moq_publish_data(
-		PublisherHandle,
-		Data,
-		DataLen,
-		NativeDeliveryMode
-	);
+	return SendState->PublishBatchNow(Objects, DeliveryMode);
+}
 
-	if (Result.code == MOQ_OK)
+FMoqResult UMoqPublisher::PublishStruct(const UScriptStruct* Struct, const void* Value, EMoqDeliveryMode DeliveryMode)
+{
+	if (!Struct || !Value)
 	{
-		return FMoqResult(true);
+		return FMoqResult(false, TEXT("Cannot publish a null struct"));
 	}
-	else
+
+	// Encoded into a reused buffer; PublishBytes only copies it if the publish is queued
+	static thread_local TArray<uint8> StructScratch;
+	MoqStructSerializer::Serialize(Struct, Value, StructScratch);
+	return PublishBytes(StructScratch.GetData(), StructScratch.Num(), DeliveryMode);
+}
+
+FMoqResult UMoqPublisher::K2_PublishStruct(const int32& Value, EMoqDeliveryMode DeliveryMode)
+{
+	// Never called: Blueprint calls go through execK2_PublishStruct, which knows the struct type
+	check(0);
+	return FMoqResult(false, TEXT("Publish Struct is Blueprint only"));
+}
+
+DEFINE_FUNCTION(UMoqPublisher::execK2_PublishStruct)
+{
+	Stack.MostRecentProperty = nullptr;
+	Stack.MostRecentPropertyAddress = nullptr;
+	Stack.StepCompiledIn<FStructProperty>(nullptr);
+	const FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+	const void* Value = Stack.MostRecentPropertyAddress;
+	P_GET_ENUM(EMoqDeliveryMode, DeliveryMode);
+	P_FINISH;
+
+	P_NATIVE_BEGIN;
+	*static_cast<FMoqResult*>(RESULT_PARAM) = StructProperty
+		? P_THIS->PublishStruct(StructProperty->Struct, Value, DeliveryMode)
+		: FMoqResult(false, TEXT("Publish Struct needs a struct value"));
+	P_NATIVE_END;
+}
+
+FMoqResult UMoqPublisher::PublishBytes(const uint8* Data, int64 Size, EMoqDeliveryMode DeliveryMode)
+{
+	if (!SendState)
 	{
-		FString ErrorMsg = UTF8_TO_TCHAR(Result.message);
-		moq_free_str(Result.message);
-		return FMoqResult(false, ErrorMsg);
+		return FMoqResult(false, TEXT("Publisher not initialized"));
 	}
+
+	FMoqResult FramedResult;
+	if (SendState->TryPublishFramed(MakeArrayView(Data, static_cast<int32>(Size)), DeliveryMode, FramedResult))
+	{
+		return FramedResult;
+	}
+
+	if (SendState->ShouldQueue())
+	{
+		// The caller's buffer may be gone by the time the sender thread runs, so copy into a pooled block
+		return SendState->Enqueue(FMoqPayloadPool::Get().CopyFrom(Data, Size), DeliveryMode);
+	}
+
+	return SendState->PublishNow(Data, Size, DeliveryMode);
+}
+
+FMoqResult UMoqPublisher::PublishBuffer(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode)
+{
+	if (!SendState)
+	{
+		return FMoqResult(false, TEXT("Publisher not initialized"));
+	}
+
+	FMoqResult FramedResult;
+	if (SendState->TryPublishFramed(MakeArrayView(static_cast<const uint8*>(Payload.GetData()), static_cast<int32>(Payload.GetSize())), DeliveryMode, FramedResult))
+	{
+		return FramedResult;
+	}
+
+	if (SendState->ShouldQueue())
+	{
+		return SendState->Enqueue(MoveTemp(Payload), DeliveryMode);
+	}
+
+	return SendState->PublishNow(static_cast<const uint8*>(Payload.GetData()), static_cast<int64>(Payload.GetSize()), DeliveryMode);
 }
@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqRateLimiter.h"
+#include "Misc/ScopeLock.h"
+
+void FMoqRateLimiter::FBucket::Configure(double InRate, double BurstSeconds, double MinCapacity)
+{
+	Rate = FMath::Max(InRate, 0.0);
+	Capacity = FMath::Max(Rate * BurstSeconds, MinCapacity);
+
+	// Start full, so the first burst after configuring is not delayed
+	Tokens = Capacity;
+}
+
+void FMoqRateLimiter::FBucket::Refill(double Elapsed)
+{
+	if (Rate > 0.0)
+	{
+		Tokens = FMath::Min(Capacity, Tokens + Rate * Elapsed);
+	}
+}
+
+double FMoqRateLimiter::FBucket::GetWaitSeconds(double Amount) const
+{
+	if (Rate <= 0.0)
+	{
+		return 0.0;
+	}
+
+	// An object larger than the bucket only needs a full bucket; the rest is paid off as debt
+	const double Needed = FMath::Min(Amount, Capacity);
+	return Tokens >= Needed ? 0.0 : (Needed - Tokens) / Rate;
+}
+
+void FMoqRateLimiter::SetLimit(const FMoqRateLimit& InLimit)
+{
+	FScopeLock Lock(&LimitLock);
+	Limit = InLimit;
+
+	const double BurstSeconds = FMath::Max(InLimit.BurstMs, 1.0f) / 1000.0;
+	ByteBucket.Configure(static_cast<double>(InLimit.BytesPerSecond), BurstSeconds, 1.0);
+	ObjectBucket.Configure(InLimit.ObjectsPerSecond, BurstSeconds, 1.0);
+	LastRefillTime = FPlatformTime::Seconds();
+
+	bLimited.store(InLimit.IsLimited(), std::memory_order_relaxed);
+}
+
+FMoqRateLimit FMoqRateLimiter::GetLimit() const
+{
+	FScopeLock Lock(&LimitLock);
+	return Limit;
+}
+
+void FMoqRateLimiter::Refill(double Now)
+{
+	const double Elapsed = FMath::Max(Now - LastRefillTime, 0.0);
+	LastRefillTime = FMath::Max(Now, LastRefillTime);
+	ByteBucket.Refill(Elapsed);
+	ObjectBucket.Refill(Elapsed);
+}
+
+double FMoqRateLimiter::GetWaitSeconds(int64 Bytes, double Now)
+{
+	if (!IsLimited())
+	{
+		return 0.0;
+	}
+
+	FScopeLock Lock(&LimitLock);
+	Refill(Now);
+	return FMath::Max(ByteBucket.GetWaitSeconds(static_cast<double>(Bytes)), ObjectBucket.GetWaitSeconds(1.0));
+}
+
+void FMoqRateLimiter::Consume(int64 Bytes, double Now)
+{
+	NumSent.fetch_add(1, std::memory_order_relaxed);
+	SentBytes.fetch_add(Bytes, std::memory_order_relaxed);
+
+	if (!IsLimited())
+	{
+		return;
+	}
+
+	FScopeLock Lock(&LimitLock);
+	Refill(Now);
+	ByteBucket.Tokens -= static_cast<double>(Bytes);
+	ObjectBucket.Tokens -= 1.0;
+}
+
+void FMoqRateLimiter::RecordDeferred(int64 Bytes)
+{
+	NumDeferred.fetch_add(1, std::memory_order_relaxed);
+	DeferredBytes.fetch_add(Bytes, std::memory_order_relaxed);
+}
+
+FMoqPacingStats FMoqRateLimiter::GetStats() const
+{
+	FMoqPacingStats Stats;
+	Stats.SentObjects = NumSent.load(std::memory_order_relaxed);
+	Stats.SentBytes = SentBytes.load(std::memory_order_relaxed);
+	Stats.DeferredObjects = NumDeferred.load(std::memory_order_relaxed);
+	Stats.DeferredBytes = DeferredBytes.load(std::memory_order_relaxed);
+	return Stats;
+}
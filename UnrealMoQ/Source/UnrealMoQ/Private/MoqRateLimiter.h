@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "MoqTypes.h"
+#include <atomic>
+
+/**
+ * Token buckets for bytes and objects per second, shared by whatever sends under one FMoqRateLimit:
+ * a single publisher, or every publisher of a UMoqClient.
+ *
+ * A full bucket lets an object through even if it is larger than the bucket, and the tokens go
+ * negative; the debt is paid off before anything else is released, so the long-run rate holds for
+ * objects of any size. Safe to use from any thread.
+ */
+class FMoqRateLimiter
+{
+public:
+	void SetLimit(const FMoqRateLimit& Limit);
+
+	FMoqRateLimit GetLimit() const;
+
+	bool IsLimited() const { return bLimited.load(std::memory_order_relaxed); }
+
+	/** Seconds until an object of Bytes may be sent, 0 if it may be sent now */
+	double GetWaitSeconds(int64 Bytes, double Now);
+
+	/** Take the tokens for an object that is being sent */
+	void Consume(int64 Bytes, double Now);
+
+	/** Count an object that had to wait before being sent */
+	void RecordDeferred(int64 Bytes);
+
+	FMoqPacingStats GetStats() const;
+
+private:
+	struct FBucket
+	{
+		double Rate = 0.0;
+		double Capacity = 0.0;
+		double Tokens = 0.0;
+
+		void Configure(double InRate, double BurstSeconds, double MinCapacity);
+		void Refill(double Elapsed);
+		double GetWaitSeconds(double Amount) const;
+	};
+
+	/** Add the tokens earned since the last refill (LimitLock held) */
+	void Refill(double Now);
+
+	mutable FCriticalSection LimitLock;
+	FMoqRateLimit Limit;
+	FBucket ByteBucket;
+	FBucket ObjectBucket;
+	double LastRefillTime = 0.0;
+
+	std::atomic<bool> bLimited{ false };
+	std::atomic<int64> NumSent{ 0 };
+	std::atomic<int64> SentBytes{ 0 };
+	std::atomic<int64> NumDeferred{ 0 };
+	std::atomic<int64> DeferredBytes{ 0 };
+};
@@ -0,0 +1,129 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqReceiveDispatcher.h"
+#include "MoqSubscriber.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/IConsoleManager.h"
+
+static float GMoqDispatchBudgetMs = 1.0f;
+static FAutoConsoleVariableRef CVarMoqDispatchBudgetMs(
+	TEXT("moq.Dispatch.BudgetMs"),
+	GMoqDispatchBudgetMs,
+	TEXT("Game thread time per frame, in milliseconds, spent broadcasting received MoQ objects. ")
+	TEXT("Objects left over are delivered on later frames. 0 or less disables the budget."),
+	ECVF_Default);
+
+FMoqReceiveDispatcher& FMoqReceiveDispatcher::Get()
+{
+	static FMoqReceiveDispatcher Instance;
+	return Instance;
+}
+
+void FMoqReceiveDispatcher::Startup()
+{
+	if (!TickerHandle.IsValid())
+	{
+		TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FMoqReceiveDispatcher::Tick));
+	}
+}
+
+void FMoqReceiveDispatcher::Shutdown()
+{
+	if (TickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		TickerHandle.Reset();
+	}
+
+	FScopeLock Lock(&SubscribersLock);
+	Subscribers.Empty();
+}
+
+void FMoqReceiveDispatcher::RegisterSubscriber(UMoqSubscriber* Subscriber)
+{
+	if (!Subscriber)
+	{
+		return;
+	}
+
+	FScopeLock Lock(&SubscribersLock);
+	Subscribers.AddUnique(Subscriber);
+}
+
+void FMoqReceiveDispatcher::UnregisterSubscriber(UMoqSubscriber* Subscriber)
+{
+	const TWeakObjectPtr<UMoqSubscriber> Target(Subscriber);
+
+	FScopeLock Lock(&SubscribersLock);
+	Subscribers.RemoveAllSwap([&Target](const TWeakObjectPtr<UMoqSubscriber>& Entry)
+	{
+		return Entry == Target || Entry.IsStale();
+	});
+}
+
+int32 FMoqReceiveDispatcher::DispatchAll()
+{
+	check(IsInGameThread());
+
+	// Broadcasting can create or destroy subscribers, so work on a snapshot
+	TArray<TWeakObjectPtr<UMoqSubscriber>, TInlineAllocator<64>> Snapshot;
+	{
+		FScopeLock Lock(&SubscribersLock);
+		Snapshot.Append(Subscribers);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = GMoqDispatchBudgetMs > 0.0f ? StartTime + GMoqDispatchBudgetMs / 1000.0 : TNumericLimits<double>::Max();
+
+	// Start after the subscriber that used up the previous frame's budget so one busy subscriber cannot starve the others
+	const int32 NumSubscribers = Snapshot.Num();
+	const int32 FirstIndex = NumSubscribers > 0 ? NextSubscriberIndex % NumSubscribers : 0;
+	int32 NumDispatched = 0;
+	Stats = FMoqDispatchStats();
+
+	auto AddBacklog = [this](const FMoqReceiveQueueStats& SubscriberStats)
+	{
+		Stats.BacklogObjects += SubscriberStats.QueuedObjects;
+		Stats.BacklogAgeMs = FMath::Max(Stats.BacklogAgeMs, SubscriberStats.BacklogAgeMs);
+	};
+
+	for (int32 Offset = 0; Offset < NumSubscribers; ++Offset)
+	{
+		const int32 Index = (FirstIndex + Offset) % NumSubscribers;
+		UMoqSubscriber* Subscriber = Snapshot[Index].Get();
+		if (!Subscriber || !Subscriber->IsAutoDispatchEnabled())
+		{
+			continue;
+		}
+
+		NumDispatched += Subscriber->DispatchPendingEvents(EndTime);
+
+		const FMoqReceiveQueueStats SubscriberStats = Subscriber->GetReceiveQueueStats();
+		AddBacklog(SubscriberStats);
+
+		if (SubscriberStats.QueuedObjects > 0 && FPlatformTime::Seconds() >= EndTime)
+		{
+			NextSubscriberIndex = (Index + 1) % NumSubscribers;
+			for (int32 Remaining = Offset + 1; Remaining < NumSubscribers; ++Remaining)
+			{
+				UMoqSubscriber* Skipped = Snapshot[(FirstIndex + Remaining) % NumSubscribers].Get();
+				if (Skipped && Skipped->IsAutoDispatchEnabled())
+				{
+					AddBacklog(Skipped->GetReceiveQueueStats());
+				}
+			}
+			Stats.DispatchedObjects = NumDispatched;
+			return NumDispatched;
+		}
+	}
+
+	NextSubscriberIndex = FirstIndex;
+	Stats.DispatchedObjects = NumDispatched;
+	return NumDispatched;
+}
+
+bool FMoqReceiveDispatcher::Tick(float DeltaTime)
+{
+	DispatchAll();
+	return true;
+}
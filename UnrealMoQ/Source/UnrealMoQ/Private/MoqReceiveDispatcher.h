@@ -0,0 +1,57 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "HAL/CriticalSection.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "MoqTypes.h"
+
+class UMoqSubscriber;
+
+/**
+ * Module-level game thread drain for subscriber receive queues.
+ *
+ * Subscribers register themselves on creation; once per frame the core ticker empties every
+ * registered queue and broadcasts the subscriber events, replacing one task graph task per object.
+ * The drain stops when moq.Dispatch.BudgetMs is spent; the remainder is carried over and the next
+ * frame starts with the subscriber after the one that was cut short, so a burst is spread over
+ * several frames and a subscriber that spends the whole budget every frame cannot starve the others.
+ */
+class FMoqReceiveDispatcher
+{
+public:
+	static FMoqReceiveDispatcher& Get();
+
+	/** Register the core ticker (called from module startup) */
+	void Startup();
+
+	/** Remove the core ticker (called from module shutdown) */
+	void Shutdown();
+
+	void RegisterSubscriber(UMoqSubscriber* Subscriber);
+	void UnregisterSubscriber(UMoqSubscriber* Subscriber);
+
+	/**
+	 * Drain registered subscribers until the frame budget is spent. Must be called on the game thread.
+	 * @return Number of objects delivered
+	 */
+	int32 DispatchAll();
+
+	/** Objects delivered and still waiting across all subscribers after the last DispatchAll (game thread) */
+	FMoqDispatchStats GetStats() const { return Stats; }
+
+private:
+	bool Tick(float DeltaTime);
+
+	FCriticalSection SubscribersLock;
+	TArray<TWeakObjectPtr<UMoqSubscriber>> Subscribers;
+	FTSTicker::FDelegateHandle TickerHandle;
+
+	/** Subscriber the next drain starts with (game thread only) */
+	int32 NextSubscriberIndex = 0;
+
+	/** Result of the last DispatchAll (game thread only) */
+	FMoqDispatchStats Stats;
+};
@@ -0,0 +1,460 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqStructSerializer.h"
+#include "MoqEnvelope.h"
+#include "Hash/CityHash.h"
+#include "Misc/ScopeRWLock.h"
+#include "UObject/Class.h"
+#include "UObject/EnumProperty.h"
+#include "UObject/UnrealType.h"
+
+namespace
+{
+/** Upper bound on elements of an array whose elements take no bytes on the wire */
+constexpr uint64 MaxEmptyElements = 65536;
+
+enum class EStepKind : uint8
+{
+	/** Bytes copied as they are in memory: numbers, enums, and runs of them */
+	Copy,
+
+	/** Bool, native or bitfield, one byte on the wire; never copied, since any byte but 0 or 1 in a native bool is undefined */
+	Bool,
+
+	/** FString as UTF-8 with a varint length */
+	String,
+
+	/** FName as UTF-8 with a varint length */
+	Name,
+
+	/** TArray as a varint count, then its elements */
+	Array,
+};
+
+struct FLayoutPlan;
+
+struct FStep
+{
+	EStepKind Kind = EStepKind::Copy;
+
+	/** Offset of the field from the start of the value the plan describes */
+	int32 Offset = 0;
+
+	/** Bytes copied, for EStepKind::Copy */
+	int32 Size = 0;
+
+	/** The bool or array property, for the steps that need it */
+	const FProperty* Property = nullptr;
+
+	/** Plan of one element, for EStepKind::Array; owned by the plan the step is in */
+	const FLayoutPlan* Element = nullptr;
+};
+
+/** Steps that encode one value: a struct, or one array element */
+struct FLayoutPlan
+{
+	TArray<FStep> Steps;
+	TArray<TUniquePtr<FLayoutPlan>> ElementPlans;
+
+	/** Memory size of the value */
+	int32 Size = 0;
+
+	/** Fewest bytes the value takes on the wire, to bound array counts before allocating */
+	int32 MinWireSize = 0;
+
+	uint32 SchemaHash = 0;
+
+	/** What a struct plan was built from; a Blueprint struct that is recompiled gets new properties and so a new plan */
+	const FField* FirstProperty = nullptr;
+
+	/** True if the value is a single block copy, so arrays of it are copied in one go */
+	bool IsPlainData() const
+	{
+		return Steps.Num() == 1 && Steps[0].Kind == EStepKind::Copy && Steps[0].Offset == 0 && Steps[0].Size == Size;
+	}
+
+	void AddCopy(int32 Offset, int32 Size)
+	{
+		// Fields adjacent in memory become one copy; padding between fields never reaches the wire
+		if (Steps.Num() > 0 && Steps.Last().Kind == EStepKind::Copy && Steps.Last().Offset + Steps.Last().Size == Offset)
+		{
+			Steps.Last().Size += Size;
+		}
+		else
+		{
+			FStep& Step = Steps.AddDefaulted_GetRef();
+			Step.Offset = Offset;
+			Step.Size = Size;
+		}
+		MinWireSize += Size;
+	}
+
+	FStep& AddStep(EStepKind Kind, int32 Offset, const FProperty* Property)
+	{
+		FStep& Step = Steps.AddDefaulted_GetRef();
+		Step.Kind = Kind;
+		Step.Offset = Offset;
+		Step.Property = Property;
+		MinWireSize += 1;
+		return Step;
+	}
+};
+
+/** Walks the reflection data of one struct into a plan, writing down the schema as it goes */
+class FPlanBuilder
+{
+public:
+	void AddStruct(const UScriptStruct* Struct, int32 BaseOffset, FLayoutPlan& Plan)
+	{
+		Schema.Append(Struct->GetName());
+		Schema.AppendChar(TEXT('{'));
+		Building.Push(Struct);
+
+		for (TFieldIterator<FProperty> It(Struct); It; ++It)
+		{
+			for (int32 Index = 0; Index < It->GetArrayDim(); ++Index)
+			{
+				AddProperty(*It, BaseOffset + It->GetOffset_ForInternal() + Index * It->GetElementSize(), Plan);
+			}
+		}
+
+		Building.Pop();
+		Schema.AppendChar(TEXT('}'));
+	}
+
+	/** @return False if the property cannot be encoded; nothing was added for it */
+	bool AddProperty(const FProperty* Property, int32 Offset, FLayoutPlan& Plan)
+	{
+		if (const FArrayProperty* ArrayProperty = CastField<FArrayProperty>(Property))
+		{
+			TUniquePtr<FLayoutPlan> Element = MakeUnique<FLayoutPlan>();
+			Element->Size = ArrayProperty->Inner->GetElementSize();
+			if (!AddProperty(ArrayProperty->Inner, 0, *Element))
+			{
+				return false;
+			}
+			Plan.AddStep(EStepKind::Array, Offset, ArrayProperty).Element = Element.Get();
+			Plan.ElementPlans.Add(MoveTemp(Element));
+		}
+		else if (const FStructProperty* StructProperty = CastField<FStructProperty>(Property))
+		{
+			// Only an array can lead back to a struct being built; it would never end
+			if (Building.Contains(StructProperty->Struct))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("MoqStructSerializer: %s refers to itself through %s, which is not encoded"),
+					*StructProperty->Struct->GetName(), *Property->GetName());
+				return false;
+			}
+			AddStruct(StructProperty->Struct, Offset, Plan);
+		}
+		else if (const FBoolProperty* BoolProperty = CastField<FBoolProperty>(Property))
+		{
+			Plan.AddStep(EStepKind::Bool, Offset, BoolProperty);
+		}
+		else if (Property->IsA<FNumericProperty>() || Property->IsA<FEnumProperty>())
+		{
+			Plan.AddCopy(Offset, Property->GetElementSize());
+		}
+		else if (Property->IsA<FStrProperty>())
+		{
+			Plan.AddStep(EStepKind::String, Offset, Property);
+		}
+		else if (Property->IsA<FNameProperty>())
+		{
+			Plan.AddStep(EStepKind::Name, Offset, Property);
+		}
+		else
+		{
+			return false;
+		}
+
+		Schema.Appendf(TEXT("%s:%s;"), *Property->GetName(), *Property->GetCPPType());
+		return true;
+	}
+
+	FString Schema;
+
+private:
+	TArray<const UScriptStruct*, TInlineAllocator<8>> Building;
+};
+
+class FLayoutCache
+{
+public:
+	static FLayoutCache& Get()
+	{
+		static FLayoutCache Instance;
+		return Instance;
+	}
+
+	TSharedRef<const FLayoutPlan, ESPMode::ThreadSafe> GetPlan(const UScriptStruct* Struct)
+	{
+		{
+			FReadScopeLock Lock(PlansLock);
+			const TSharedPtr<const FLayoutPlan, ESPMode::ThreadSafe>* Plan = Plans.Find(Struct);
+			if (Plan && (*Plan)->FirstProperty == Struct->ChildProperties && (*Plan)->Size == Struct->GetStructureSize())
+			{
+				return Plan->ToSharedRef();
+			}
+		}
+
+		// Built outside the lock; if two threads race, both plans are identical
+		TSharedRef<FLayoutPlan, ESPMode::ThreadSafe> NewPlan = MakeShared<FLayoutPlan, ESPMode::ThreadSafe>();
+		NewPlan->Size = Struct->GetStructureSize();
+		NewPlan->FirstProperty = Struct->ChildProperties;
+
+		FPlanBuilder Builder;
+		Builder.AddStruct(Struct, 0, *NewPlan);
+		const FTCHARToUTF8 SchemaUtf8(*Builder.Schema);
+		NewPlan->SchemaHash = CityHash32(SchemaUtf8.Get(), SchemaUtf8.Length());
+
+		FWriteScopeLock Lock(PlansLock);
+		Plans.Add(Struct, NewPlan);
+		return NewPlan;
+	}
+
+private:
+	FRWLock PlansLock;
+	TMap<const UScriptStruct*, TSharedPtr<const FLayoutPlan, ESPMode::ThreadSafe>> Plans;
+};
+
+void WriteChars(TArray<uint8>& Out, const TCHAR* Chars, int32 Length)
+{
+	const int32 Utf8Length = FPlatformString::ConvertedLength<UTF8CHAR>(Chars, Length);
+	MoqEnvelope::WriteVarint(Out, Utf8Length);
+	const int32 Start = Out.AddUninitialized(Utf8Length);
+	FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Out.GetData() + Start), Utf8Length, Chars, Length);
+}
+
+/** Read a varint-prefixed UTF-8 string at Offset and advance past it */
+bool ReadChars(TConstArrayView<uint8> Data, int32& Offset, TConstArrayView<uint8>& OutUtf8)
+{
+	uint64 Length = 0;
+	if (!MoqEnvelope::ReadVarint(Data, Offset, Length) || Length > static_cast<uint64>(Data.Num() - Offset))
+	{
+		return false;
+	}
+
+	OutUtf8 = Data.Slice(Offset, static_cast<int32>(Length));
+	Offset += static_cast<int32>(Length);
+	return true;
+}
+
+void EncodeValue(const FLayoutPlan& Plan, const uint8* Value, TArray<uint8>& Out)
+{
+	for (const FStep& Step : Plan.Steps)
+	{
+		const uint8* Field = Value + Step.Offset;
+		switch (Step.Kind)
+		{
+		case EStepKind::Copy:
+			Out.Append(Field, Step.Size);
+			break;
+
+		case EStepKind::Bool:
+			Out.Add(static_cast<const FBoolProperty*>(Step.Property)->GetPropertyValue(Field) ? 1 : 0);
+			break;
+
+		case EStepKind::String:
+		{
+			const FString& String = *reinterpret_cast<const FString*>(Field);
+			WriteChars(Out, *String, String.Len());
+			break;
+		}
+
+		case EStepKind::Name:
+		{
+			TStringBuilder<FName::StringBufferSize> Name;
+			reinterpret_cast<const FName*>(Field)->AppendString(Name);
+			WriteChars(Out, Name.GetData(), Name.Len());
+			break;
+		}
+
+		case EStepKind::Array:
+		{
+			FScriptArrayHelper Array(static_cast<const FArrayProperty*>(Step.Property), Field);
+			const int32 Count = Array.Num();
+			MoqEnvelope::WriteVarint(Out, Count);
+			if (Count == 0)
+			{
+				break;
+			}
+
+			if (Step.Element->IsPlainData())
+			{
+				Out.Append(Array.GetRawPtr(0), Count * Step.Element->Size);
+			}
+			else
+			{
+				for (int32 Index = 0; Index < Count; ++Index)
+				{
+					EncodeValue(*Step.Element, Array.GetRawPtr(Index), Out);
+				}
+			}
+			break;
+		}
+		}
+	}
+}
+
+bool DecodeValue(const FLayoutPlan& Plan, TConstArrayView<uint8> Data, int32& Offset, uint8* Value)
+{
+	for (const FStep& Step : Plan.Steps)
+	{
+		uint8* Field = Value + Step.Offset;
+		switch (Step.Kind)
+		{
+		case EStepKind::Copy:
+			if (Data.Num() - Offset < Step.Size)
+			{
+				return false;
+			}
+			FMemory::Memcpy(Field, Data.GetData() + Offset, Step.Size);
+			Offset += Step.Size;
+			break;
+
+		case EStepKind::Bool:
+			if (Offset >= Data.Num())
+			{
+				return false;
+			}
+			static_cast<const FBoolProperty*>(Step.Property)->SetPropertyValue(Field, Data[Offset++] != 0);
+			break;
+
+		case EStepKind::String:
+		{
+			TConstArrayView<uint8> Utf8;
+			if (!ReadChars(Data, Offset, Utf8))
+			{
+				return false;
+			}
+
+			// Refill in place, so a string field that keeps its length keeps its allocation
+			const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Utf8.GetData()), Utf8.Num());
+			FString& String = *reinterpret_cast<FString*>(Field);
+			String.Reset(Converter.Length());
+			String.AppendChars(Converter.Get(), Converter.Length());
+			break;
+		}
+
+		case EStepKind::Name:
+		{
+			TConstArrayView<uint8> Utf8;
+			if (!ReadChars(Data, Offset, Utf8))
+			{
+				return false;
+			}
+
+			const FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Utf8.GetData()), Utf8.Num());
+			*reinterpret_cast<FName*>(Field) = FName(Converter.Length(), Converter.Get());
+			break;
+		}
+
+		case EStepKind::Array:
+		{
+			uint64 Count = 0;
+			if (!MoqEnvelope::ReadVarint(Data, Offset, Count))
+			{
+				return false;
+			}
+
+			// Never allocate more elements than the rest of the data could possibly fill
+			const int32 MinElementSize = Step.Element->MinWireSize;
+			const uint64 MaxCount = MinElementSize > 0 ? static_cast<uint64>((Data.Num() - Offset) / MinElementSize) : MaxEmptyElements;
+			if (Count > MaxCount)
+			{
+				return false;
+			}
+
+			FScriptArrayHelper Array(static_cast<const FArrayProperty*>(Step.Property), Field);
+			Array.Resize(static_cast<int32>(Count));
+			if (Count == 0)
+			{
+				break;
+			}
+
+			if (Step.Element->IsPlainData())
+			{
+				const int32 Bytes = static_cast<int32>(Count) * Step.Element->Size;
+				FMemory::Memcpy(Array.GetRawPtr(0), Data.GetData() + Offset, Bytes);
+				Offset += Bytes;
+			}
+			else
+			{
+				for (int32 Index = 0; Index < static_cast<int32>(Count); ++Index)
+				{
+					if (!DecodeValue(*Step.Element, Data, Offset, Array.GetRawPtr(Index)))
+					{
+						return false;
+					}
+				}
+			}
+			break;
+		}
+		}
+	}
+	return true;
+}
+}
+
+namespace MoqStructSerializer
+{
+	uint32 GetSchemaHash(const UScriptStruct* Struct)
+	{
+		return FLayoutCache::Get().GetPlan(Struct)->SchemaHash;
+	}
+
+	void Serialize(const UScriptStruct* Struct, const void* Value, TArray<uint8>& Out)
+	{
+		const TSharedRef<const FLayoutPlan, ESPMode::ThreadSafe> Plan = FLayoutCache::Get().GetPlan(Struct);
+
+		Out.Reset();
+		Out.Add(FormatVersion);
+		for (int32 Shift = 0; Shift < 32; Shift += 8)
+		{
+			Out.Add(static_cast<uint8>(Plan->SchemaHash >> Shift));
+		}
+		EncodeValue(*Plan, static_cast<const uint8*>(Value), Out);
+	}
+
+	bool Deserialize(const UScriptStruct* Struct, TConstArrayView<uint8> Data, void* OutValue, FString* OutError)
+	{
+		if (Data.Num() < HeaderSize || Data[0] != FormatVersion)
+		{
+			if (OutError)
+			{
+				*OutError = TEXT("Not an encoded struct, or encoded by an unsupported version of the plugin");
+			}
+			return false;
+		}
+
+		const TSharedRef<const FLayoutPlan, ESPMode::ThreadSafe> Plan = FLayoutCache::Get().GetPlan(Struct);
+		uint32 SchemaHash = 0;
+		for (int32 Shift = 0; Shift < 32; Shift += 8)
+		{
+			SchemaHash |= static_cast<uint32>(Data[1 + Shift / 8]) << Shift;
+		}
+
+		// Fail before touching the value rather than reading fields into the wrong places
+		if (SchemaHash != Plan->SchemaHash)
+		{
+			if (OutError)
+			{
+				*OutError = FString::Printf(TEXT("Schema %08x does not match %s (%08x); the publisher was built with a different version of the struct"),
+					SchemaHash, *Struct->GetName(), Plan->SchemaHash);
+			}
+			return false;
+		}
+
+		int32 Offset = HeaderSize;
+		if (!DecodeValue(*Plan, Data, Offset, static_cast<uint8*>(OutValue)) || Offset != Data.Num())
+		{
+			if (OutError)
+			{
+				*OutError = FString::Printf(TEXT("Encoded %s is truncated or has trailing bytes"), *Struct->GetName());
+			}
+			return false;
+		}
+		return true;
+	}
+}
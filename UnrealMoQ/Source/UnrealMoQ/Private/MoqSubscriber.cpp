@@ -2,10 +2,47 @@
 
 #include "MoqSubscriber.h"
 #include "MoqClient.h"
-#include "Async/Async.h"
+#include "MoqDataSinkBinding.h"
+#include "MoqEnvelope.h"
+#include "MoqHandleRegistry.h"
+#include "MoqPayloadPool.h"
+#include "MoqReceiveDispatcher.h"
+#include "MoqStructSerializer.h"
+#include "MoqUtf8.h"
+
+namespace
+{
+/** Copy a pooled object into the Blueprint-facing message struct */
+FMoqReceivedMessage MakeReceivedMessage(const FMoqReceivedObject& Object)
+{
+	const TConstArrayView<uint8> Payload = Object.GetData();
+	FMoqReceivedMessage Message;
+	Message.Data.Append(Payload.GetData(), Payload.Num());
+	Message.ArrivalTime = Object.ArrivalTime;
+	Message.Sequence = Object.Sequence;
+	Message.GroupId = Object.GroupId;
+	Message.ObjectId = Object.ObjectId;
+	return Message;
+}
+}
 
 UMoqSubscriber::UMoqSubscriber()
 	: SubscriberHandle(nullptr)
+	, CallbackHandle(nullptr)
+	, ReceiveQueue(FMoqSubscribeOptions().ReceiveQueueCapacity)
+	, ReceiveMode(FMoqSubscribeOptions().ReceiveMode)
+	, OverflowPolicy(FMoqSubscribeOptions().OverflowPolicy)
+	, bGameThreadDelivery(FMoqSubscribeOptions().bDeliverOnGameThread)
+	, TrackContent(FMoqSubscribeOptions().Content)
+	, NumDelivered(0)
+	, bAutoDispatch(FMoqSubscribeOptions().bAutoDispatch)
+	, NumBudgetDeferrals(0)
+	, NumStructDecodeFailures(0)
+	, NextSequence(0)
+	, bDecodeEnvelopes(FMoqSubscribeOptions().bDecodeEnvelopes)
+	, NumMalformed(0)
+	, bWaitForGroupStart(FMoqSubscribeOptions().bJoinAtGroupStart)
+	, NumSkippedBeforeGroupStart(0)
 {
 }
 
@@ -18,8 +55,44 @@ UMoqSubscriber::~UMoqSubscriber()
 	}
 }
 
+void UMoqSubscriber::PostInitProperties()
+{
+	Super::PostInitProperties();
+
+	if (!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject))
+	{
+		FMoqReceiveDispatcher::Get().RegisterSubscriber(this);
+		CallbackHandle = TMoqHandleRegistry<UMoqSubscriber>::Get().Register(this);
+	}
+}
+
 void UMoqSubscriber::BeginDestroy()
 {
+	FMoqReceiveDispatcher::Get().UnregisterSubscriber(this);
+
+	// Release a network thread that may be waiting for queue space before tearing down the handle
+	ReceiveQueue.Close();
+
+	TSharedPtr<const FMoqDataSinkList, ESPMode::ThreadSafe> Sinks;
+	{
+		FScopeLock Lock(&DataSinksLock);
+		Sinks = MoveTemp(DataSinks);
+	}
+	if (Sinks.IsValid())
+	{
+		for (const TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>& Binding : *Sinks)
+		{
+			Binding->Close();
+		}
+	}
+
+	// Drop callbacks that arrive from now on and wait for any still running; nothing can block them any more
+	if (CallbackHandle)
+	{
+		TMoqHandleRegistry<UMoqSubscriber>::Get().Unregister(CallbackHandle);
+		CallbackHandle = nullptr;
+	}
+
 	if (SubscriberHandle)
 	{
 		moq_subscriber_destroy(SubscriberHandle);
@@ -29,59 +102,495 @@ void UMoqSubscriber::BeginDestroy()
 	Super::BeginDestroy();
 }
 
+void UMoqSubscriber::SetOverflowPolicy(EMoqOverflowPolicy Policy)
+{
+	OverflowPolicy.store(Policy, std::memory_order_relaxed);
+}
+
+EMoqOverflowPolicy UMoqSubscriber::GetOverflowPolicy() const
+{
+	return OverflowPolicy.load(std::memory_order_relaxed);
+}
+
+void UMoqSubscriber::SetReceiveMode(EMoqReceiveMode Mode)
+{
+	ReceiveMode.store(Mode, std::memory_order_relaxed);
+}
+
+EMoqReceiveMode UMoqSubscriber::GetReceiveMode() const
+{
+	return ReceiveMode.load(std::memory_order_relaxed);
+}
+
+void UMoqSubscriber::SetTrackContent(EMoqTrackContent Content)
+{
+	TrackContent = Content;
+}
+
+EMoqTrackContent UMoqSubscriber::GetTrackContent() const
+{
+	return TrackContent;
+}
+
+void UMoqSubscriber::SetReceiveStruct(const UScriptStruct* StructType)
+{
+	if (StructType == ReceiveStruct)
+	{
+		return;
+	}
+
+	ReceiveStruct = StructType;
+	ReceiveStructValue = StructType ? MakeShared<FStructOnScope>(StructType) : nullptr;
+	NumStructDecodeFailures = 0;
+}
+
+void UMoqSubscriber::AddDataSink(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& Sink, const FMoqDataSinkOptions& Options)
+{
+	TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe> Binding = MakeShared<FMoqDataSinkBinding, ESPMode::ThreadSafe>(Sink, Options);
+
+	FScopeLock Lock(&DataSinksLock);
+	TSharedRef<FMoqDataSinkList, ESPMode::ThreadSafe> NewSinks = DataSinks.IsValid()
+		? MakeShared<FMoqDataSinkList, ESPMode::ThreadSafe>(*DataSinks)
+		: MakeShared<FMoqDataSinkList, ESPMode::ThreadSafe>();
+	NewSinks->Add(Binding);
+	DataSinks = NewSinks;
+}
+
+void UMoqSubscriber::RemoveDataSink(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& Sink)
+{
+	FScopeLock Lock(&DataSinksLock);
+	if (!DataSinks.IsValid())
+	{
+		return;
+	}
+
+	TSharedRef<FMoqDataSinkList, ESPMode::ThreadSafe> NewSinks = MakeShared<FMoqDataSinkList, ESPMode::ThreadSafe>();
+	NewSinks->Reserve(DataSinks->Num());
+	for (const TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>& Binding : *DataSinks)
+	{
+		if (Binding->GetSink() == Sink)
+		{
+			Binding->Close();
+		}
+		else
+		{
+			NewSinks->Add(Binding);
+		}
+	}
+
+	if (NewSinks->Num() == 0)
+	{
+		DataSinks.Reset();
+	}
+	else
+	{
+		DataSinks = NewSinks;
+	}
+}
+
+void UMoqSubscriber::SetGameThreadDeliveryEnabled(bool bEnabled)
+{
+	bGameThreadDelivery.store(bEnabled, std::memory_order_relaxed);
+}
+
+bool UMoqSubscriber::IsGameThreadDeliveryEnabled() const
+{
+	return bGameThreadDelivery.load(std::memory_order_relaxed);
+}
+
+void UMoqSubscriber::SetAutoDispatchEnabled(bool bEnabled)
+{
+	bAutoDispatch.store(bEnabled, std::memory_order_relaxed);
+}
+
+bool UMoqSubscriber::IsAutoDispatchEnabled() const
+{
+	return bAutoDispatch.load(std::memory_order_relaxed);
+}
+
+void UMoqSubscriber::SetEnvelopeDecodingEnabled(bool bEnabled)
+{
+	bDecodeEnvelopes.store(bEnabled, std::memory_order_relaxed);
+}
+
+bool UMoqSubscriber::IsEnvelopeDecodingEnabled() const
+{
+	return bDecodeEnvelopes.load(std::memory_order_relaxed);
+}
+
+void UMoqSubscriber::AddCompressionDictionary(const TArray<uint8>& Dictionary)
+{
+	EnvelopeDecoder.AddDictionary(Dictionary);
+}
+
+bool UMoqSubscriber::TryDequeue(FMoqReceivedObject& OutObject)
+{
+	// An object the dispatch budget held back before auto dispatch was turned off is older than anything queued
+	if (TakeCarriedOverObject(OutObject) || ReceiveQueue.TryDequeue(OutObject) || LatestObject.TryTake(OutObject))
+	{
+		NumDelivered.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	return false;
+}
+
+int32 UMoqSubscriber::DrainInto(TArray<FMoqReceivedObject>& OutObjects, int32 MaxObjects)
+{
+	// Bound by what is queued now so a fast producer cannot keep the caller here
+	const int32 NumToDrain = FMath::Min(MaxObjects, ReceiveQueue.Num() + (bHasCarriedOverObject.load(std::memory_order_acquire) ? 2 : 1));
+	int32 NumDrained = 0;
+
+	FMoqReceivedObject Object;
+	while (NumDrained < NumToDrain && TryDequeue(Object))
+	{
+		OutObjects.Add(MoveTemp(Object));
+		++NumDrained;
+	}
+	return NumDrained;
+}
+
+TArray<FMoqReceivedMessage> UMoqSubscriber::PollMessages(int32 MaxMessages)
+{
+	TArray<FMoqReceivedObject> Objects;
+	DrainInto(Objects, MaxMessages > 0 ? MaxMessages : MAX_int32);
+
+	TArray<FMoqReceivedMessage> Messages;
+	Messages.Reserve(Objects.Num());
+	for (const FMoqReceivedObject& Object : Objects)
+	{
+		Messages.Add(MakeReceivedMessage(Object));
+	}
+	return Messages;
+}
+
+FMoqReceiveQueueStats UMoqSubscriber::GetReceiveQueueStats() const
+{
+	FMoqReceiveQueueStats Stats;
+	Stats.Capacity = ReceiveQueue.Capacity();
+	TOptional<double> CarriedOverArrivalTime;
+	{
+		FScopeLock Lock(&CarriedOverLock);
+		if (CarriedOverObject.IsSet())
+		{
+			CarriedOverArrivalTime = CarriedOverObject->ArrivalTime;
+		}
+	}
+
+	Stats.QueuedObjects = ReceiveQueue.Num() + (LatestObject.HasNewValue() ? 1 : 0) + (CarriedOverArrivalTime.IsSet() ? 1 : 0);
+	Stats.PeakQueuedObjects = ReceiveQueue.GetPeakNum();
+	Stats.ReceivedObjects = ReceiveQueue.GetNumEnqueued() + LatestObject.GetNumPublished();
+	Stats.DeliveredObjects = NumDelivered.load(std::memory_order_relaxed);
+	Stats.DroppedObjects = ReceiveQueue.GetNumDropped();
+	Stats.BlockedPushes = ReceiveQueue.GetNumBlocked();
+	Stats.SupersededObjects = LatestObject.GetNumSuperseded();
+	Stats.BudgetDeferrals = NumBudgetDeferrals;
+	// The oldest pending object is the one the budget carried over, if any, and the queue head otherwise
+	double OldestArrivalTime = 0.0;
+	const bool bHasBacklog = CarriedOverArrivalTime.IsSet()
+		? (OldestArrivalTime = CarriedOverArrivalTime.GetValue(), true)
+		: ReceiveQueue.PeekOldestTimestamp(OldestArrivalTime);
+	if (bHasBacklog)
+	{
+		Stats.BacklogAgeMs = static_cast<float>(FMath::Max(FPlatformTime::Seconds() - OldestArrivalTime, 0.0) * 1000.0);
+	}
+	Stats.MalformedObjects = NumMalformed.load(std::memory_order_relaxed);
+	Stats.CompressedBytes = EnvelopeDecoder.GetCompressedBytes();
+	Stats.DecompressedBytes = EnvelopeDecoder.GetDecompressedBytes();
+	Stats.DecompressionTimeMs = static_cast<float>(EnvelopeDecoder.GetDecompressionSeconds() * 1000.0);
+	Stats.KeyframeObjects = EnvelopeDecoder.GetNumKeyframes();
+	Stats.DeltaObjects = EnvelopeDecoder.GetNumDeltas();
+	Stats.SkippedDeltaObjects = EnvelopeDecoder.GetNumSkippedDeltas();
+	Stats.SkippedBeforeGroupStart = NumSkippedBeforeGroupStart.load(std::memory_order_relaxed);
+	Stats.ReceivedFragments = EnvelopeDecoder.GetReassembler().GetNumFragments();
+	Stats.ReassembledObjects = EnvelopeDecoder.GetReassembler().GetNumReassembled();
+	Stats.ReassemblyFailures = EnvelopeDecoder.GetReassembler().GetNumFailed();
+	Stats.ReassemblyBytes = EnvelopeDecoder.GetReassembler().GetPendingBytes();
+	Stats.FecRecoveredObjects = EnvelopeDecoder.GetFecDecoder().GetNumRecovered();
+	Stats.FecLostObjects = EnvelopeDecoder.GetFecDecoder().GetNumLost();
+	Stats.StructDecodeFailures = NumStructDecodeFailures;
+	return Stats;
+}
+
+void UMoqSubscriber::ApplyOptions(const FMoqSubscribeOptions& Options)
+{
+	if (SubscriberHandle)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UMoqSubscriber::ApplyOptions: Subscriber already active, receive queue capacity unchanged"));
+	}
+	else
+	{
+		ReceiveQueue.Reset(Options.ReceiveQueueCapacity);
+	}
+
+	SetOverflowPolicy(Options.OverflowPolicy);
+	SetReceiveMode(Options.ReceiveMode);
+	SetTrackContent(Options.Content);
+	SetGameThreadDeliveryEnabled(Options.bDeliverOnGameThread);
+	SetAutoDispatchEnabled(Options.bAutoDispatch);
+	SetEnvelopeDecodingEnabled(Options.bDecodeEnvelopes);
+	bWaitForGroupStart.store(Options.bJoinAtGroupStart, std::memory_order_relaxed);
+	EnvelopeDecoder.SetReassemblyLimits(Options.MaxReassemblyBytes, Options.ReassemblyTimeoutMs / 1000.0);
+}
+
+bool UMoqSubscriber::TakeCarriedOverObject(FMoqReceivedObject& OutObject)
+{
+	if (!bHasCarriedOverObject.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CarriedOverLock);
+	if (!CarriedOverObject.IsSet())
+	{
+		return false;
+	}
+
+	OutObject = MoveTemp(CarriedOverObject.GetValue());
+	CarriedOverObject.Reset();
+	bHasCarriedOverObject.store(false, std::memory_order_release);
+	return true;
+}
+
 void UMoqSubscriber::InitializeFromHandle(MoqSubscriber* Handle)
 {
 	SubscriberHandle = Handle;
 }
 
+int32 UMoqSubscriber::DispatchPendingEvents(double EndTimeSeconds)
+{
+	check(IsInGameThread());
+
+	// Only deliver what is already queued so a fast producer cannot keep us here forever
+	const int32 NumPending = ReceiveQueue.Num() + (bHasCarriedOverObject.load(std::memory_order_acquire) ? 1 : 0);
+	int32 NumDispatched = 0;
+
+	FMoqReceivedObject Object;
+	while (NumDispatched < NumPending)
+	{
+		if (!TakeCarriedOverObject(Object) && !ReceiveQueue.TryDequeue(Object))
+		{
+			break;
+		}
+
+		// Out of budget: keep the head of the backlog here, where its age can be reported, until the next call
+		if (FPlatformTime::Seconds() >= EndTimeSeconds)
+		{
+			FScopeLock Lock(&CarriedOverLock);
+			CarriedOverObject.Emplace(MoveTemp(Object));
+			bHasCarriedOverObject.store(true, std::memory_order_release);
+			++NumBudgetDeferrals;
+			break;
+		}
+
+		++NumDispatched;
+		DeliverObject(MoveTemp(Object));
+	}
+
+	// Conflated tracks contribute at most one object per drain: whatever arrived last
+	if (!bHasCarriedOverObject.load(std::memory_order_relaxed) && FPlatformTime::Seconds() < EndTimeSeconds && LatestObject.TryTake(Object))
+	{
+		++NumDispatched;
+		DeliverObject(MoveTemp(Object));
+	}
+
+	BroadcastBatch();
+
+	return NumDispatched;
+}
+
+void UMoqSubscriber::DeliverObject(FMoqReceivedObject&& Object)
+{
+	NumDelivered.fetch_add(1, std::memory_order_relaxed);
+
+	if (Object.ObjectId == 0)
+	{
+		OnGroupStarted.Broadcast(Object.GroupId);
+	}
+
+	// Always broadcast binary data; native listeners see the pooled buffer directly
+	const TConstArrayView<uint8> Payload = Object.GetData();
+	OnPayloadReceived.Broadcast(Payload);
+
+	if (ReceiveStructValue.IsValid() && OnStructReceived.IsBound())
+	{
+		// Say why once; a publisher built with another version of the struct fails every object the same way
+		FString Error;
+		uint8* Value = ReceiveStructValue->GetStructMemory();
+		if (MoqStructSerializer::Deserialize(ReceiveStruct, Payload, Value, NumStructDecodeFailures == 0 ? &Error : nullptr))
+		{
+			OnStructReceived.Broadcast(ReceiveStruct, Value);
+		}
+		else if (NumStructDecodeFailures++ == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Cannot decode object as %s: %s"), *ReceiveStruct->GetName(), *Error);
+		}
+	}
+
+	if (TrackContent != EMoqTrackContent::Text && OnDataReceived.IsBound())
+	{
+		DynamicPayloadScratch.Reset();
+		DynamicPayloadScratch.Append(Payload.GetData(), Payload.Num());
+		OnDataReceived.Broadcast(DynamicPayloadScratch);
+	}
+
+	// Decode lazily: only when someone listens for text and the track is not declared binary
+	FString Text;
+	if (TrackContent != EMoqTrackContent::Binary && OnTextReceived.IsBound() && MoqUtf8::DecodeToString(Payload, Text))
+	{
+		OnTextReceived.Broadcast(Text);
+	}
+
+	if (OnDataBatchReceived.IsBound() || OnPayloadBatchReceived.IsBound())
+	{
+		PendingBatch.Add(MoveTemp(Object));
+	}
+}
+
+void UMoqSubscriber::BroadcastBatch()
+{
+	if (PendingBatch.Num() == 0)
+	{
+		return;
+	}
+
+	OnPayloadBatchReceived.Broadcast(PendingBatch);
+
+	if (OnDataBatchReceived.IsBound())
+	{
+		TArray<FMoqReceivedMessage> Messages;
+		Messages.Reserve(PendingBatch.Num());
+		for (const FMoqReceivedObject& Object : PendingBatch)
+		{
+			Messages.Add(MakeReceivedMessage(Object));
+		}
+		OnDataBatchReceived.Broadcast(Messages);
+	}
+
+	// Keep the allocation for the next frame, but hand the pooled payloads back now
+	PendingBatch.Reset();
+}
+
 void UMoqSubscriber::OnDataReceivedCallback(void* UserData, const uint8_t* Data, size_t DataLen)
+{
+	ReceiveData(UserData, Data, DataLen, true);
+}
+
+void UMoqSubscriber::OnAggregatedDataReceived(void* UserData, const uint8_t* Data, size_t DataLen)
+{
+	ReceiveData(UserData, Data, DataLen, false);
+}
+
+void UMoqSubscriber::ReceiveData(void* UserData, const uint8_t* Data, size_t DataLen, bool bMayBlock)
 {
 	if (!UserData || !Data || DataLen == 0)
 	{
 		return;
 	}
 	
-	UMoqSubscriber* Subscriber = static_cast<UMoqSubscriber*>(UserData);
-	// Validate that the object is still valid
-	if (!IsValid(Subscriber))
+	// Resolve the handle without touching UObject state; the pin keeps BeginDestroy waiting until we return
+	TMoqHandleRegistry<UMoqSubscriber>::FPin Subscriber = TMoqHandleRegistry<UMoqSubscriber>::Get().Pin(UserData);
+	if (!Subscriber)
 	{
 		return;
 	}
 
-	// Copy data to TArray
-	TArray<uint8> DataArray;
-	DataArray.Append(Data, DataLen);
+	// The only copy on the receive path: out of the moq-ffi buffer into a pooled block.
+	// Text decoding is deferred to the game thread drain, where we know whether anyone wants it.
+	FSharedBuffer Payload = FMoqPayloadPool::Get().CopyFrom(Data, DataLen);
+	const double ArrivalTime = FPlatformTime::Seconds();
+	EMoqOverflowPolicy Policy = Subscriber->OverflowPolicy.load(std::memory_order_relaxed);
+	if (!bMayBlock && Policy == EMoqOverflowPolicy::Block)
+	{
+		Policy = EMoqOverflowPolicy::DropNewest;
+	}
 
-	// Try to decode as UTF-8 text with validation
-	FString TextData;
-	bool bIsValidText = false;
+	TSharedPtr<const FMoqDataSinkList, ESPMode::ThreadSafe> Sinks;
+	{
+		FScopeLock Lock(&Subscriber->DataSinksLock);
+		Sinks = Subscriber->DataSinks;
+	}
 
-	// Validate UTF-8 by checking for valid conversion
-	// FUTF8ToTCHAR performs validation during conversion
-	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data), DataLen);
-	if (Converter.Length() > 0)
+	// Decoded under ReceiveLock and delivered after it, so a push waiting for queue space does not hold up
+	// the other thread that delivers this track
+	TArray<FMoqDecodedObject, TInlineAllocator<1>> Accepted;
 	{
-		TextData = FString(Converter.Length(), Converter.Get());
-		// Basic validation: check for replacement characters which indicate invalid UTF-8
-		if (!TextData.Contains(TEXT("\uFFFD")))
+		FScopeLock ReceiveScope(&Subscriber->ReceiveLock);
+
+		// Framed objects are split into the payloads that were published, each delivered as its own object
+		if (Subscriber->bDecodeEnvelopes.load(std::memory_order_relaxed) && MoqEnvelope::IsEnvelope(MakeArrayView(Data, static_cast<int32>(DataLen))))
 		{
-			bIsValidText = true;
+			TArray<FMoqDecodedObject> Decoded;
+			if (!Subscriber->EnvelopeDecoder.Decode(Payload, Decoded))
+			{
+				Subscriber->NumMalformed.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			for (FMoqDecodedObject& Unpacked : Decoded)
+			{
+				if (Subscriber->AcceptPayload(Unpacked))
+				{
+					Accepted.Add(MoveTemp(Unpacked));
+				}
+			}
+		}
+		else
+		{
+			Accepted.Add(FMoqDecodedObject{ MoveTemp(Payload) });
+		}
+	}
+
+	for (FMoqDecodedObject& Object : Accepted)
+	{
+		Subscriber->DeliverPayload(MoveTemp(Object), ArrivalTime, Sinks.Get(), Policy);
+	}
+}
+
+bool UMoqSubscriber::AcceptPayload(const FMoqDecodedObject& Decoded)
+{
+	// Joined in the middle of a group: nothing before the next group start is guaranteed to make sense on its own
+	if (bWaitForGroupStart.load(std::memory_order_relaxed) && Decoded.GroupId != INDEX_NONE)
+	{
+		if (Decoded.ObjectId != 0)
+		{
+			NumSkippedBeforeGroupStart.fetch_add(1, std::memory_order_relaxed);
+			return false;
 		}
+		bWaitForGroupStart.store(false, std::memory_order_relaxed);
 	}
+	return true;
+}
 
-	// Broadcast on game thread
-	AsyncTask(ENamedThreads::GameThread, [Subscriber, DataArray, TextData, bIsValidText]()
+void UMoqSubscriber::DeliverPayload(FMoqDecodedObject&& Decoded, double ArrivalTime, const FMoqDataSinkList* Sinks, EMoqOverflowPolicy Policy)
+{
+
+	// Native sinks see the shared buffer first, on this thread or their own worker
+	if (Sinks)
 	{
-		if (IsValid(Subscriber))
+		for (const TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>& Binding : *Sinks)
 		{
-			// Always broadcast binary data
-			Subscriber->OnDataReceived.Broadcast(DataArray);
+			Binding->Deliver(Decoded.Payload, Policy);
+		}
+	}
 
-			// Broadcast text if it was valid UTF-8
-			if (bIsValidText)
-			{
-				Subscriber->OnTextReceived.Broadcast(TextData);
-			}
+	// Hand off to the game thread drain
+	if (bGameThreadDelivery.load(std::memory_order_relaxed))
+	{
+		FMoqReceivedObject Object;
+		Object.Payload = MoveTemp(Decoded.Payload);
+		Object.GroupId = Decoded.GroupId;
+		Object.ObjectId = Decoded.ObjectId;
+		Object.ArrivalTime = ArrivalTime;
+		Object.Sequence = NextSequence.fetch_add(1, std::memory_order_relaxed);
+		if (ReceiveMode.load(std::memory_order_relaxed) == EMoqReceiveMode::Conflate)
+		{
+			// Never waits, and the mailbox takes one producer at a time
+			FScopeLock ReceiveScope(&ReceiveLock);
+			LatestObject.Exchange(MoveTemp(Object));
 		}
-	});
+		else
+		{
+			ReceiveQueue.Enqueue(MoveTemp(Object), Policy, ArrivalTime);
+		}
+	}
 }
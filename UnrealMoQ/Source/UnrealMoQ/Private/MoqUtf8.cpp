@@ -0,0 +1,545 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqUtf8.h"
+#include "HAL/UnrealMemory.h"
+
+#if PLATFORM_CPU_X86_FAMILY && defined(PLATFORM_ALWAYS_HAS_AVX_2) && PLATFORM_ALWAYS_HAS_AVX_2
+	#define MOQ_UTF8_AVX2 1
+#elif PLATFORM_CPU_X86_FAMILY && defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1
+	#define MOQ_UTF8_SSE4 1
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+	#define MOQ_UTF8_NEON 1
+#endif
+
+#ifndef MOQ_UTF8_AVX2
+	#define MOQ_UTF8_AVX2 0
+#endif
+#ifndef MOQ_UTF8_SSE4
+	#define MOQ_UTF8_SSE4 0
+#endif
+#ifndef MOQ_UTF8_NEON
+	#define MOQ_UTF8_NEON 0
+#endif
+
+#if MOQ_UTF8_AVX2 || MOQ_UTF8_SSE4
+	#include <immintrin.h>
+#elif MOQ_UTF8_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace MoqUtf8
+{
+namespace Private
+{
+/**
+ * Error classes for the lookup algorithm. A (previous byte, current byte) pair is invalid when the
+ * three nibble lookups below share a set bit. See "Validating UTF-8 In Less Than One Instruction Per Byte".
+ */
+constexpr uint8 TooShort = 1 << 0;
+constexpr uint8 TooLong = 1 << 1;
+constexpr uint8 Overlong3 = 1 << 2;
+constexpr uint8 TooLarge = 1 << 3;
+constexpr uint8 Surrogate = 1 << 4;
+constexpr uint8 Overlong2 = 1 << 5;
+constexpr uint8 TooLarge1000 = 1 << 6;
+constexpr uint8 Overlong4 = 1 << 6;
+constexpr uint8 TwoConts = 1 << 7;
+constexpr uint8 Carry = TooShort | TooLong | TwoConts;
+
+/** Indexed by the high nibble of the previous byte */
+alignas(16) constexpr uint8 Byte1HighTable[16] =
+{
+	TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+	TwoConts, TwoConts, TwoConts, TwoConts,
+	TooShort | Overlong2,
+	TooShort,
+	TooShort | Overlong3 | Surrogate,
+	TooShort | TooLarge | TooLarge1000 | Overlong4
+};
+
+/** Indexed by the low nibble of the previous byte */
+alignas(16) constexpr uint8 Byte1LowTable[16] =
+{
+	Carry | Overlong3 | Overlong2 | Overlong4,
+	Carry | Overlong2,
+	Carry,
+	Carry,
+	Carry | TooLarge,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000 | Surrogate,
+	Carry | TooLarge | TooLarge1000,
+	Carry | TooLarge | TooLarge1000
+};
+
+/** Indexed by the high nibble of the current byte */
+alignas(16) constexpr uint8 Byte2HighTable[16] =
+{
+	TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+	TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1000 | Overlong4,
+	TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+	TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+	TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+	TooShort, TooShort, TooShort, TooShort
+};
+
+/** A block is incomplete if it ends inside a multi-byte sequence; bytes above these limits start one */
+alignas(32) constexpr uint8 IncompleteLimits[32] =
+{
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+#if MOQ_UTF8_AVX2
+struct FAvx2
+{
+	using FVector = __m256i;
+	static constexpr int32 Width = 32;
+
+	static FORCEINLINE FVector Load(const uint8* Ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Ptr)); }
+	static FORCEINLINE FVector Zero() { return _mm256_setzero_si256(); }
+	static FORCEINLINE FVector Splat(uint8 Value) { return _mm256_set1_epi8(static_cast<char>(Value)); }
+	static FORCEINLINE FVector Table(const uint8* Ptr) { return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(Ptr))); }
+	static FORCEINLINE FVector Limits() { return Load(IncompleteLimits); }
+	static FORCEINLINE FVector Or(FVector A, FVector B) { return _mm256_or_si256(A, B); }
+	static FORCEINLINE FVector And(FVector A, FVector B) { return _mm256_and_si256(A, B); }
+	static FORCEINLINE FVector Xor(FVector A, FVector B) { return _mm256_xor_si256(A, B); }
+	static FORCEINLINE FVector SaturatingSub(FVector A, FVector B) { return _mm256_subs_epu8(A, B); }
+	static FORCEINLINE FVector HighNibble(FVector V) { return _mm256_and_si256(_mm256_srli_epi16(V, 4), Splat(0x0F)); }
+	static FORCEINLINE FVector LowNibble(FVector V) { return _mm256_and_si256(V, Splat(0x0F)); }
+	static FORCEINLINE FVector Lookup(FVector InTable, FVector Index) { return _mm256_shuffle_epi8(InTable, Index); }
+	static FORCEINLINE bool IsAscii(FVector V) { return _mm256_movemask_epi8(V) == 0; }
+	static FORCEINLINE bool AnyBitSet(FVector V) { return !_mm256_testz_si256(V, V); }
+
+	template <int32 N>
+	static FORCEINLINE FVector Prev(FVector Input, FVector PrevInput)
+	{
+		return _mm256_alignr_epi8(Input, _mm256_permute2x128_si256(PrevInput, Input, 0x21), 16 - N);
+	}
+};
+using FActiveKernel = FAvx2;
+#elif MOQ_UTF8_SSE4
+struct FSse4
+{
+	using FVector = __m128i;
+	static constexpr int32 Width = 16;
+
+	static FORCEINLINE FVector Load(const uint8* Ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(Ptr)); }
+	static FORCEINLINE FVector Zero() { return _mm_setzero_si128(); }
+	static FORCEINLINE FVector Splat(uint8 Value) { return _mm_set1_epi8(static_cast<char>(Value)); }
+	static FORCEINLINE FVector Table(const uint8* Ptr) { return _mm_load_si128(reinterpret_cast<const __m128i*>(Ptr)); }
+	static FORCEINLINE FVector Limits() { return Load(IncompleteLimits + 16); }
+	static FORCEINLINE FVector Or(FVector A, FVector B) { return _mm_or_si128(A, B); }
+	static FORCEINLINE FVector And(FVector A, FVector B) { return _mm_and_si128(A, B); }
+	static FORCEINLINE FVector Xor(FVector A, FVector B) { return _mm_xor_si128(A, B); }
+	static FORCEINLINE FVector SaturatingSub(FVector A, FVector B) { return _mm_subs_epu8(A, B); }
+	static FORCEINLINE FVector HighNibble(FVector V) { return _mm_and_si128(_mm_srli_epi16(V, 4), Splat(0x0F)); }
+	static FORCEINLINE FVector LowNibble(FVector V) { return _mm_and_si128(V, Splat(0x0F)); }
+	static FORCEINLINE FVector Lookup(FVector InTable, FVector Index) { return _mm_shuffle_epi8(InTable, Index); }
+	static FORCEINLINE bool IsAscii(FVector V) { return _mm_movemask_epi8(V) == 0; }
+	static FORCEINLINE bool AnyBitSet(FVector V) { return !_mm_testz_si128(V, V); }
+
+	template <int32 N>
+	static FORCEINLINE FVector Prev(FVector Input, FVector PrevInput)
+	{
+		return _mm_alignr_epi8(Input, PrevInput, 16 - N);
+	}
+};
+using FActiveKernel = FSse4;
+#elif MOQ_UTF8_NEON
+struct FNeon
+{
+	using FVector = uint8x16_t;
+	static constexpr int32 Width = 16;
+
+	static FORCEINLINE FVector Load(const uint8* Ptr) { return vld1q_u8(Ptr); }
+	static FORCEINLINE FVector Zero() { return vdupq_n_u8(0); }
+	static FORCEINLINE FVector Splat(uint8 Value) { return vdupq_n_u8(Value); }
+	static FORCEINLINE FVector Table(const uint8* Ptr) { return vld1q_u8(Ptr); }
+	static FORCEINLINE FVector Limits() { return Load(IncompleteLimits + 16); }
+	static FORCEINLINE FVector Or(FVector A, FVector B) { return vorrq_u8(A, B); }
+	static FORCEINLINE FVector And(FVector A, FVector B) { return vandq_u8(A, B); }
+	static FORCEINLINE FVector Xor(FVector A, FVector B) { return veorq_u8(A, B); }
+	static FORCEINLINE FVector SaturatingSub(FVector A, FVector B) { return vqsubq_u8(A, B); }
+	static FORCEINLINE FVector HighNibble(FVector V) { return vshrq_n_u8(V, 4); }
+	static FORCEINLINE FVector LowNibble(FVector V) { return vandq_u8(V, Splat(0x0F)); }
+	static FORCEINLINE FVector Lookup(FVector InTable, FVector Index) { return vqtbl1q_u8(InTable, Index); }
+	static FORCEINLINE bool IsAscii(FVector V) { return vmaxvq_u8(V) < 0x80; }
+	static FORCEINLINE bool AnyBitSet(FVector V) { return vmaxvq_u8(V) != 0; }
+
+	template <int32 N>
+	static FORCEINLINE FVector Prev(FVector Input, FVector PrevInput)
+	{
+		return vextq_u8(PrevInput, Input, 16 - N);
+	}
+};
+using FActiveKernel = FNeon;
+#endif
+
+#if MOQ_UTF8_AVX2 || MOQ_UTF8_SSE4 || MOQ_UTF8_NEON
+template <typename Kernel>
+class TVectorValidator
+{
+public:
+	using FVector = typename Kernel::FVector;
+
+	TVectorValidator()
+		: Error(Kernel::Zero())
+		, PrevInput(Kernel::Zero())
+		, PrevIncomplete(Kernel::Zero())
+		, Byte1High(Kernel::Table(Byte1HighTable))
+		, Byte1Low(Kernel::Table(Byte1LowTable))
+		, Byte2High(Kernel::Table(Byte2HighTable))
+		, Limits(Kernel::Limits())
+	{
+	}
+
+	FORCEINLINE void Step(FVector Input)
+	{
+		if (Kernel::IsAscii(Input))
+		{
+			// ASCII cannot continue a sequence the previous block left open
+			Error = Kernel::Or(Error, PrevIncomplete);
+			PrevIncomplete = Kernel::Zero();
+		}
+		else
+		{
+			Error = Kernel::Or(Error, CheckBlock(Input));
+			PrevIncomplete = Kernel::SaturatingSub(Input, Limits);
+		}
+		PrevInput = Input;
+	}
+
+	FORCEINLINE bool Finish()
+	{
+		return !Kernel::AnyBitSet(Kernel::Or(Error, PrevIncomplete));
+	}
+
+private:
+	FORCEINLINE FVector CheckBlock(FVector Input) const
+	{
+		const FVector Prev1 = Kernel::template Prev<1>(Input, PrevInput);
+		const FVector SpecialCases = Kernel::And(
+			Kernel::And(Kernel::Lookup(Byte1High, Kernel::HighNibble(Prev1)), Kernel::Lookup(Byte1Low, Kernel::LowNibble(Prev1))),
+			Kernel::Lookup(Byte2High, Kernel::HighNibble(Input)));
+
+		// Continuations in third/fourth position are legal only after a 3- or 4-byte lead
+		const FVector Prev2 = Kernel::template Prev<2>(Input, PrevInput);
+		const FVector Prev3 = Kernel::template Prev<3>(Input, PrevInput);
+		const FVector IsThirdByte = Kernel::SaturatingSub(Prev2, Kernel::Splat(0xE0 - 0x80));
+		const FVector IsFourthByte = Kernel::SaturatingSub(Prev3, Kernel::Splat(0xF0 - 0x80));
+		const FVector MustBeContinuation = Kernel::And(Kernel::Or(IsThirdByte, IsFourthByte), Kernel::Splat(0x80));
+
+		return Kernel::Xor(MustBeContinuation, SpecialCases);
+	}
+
+	FVector Error;
+	FVector PrevInput;
+	FVector PrevIncomplete;
+	FVector Byte1High;
+	FVector Byte1Low;
+	FVector Byte2High;
+	FVector Limits;
+};
+
+template <typename Kernel>
+bool IsValidVector(const uint8* Data, int32 Length)
+{
+	TVectorValidator<Kernel> Validator;
+
+	int32 Offset = 0;
+	for (; Offset + Kernel::Width <= Length; Offset += Kernel::Width)
+	{
+		Validator.Step(Kernel::Load(Data + Offset));
+	}
+
+	if (Offset < Length)
+	{
+		// Zero padding is ASCII, so a sequence truncated by the end of input still reads as too short
+		alignas(32) uint8 Tail[Kernel::Width] = {};
+		FMemory::Memcpy(Tail, Data + Offset, Length - Offset);
+		Validator.Step(Kernel::Load(Tail));
+	}
+
+	return Validator.Finish();
+}
+#endif
+
+FORCEINLINE void WidenScalar16(const uint8* Src, TCHAR* Dest)
+{
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		Dest[Index] = static_cast<TCHAR>(Src[Index]);
+	}
+}
+
+/** Widen 16 bytes if they are all ASCII; returns false (writing nothing) otherwise */
+FORCEINLINE bool TryWidenAscii16(const uint8* Src, TCHAR* Dest)
+{
+#if MOQ_UTF8_AVX2 || MOQ_UTF8_SSE4
+	const __m128i Input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Src));
+	if (_mm_movemask_epi8(Input) != 0)
+	{
+		return false;
+	}
+	if constexpr (sizeof(TCHAR) == 2)
+	{
+		const __m128i Zero = _mm_setzero_si128();
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest), _mm_unpacklo_epi8(Input, Zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(Dest + 8), _mm_unpackhi_epi8(Input, Zero));
+	}
+	else
+	{
+		WidenScalar16(Src, Dest);
+	}
+	return true;
+#elif MOQ_UTF8_NEON
+	const uint8x16_t Input = vld1q_u8(Src);
+	if (vmaxvq_u8(Input) >= 0x80)
+	{
+		return false;
+	}
+	if constexpr (sizeof(TCHAR) == 2)
+	{
+		vst1q_u16(reinterpret_cast<uint16*>(Dest), vmovl_u8(vget_low_u8(Input)));
+		vst1q_u16(reinterpret_cast<uint16*>(Dest + 8), vmovl_u8(vget_high_u8(Input)));
+	}
+	else
+	{
+		WidenScalar16(Src, Dest);
+	}
+	return true;
+#else
+	uint64 Words[2];
+	FMemory::Memcpy(Words, Src, sizeof(Words));
+	if (((Words[0] | Words[1]) & 0x8080808080808080ull) != 0)
+	{
+		return false;
+	}
+	WidenScalar16(Src, Dest);
+	return true;
+#endif
+}
+}
+
+bool IsValidScalar(TConstArrayView<uint8> Data)
+{
+	const int32 Length = Data.Num();
+	if (Length <= 0 || Data.GetData() == nullptr)
+	{
+		return true;
+	}
+
+	const uint8* Ptr = Data.GetData();
+	const uint8* End = Ptr + Length;
+
+	while (Ptr < End)
+	{
+		const uint8 Byte = *Ptr++;
+		if ((Byte & 0x80) == 0)
+		{
+			continue; // ASCII
+		}
+
+		int32 ExpectedTrailing = 0;
+		uint32 CodePoint = 0;
+
+		if ((Byte & 0xE0) == 0xC0)
+		{
+			ExpectedTrailing = 1;
+			CodePoint = Byte & 0x1F;
+			if (CodePoint == 0)
+			{
+				return false; // Overlong encoding for ASCII
+			}
+		}
+		else if ((Byte & 0xF0) == 0xE0)
+		{
+			ExpectedTrailing = 2;
+			CodePoint = Byte & 0x0F;
+		}
+		else if ((Byte & 0xF8) == 0xF0)
+		{
+			ExpectedTrailing = 3;
+			CodePoint = Byte & 0x07;
+		}
+		else
+		{
+			return false; // Invalid leading byte
+		}
+
+		if (Ptr + ExpectedTrailing > End)
+		{
+			return false; // Truncated sequence
+		}
+
+		for (int32 Index = 0; Index < ExpectedTrailing; ++Index)
+		{
+			const uint8 Trail = *Ptr++;
+			if ((Trail & 0xC0) != 0x80)
+			{
+				return false; // Invalid continuation byte
+			}
+			CodePoint = (CodePoint << 6) | (Trail & 0x3F);
+		}
+
+		// Reject overlong encodings
+		if ((ExpectedTrailing == 1 && CodePoint < 0x80) ||
+			(ExpectedTrailing == 2 && CodePoint < 0x800) ||
+			(ExpectedTrailing == 3 && CodePoint < 0x10000))
+		{
+			return false;
+		}
+
+		if (CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+		{
+			return false; // Outside Unicode range or surrogate pairs
+		}
+	}
+
+	return true;
+}
+
+bool IsValid(TConstArrayView<uint8> Data)
+{
+	if (Data.Num() <= 0 || Data.GetData() == nullptr)
+	{
+		return true;
+	}
+
+#if MOQ_UTF8_AVX2 || MOQ_UTF8_SSE4 || MOQ_UTF8_NEON
+	return Private::IsValidVector<Private::FActiveKernel>(Data.GetData(), Data.Num());
+#else
+	return IsValidScalar(Data);
+#endif
+}
+
+bool DecodeToString(TConstArrayView<uint8> Data, FString& OutText)
+{
+	OutText.Reset();
+
+	const int32 Length = Data.Num();
+	if (Length <= 0 || Data.GetData() == nullptr)
+	{
+		return true;
+	}
+
+	// Every UTF-8 byte produces at most one TCHAR (a 4-byte sequence becomes a surrogate pair at most)
+	auto& Chars = OutText.GetCharArray();
+	Chars.SetNumUninitialized(Length + 1);
+
+	const uint8* Ptr = Data.GetData();
+	const uint8* End = Ptr + Length;
+	TCHAR* Out = Chars.GetData();
+
+	while (Ptr < End)
+	{
+		// ASCII fast path, 16 bytes at a time
+		while (End - Ptr >= 16 && Private::TryWidenAscii16(Ptr, Out))
+		{
+			Ptr += 16;
+			Out += 16;
+		}
+
+		if (Ptr >= End)
+		{
+			break;
+		}
+
+		const uint8 Lead = *Ptr;
+		if (Lead < 0x80)
+		{
+			*Out++ = static_cast<TCHAR>(Lead);
+			++Ptr;
+			continue;
+		}
+
+		int32 NumTrailing;
+		uint32 CodePoint;
+		uint32 MinCodePoint;
+		if (Lead >= 0xC2 && Lead <= 0xDF)
+		{
+			NumTrailing = 1;
+			CodePoint = Lead & 0x1F;
+			MinCodePoint = 0x80;
+		}
+		else if ((Lead & 0xF0) == 0xE0)
+		{
+			NumTrailing = 2;
+			CodePoint = Lead & 0x0F;
+			MinCodePoint = 0x800;
+		}
+		else if (Lead >= 0xF0 && Lead <= 0xF4)
+		{
+			NumTrailing = 3;
+			CodePoint = Lead & 0x07;
+			MinCodePoint = 0x10000;
+		}
+		else
+		{
+			OutText.Reset();
+			return false;
+		}
+
+		if (End - Ptr <= NumTrailing)
+		{
+			OutText.Reset();
+			return false;
+		}
+
+		for (int32 Index = 1; Index <= NumTrailing; ++Index)
+		{
+			const uint8 Trail = Ptr[Index];
+			if ((Trail & 0xC0) != 0x80)
+			{
+				OutText.Reset();
+				return false;
+			}
+			CodePoint = (CodePoint << 6) | (Trail & 0x3F);
+		}
+
+		if (CodePoint < MinCodePoint || CodePoint > 0x10FFFF || (CodePoint >= 0xD800 && CodePoint <= 0xDFFF))
+		{
+			OutText.Reset();
+			return false;
+		}
+
+		Ptr += NumTrailing + 1;
+
+		if (sizeof(TCHAR) == 2 && CodePoint >= 0x10000)
+		{
+			CodePoint -= 0x10000;
+			*Out++ = static_cast<TCHAR>(0xD800 + (CodePoint >> 10));
+			*Out++ = static_cast<TCHAR>(0xDC00 + (CodePoint & 0x3FF));
+		}
+		else
+		{
+			*Out++ = static_cast<TCHAR>(CodePoint);
+		}
+	}
+
+	const int32 NumChars = static_cast<int32>(Out - Chars.GetData());
+	Chars[NumChars] = TCHAR('\0');
+	Chars.SetNum(NumChars + 1, EAllowShrinking::No);
+	return true;
+}
+
+const TCHAR* GetKernelName()
+{
+#if MOQ_UTF8_AVX2
+	return TEXT("AVX2");
+#elif MOQ_UTF8_SSE4
+	return TEXT("SSE4.1");
+#elif MOQ_UTF8_NEON
+	return TEXT("NEON");
+#else
+	return TEXT("Scalar");
+#endif
+}
+}
@@ -0,0 +1,373 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HAL/PlatformProcess.h"
+#include "Misc/AutomationTest.h"
+#include "MoqPayloadPool.h"
+#include "MoqPublishSender.h"
+#include "MoqRateLimiter.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderFailFastTest, "UnrealMoQ.PublishSender.Backpressure.FailFast", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderDropNewestTest, "UnrealMoQ.PublishSender.Backpressure.DropNewest", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderDropOldestTest, "UnrealMoQ.PublishSender.Backpressure.DropOldest", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderCoalesceLatestTest, "UnrealMoQ.PublishSender.Backpressure.CoalesceLatest", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderEvictBehindPacedObjectTest, "UnrealMoQ.PublishSender.Backpressure.EvictBehindPacedObject", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqRateLimiterBurstTest, "UnrealMoQ.PublishSender.RateLimiter.Burst", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqRateLimiterObjectRateTest, "UnrealMoQ.PublishSender.RateLimiter.ObjectRate", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqRateLimiterOversizeDebtTest, "UnrealMoQ.PublishSender.RateLimiter.OversizeDebt", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqRateLimiterClientAggregateTest, "UnrealMoQ.PublishSender.RateLimiter.ClientAggregate", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderPriorityOrderTest, "UnrealMoQ.PublishSender.Priority.Order", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublishSenderQueueDelayTest, "UnrealMoQ.PublishSender.Priority.MaxQueueDelay", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+namespace MoqPublishSenderTest
+{
+	/** Keeps the sender thread away from send states the test drives itself */
+	struct FScopedPausedSender
+	{
+		FScopedPausedSender() { FMoqPublishSender::Get().SetPaused(true); }
+		~FScopedPausedSender() { FMoqPublishSender::Get().SetPaused(false); }
+	};
+
+	/**
+	 * Async send state without a moq-ffi handle. Nothing may reach moq_publish_data, so the queue
+	 * delay is short and every test lets its objects expire before the sender resumes.
+	 */
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> MakeState(EMoqBackpressurePolicy Policy, int32 MaxQueuedObjects,
+		TSharedPtr<FMoqRateLimiter, ESPMode::ThreadSafe> ClientRateLimiter = nullptr)
+	{
+		FMoqPublishOptions Options;
+		Options.Mode = EMoqPublishMode::Async;
+		Options.MaxQueuedObjects = MaxQueuedObjects;
+		Options.MaxQueuedBytes = 0;
+		Options.BackpressurePolicy = Policy;
+		Options.MaxQueueDelayMs = 50.0f;
+		return MakeShared<FMoqPublisherSendState, ESPMode::ThreadSafe>(nullptr, nullptr, Options, MoveTemp(ClientRateLimiter));
+	}
+
+	/** Limiter with an empty byte bucket for the next 100 seconds, so every object sent under it is held */
+	TSharedRef<FMoqRateLimiter, ESPMode::ThreadSafe> MakeExhaustedLimiter()
+	{
+		FMoqRateLimit Limit;
+		Limit.BytesPerSecond = 1000;
+		Limit.BurstMs = 100.0f;
+
+		TSharedRef<FMoqRateLimiter, ESPMode::ThreadSafe> Limiter = MakeShared<FMoqRateLimiter, ESPMode::ThreadSafe>();
+		Limiter->SetLimit(Limit);
+		Limiter->Consume(100000, FPlatformTime::Seconds());
+		return Limiter;
+	}
+
+	/** Rate limit of 1000 bytes per second with a 100 byte bucket; returns a time at which the bucket is full */
+	double SetByteLimit(FMoqRateLimiter& Limiter)
+	{
+		FMoqRateLimit Limit;
+		Limit.BytesPerSecond = 1000;
+		Limit.BurstMs = 100.0f;
+		Limiter.SetLimit(Limit);
+
+		// Buckets start full and refill from the time of SetLimit, so any later time sees them full
+		return FPlatformTime::Seconds();
+	}
+
+	FMoqResult EnqueueByte(FMoqPublisherSendState& State, uint8 Value)
+	{
+		return State.Enqueue(FMoqPayloadPool::Get().CopyFrom(&Value, 1), EMoqDeliveryMode::Stream);
+	}
+
+	/** Let everything still queued expire and drain it, so the sender finds nothing to send */
+	int64 ExpireAll(FMoqPublisherSendState& State)
+	{
+		FPlatformProcess::Sleep(0.06f);
+		State.SendPending(MAX_int32);
+		return State.GetStats().ExpiredObjects;
+	}
+
+	/** Fill a window of two objects, then publish a third with Policy */
+	FMoqResult OverfillWindow(FAutomationTestBase& Test, FMoqPublisherSendState& State)
+	{
+		Test.TestTrue(TEXT("First object fits the window"), EnqueueByte(State, 1).bSuccess);
+		Test.TestTrue(TEXT("Second object fits the window"), EnqueueByte(State, 2).bSuccess);
+		Test.TestFalse(TEXT("Window not full yet"), State.IsBackpressured());
+
+		const FMoqResult Result = EnqueueByte(State, 3);
+		Test.TestTrue(TEXT("Full window raises backpressure"), State.IsBackpressured());
+		return Result;
+	}
+}
+
+bool FMoqPublishSenderFailFastTest::RunTest(const FString& Parameters)
+{
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State = MakeState(EMoqBackpressurePolicy::FailFast, 2);
+
+	const FMoqResult Result = OverfillWindow(*this, *State);
+	TestFalse(TEXT("Publish into a full window fails"), Result.bSuccess);
+	TestEqual(TEXT("Failure says the queue is full"), Result.ErrorMessage, FString(TEXT("Publish queue is full")));
+
+	const FMoqPublisherStats Stats = State->GetStats();
+	TestEqual(TEXT("Queued objects kept"), Stats.QueuedObjects, 2);
+	TestEqual(TEXT("Refused object counted as dropped"), Stats.DroppedObjects, static_cast<int64>(1));
+
+	TestEqual(TEXT("Both queued objects expire"), ExpireAll(*State), static_cast<int64>(2));
+	TestEqual(TEXT("Queue empty after expiry"), State->GetStats().QueuedObjects, 0);
+	return true;
+}
+
+bool FMoqPublishSenderDropNewestTest::RunTest(const FString& Parameters)
+{
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State = MakeState(EMoqBackpressurePolicy::DropNewest, 2);
+
+	const FMoqResult Result = OverfillWindow(*this, *State);
+	TestFalse(TEXT("Dropped publish is not reported as sent"), Result.bSuccess);
+	TestEqual(TEXT("Failure says the object was dropped"), Result.ErrorMessage, FString(TEXT("Publish dropped by backpressure")));
+
+	const FMoqPublisherStats Stats = State->GetStats();
+	TestEqual(TEXT("Queued objects kept"), Stats.QueuedObjects, 2);
+	TestEqual(TEXT("New object counted as dropped"), Stats.DroppedObjects, static_cast<int64>(1));
+
+	TestEqual(TEXT("Both queued objects expire"), ExpireAll(*State), static_cast<int64>(2));
+	return true;
+}
+
+bool FMoqPublishSenderDropOldestTest::RunTest(const FString& Parameters)
+{
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State = MakeState(EMoqBackpressurePolicy::DropOldest, 2);
+
+	const FMoqResult Result = OverfillWindow(*this, *State);
+	TestTrue(TEXT("New object takes the oldest one's place"), Result.bSuccess);
+
+	const FMoqPublisherStats Stats = State->GetStats();
+	TestEqual(TEXT("Window stays full"), Stats.QueuedObjects, 2);
+	TestEqual(TEXT("Oldest object counted as dropped"), Stats.DroppedObjects, static_cast<int64>(1));
+
+	TestEqual(TEXT("Remaining objects expire"), ExpireAll(*State), static_cast<int64>(2));
+	return true;
+}
+
+bool FMoqPublishSenderCoalesceLatestTest::RunTest(const FString& Parameters)
+{
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State = MakeState(EMoqBackpressurePolicy::CoalesceLatest, 2);
+
+	const FMoqResult Result = OverfillWindow(*this, *State);
+	TestTrue(TEXT("Latest object is queued"), Result.bSuccess);
+
+	const FMoqPublisherStats Stats = State->GetStats();
+	TestEqual(TEXT("Only the latest object is left"), Stats.QueuedObjects, 1);
+	TestEqual(TEXT("Every older object counted as dropped"), Stats.DroppedObjects, static_cast<int64>(2));
+
+	TestEqual(TEXT("Latest object expires"), ExpireAll(*State), static_cast<int64>(1));
+	return true;
+}
+
+bool FMoqPublishSenderEvictBehindPacedObjectTest::RunTest(const FString& Parameters)
+{
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> State = MakeState(EMoqBackpressurePolicy::DropOldest, 1, MakeExhaustedLimiter());
+
+	// The sender takes the first object off the ring and holds it until the limiter has tokens again
+	TestTrue(TEXT("First object queued"), EnqueueByte(*State, 1).bSuccess);
+	const FMoqPublisherSendState::FSendPass Pass = State->SendPending(MAX_int32);
+	TestTrue(TEXT("First object held for pacing"), Pass.WaitSeconds > 0.0);
+
+	// The held object no longer takes the one-object window, so a second fits and a third evicts it instead of spinning
+	TestTrue(TEXT("Second object fits behind the held one"), EnqueueByte(*State, 2).bSuccess);
+	TestTrue(TEXT("Third object evicts the second"), EnqueueByte(*State, 3).bSuccess);
+
+	const FMoqPublisherStats Stats = State->GetStats();
+	TestEqual(TEXT("Held and queued objects both counted"), Stats.QueuedObjects, 2);
+	TestEqual(TEXT("Held and queued bytes both counted"), Stats.QueuedBytes, static_cast<int64>(2));
+	TestEqual(TEXT("Second object counted as dropped"), Stats.DroppedObjects, static_cast<int64>(1));
+	TestEqual(TEXT("Held object counted as deferred"), Stats.DeferredObjects, static_cast<int64>(1));
+
+	TestEqual(TEXT("Held and queued objects expire"), ExpireAll(*State), static_cast<int64>(2));
+	TestEqual(TEXT("Nothing left queued"), State->GetStats().QueuedObjects, 0);
+	return true;
+}
+
+bool FMoqRateLimiterBurstTest::RunTest(const FString& Parameters)
+{
+	// Test that a full bucket releases a burst up to its capacity, then paces at the sustained rate
+	using namespace MoqPublishSenderTest;
+	FMoqRateLimiter Limiter;
+	TestFalse(TEXT("No limit by default"), Limiter.IsLimited());
+	TestEqual(TEXT("Unlimited limiter never waits"), Limiter.GetWaitSeconds(1000000, 0.0), 0.0);
+
+	const double Start = SetByteLimit(Limiter);
+	TestTrue(TEXT("Limited once a rate is set"), Limiter.IsLimited());
+
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		TestEqual(TEXT("Burst object sent without waiting"), Limiter.GetWaitSeconds(25, Start), 0.0);
+		Limiter.Consume(25, Start);
+	}
+
+	TestEqual(TEXT("Empty bucket waits for the object's bytes"), Limiter.GetWaitSeconds(25, Start), 0.025, 1e-6);
+	TestEqual(TEXT("Wait shrinks as tokens refill"), Limiter.GetWaitSeconds(25, Start + 0.01), 0.015, 1e-6);
+	TestEqual(TEXT("Refilled after the wait"), Limiter.GetWaitSeconds(25, Start + 0.025), 0.0, 1e-6);
+	TestEqual(TEXT("Refill stops at the bucket capacity"), Limiter.GetWaitSeconds(100, Start + 10.0), 0.0);
+
+	Limiter.Consume(100, Start + 10.0);
+	TestEqual(TEXT("Idle time does not earn more than one burst"), Limiter.GetWaitSeconds(1, Start + 10.0), 0.001, 1e-6);
+
+	const FMoqPacingStats Stats = Limiter.GetStats();
+	TestEqual(TEXT("Sent objects counted"), Stats.SentObjects, static_cast<int64>(5));
+	TestEqual(TEXT("Sent bytes counted"), Stats.SentBytes, static_cast<int64>(200));
+	return true;
+}
+
+bool FMoqRateLimiterObjectRateTest::RunTest(const FString& Parameters)
+{
+	// Test that the object bucket paces objects regardless of their size
+	FMoqRateLimit Limit;
+	Limit.ObjectsPerSecond = 10.0f;
+	Limit.BurstMs = 200.0f;
+
+	FMoqRateLimiter Limiter;
+	Limiter.SetLimit(Limit);
+	const double Start = FPlatformTime::Seconds();
+
+	TestEqual(TEXT("First object of the burst"), Limiter.GetWaitSeconds(1000000, Start), 0.0);
+	Limiter.Consume(1000000, Start);
+	TestEqual(TEXT("Second object of the burst"), Limiter.GetWaitSeconds(1, Start), 0.0);
+	Limiter.Consume(1, Start);
+
+	TestEqual(TEXT("Third object waits one object interval"), Limiter.GetWaitSeconds(1, Start), 0.1, 1e-6);
+	TestEqual(TEXT("Third object released after the interval"), Limiter.GetWaitSeconds(1, Start + 0.1), 0.0, 1e-6);
+	return true;
+}
+
+bool FMoqRateLimiterOversizeDebtTest::RunTest(const FString& Parameters)
+{
+	// Test that a full bucket lets an object larger than the bucket through and the overdraft is paid back before anything else
+	using namespace MoqPublishSenderTest;
+	FMoqRateLimiter Limiter;
+	const double Start = SetByteLimit(Limiter);
+
+	TestEqual(TEXT("Oversize object sent from a full bucket"), Limiter.GetWaitSeconds(300, Start), 0.0);
+	Limiter.Consume(300, Start);
+
+	// 200 bytes of debt plus the next object's 10 bytes at 1000 bytes per second
+	TestEqual(TEXT("Debt delays the next object"), Limiter.GetWaitSeconds(10, Start), 0.21, 1e-6);
+	TestEqual(TEXT("Debt paid off, object bytes still owed"), Limiter.GetWaitSeconds(10, Start + 0.2), 0.01, 1e-6);
+
+	// Half a bucket after 250ms; an oversize object needs only a full bucket, not its own size
+	TestEqual(TEXT("Oversize object waits for a full bucket"), Limiter.GetWaitSeconds(300, Start + 0.25), 0.05, 1e-6);
+	TestEqual(TEXT("Oversize object sent once the bucket is full"), Limiter.GetWaitSeconds(300, Start + 0.3), 0.0, 1e-6);
+
+	// The second overdraft is paid back like the first, so the long-run rate holds
+	Limiter.Consume(300, Start + 0.3);
+	TestEqual(TEXT("Second overdraft delays the next object"), Limiter.GetWaitSeconds(1, Start + 0.3), 0.201, 1e-6);
+	return true;
+}
+
+bool FMoqRateLimiterClientAggregateTest::RunTest(const FString& Parameters)
+{
+	// Test that publishers sharing a client limiter are paced by its aggregate bucket, even in immediate mode
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+	TSharedRef<FMoqRateLimiter, ESPMode::ThreadSafe> ClientLimiter = MakeExhaustedLimiter();
+
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> First = MakeState(EMoqBackpressurePolicy::FailFast, 4, ClientLimiter);
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> Second = MakeState(EMoqBackpressurePolicy::FailFast, 4, ClientLimiter);
+	Second->SetMode(EMoqPublishMode::Immediate);
+
+	TestTrue(TEXT("Client limit paces the first publisher"), First->IsPaced());
+	TestTrue(TEXT("Client limit makes an immediate publisher queue"), Second->ShouldQueue());
+
+	TestTrue(TEXT("First publisher queues"), EnqueueByte(*First, 1).bSuccess);
+	TestTrue(TEXT("Second publisher queues"), EnqueueByte(*Second, 2).bSuccess);
+	TestTrue(TEXT("First publisher waits for client tokens"), First->SendPending(MAX_int32).WaitSeconds > 0.0);
+	TestTrue(TEXT("Second publisher waits for client tokens"), Second->SendPending(MAX_int32).WaitSeconds > 0.0);
+
+	TestEqual(TEXT("First publisher deferred one object"), First->GetStats().DeferredObjects, static_cast<int64>(1));
+	TestEqual(TEXT("Second publisher deferred one object"), Second->GetStats().DeferredObjects, static_cast<int64>(1));
+	TestEqual(TEXT("Client limiter saw both deferrals"), ClientLimiter->GetStats().DeferredObjects, static_cast<int64>(2));
+	TestEqual(TEXT("Client limiter deferred bytes"), ClientLimiter->GetStats().DeferredBytes, static_cast<int64>(2));
+
+	TestEqual(TEXT("First publisher's object expires"), ExpireAll(*First), static_cast<int64>(1));
+	TestEqual(TEXT("Second publisher's object expires"), ExpireAll(*Second), static_cast<int64>(1));
+	return true;
+}
+
+bool FMoqPublishSenderPriorityOrderTest::RunTest(const FString& Parameters)
+{
+	// Test that the sender's ready list serves the lowest priority value first and equal priorities in push order
+	TMoqSendOrder<int32> Order;
+	Order.Push(2, 0);
+	Order.Push(0, 1);
+	Order.Push(2, 2);
+	Order.Push(0, 3);
+	Order.Push(1, 4);
+	TestEqual(TEXT("All items queued"), Order.Num(), 5);
+
+	const int32 Expected[] = { 1, 3, 4, 0, 2 };
+	for (const int32 Item : Expected)
+	{
+		TestEqual(TEXT("Priority, then push order"), Order.Pop(), Item);
+	}
+	TestEqual(TEXT("List drained"), Order.Num(), 0);
+
+	// A publisher pushed back after its slice goes behind the others of its priority, but still ahead of bulk ones
+	Order.Push(5, 10);
+	Order.Push(0, 11);
+	Order.Push(0, 12);
+	TestEqual(TEXT("First urgent publisher"), Order.Pop(), 11);
+	Order.Push(0, 11);
+	TestEqual(TEXT("Other urgent publisher takes its turn"), Order.Pop(), 12);
+	TestEqual(TEXT("Pushed-back urgent publisher"), Order.Pop(), 11);
+	TestEqual(TEXT("Bulk publisher last"), Order.Pop(), 10);
+	return true;
+}
+
+bool FMoqPublishSenderQueueDelayTest::RunTest(const FString& Parameters)
+{
+	// Test that objects that waited longer than MaxQueueDelayMs are discarded and fresh ones are still sent
+	using namespace MoqPublishSenderTest;
+	FScopedPausedSender PausedSender;
+
+	// The exhausted limiter holds the fresh objects instead of handing them to the missing moq-ffi handle
+	TSharedRef<FMoqRateLimiter, ESPMode::ThreadSafe> ClientLimiter = MakeExhaustedLimiter();
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> Urgent = MakeState(EMoqBackpressurePolicy::FailFast, 8, ClientLimiter);
+	TSharedRef<FMoqPublisherSendState, ESPMode::ThreadSafe> Bulk = MakeState(EMoqBackpressurePolicy::FailFast, 8, ClientLimiter);
+	Urgent->SetPriority(0);
+	Bulk->SetPriority(200);
+
+	for (uint8 Value = 0; Value < 3; ++Value)
+	{
+		EnqueueByte(*Urgent, Value);
+		EnqueueByte(*Bulk, Value);
+	}
+	FPlatformProcess::Sleep(0.06f);
+	EnqueueByte(*Urgent, 3);
+	EnqueueByte(*Bulk, 3);
+
+	TestTrue(TEXT("Urgent publisher's fresh object waits for tokens"), Urgent->SendPending(MAX_int32).WaitSeconds > 0.0);
+	TestTrue(TEXT("Bulk publisher's fresh object waits for tokens"), Bulk->SendPending(MAX_int32).WaitSeconds > 0.0);
+
+	const FMoqPublisherStats UrgentStats = Urgent->GetStats();
+	TestEqual(TEXT("Stale urgent objects expired"), UrgentStats.ExpiredObjects, static_cast<int64>(3));
+	TestEqual(TEXT("Fresh urgent object kept"), UrgentStats.QueuedObjects, 1);
+	TestEqual(TEXT("Fresh urgent object reached the limiter"), UrgentStats.DeferredObjects, static_cast<int64>(1));
+	TestEqual(TEXT("Expired objects are not dropped or failed"), UrgentStats.DroppedObjects + UrgentStats.FailedObjects, static_cast<int64>(0));
+
+	const FMoqPublisherStats BulkStats = Bulk->GetStats();
+	TestEqual(TEXT("Stale bulk objects expired"), BulkStats.ExpiredObjects, static_cast<int64>(3));
+	TestEqual(TEXT("Fresh bulk object kept"), BulkStats.QueuedObjects, 1);
+
+	TestEqual(TEXT("Held urgent object expires in turn"), ExpireAll(*Urgent), static_cast<int64>(4));
+	TestEqual(TEXT("Held bulk object expires in turn"), ExpireAll(*Bulk), static_cast<int64>(4));
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
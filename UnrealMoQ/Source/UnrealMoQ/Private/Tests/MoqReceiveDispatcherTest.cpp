@@ -0,0 +1,61 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/AutomationTest.h"
+#include "MoqReceiveDispatcher.h"
+#include "MoqSubscriber.h"
+#include "UObject/StrongObjectPtr.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqReceiveDispatcherRotationTest, "UnrealMoQ.ReceiveDispatcher.BudgetRotation", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FMoqReceiveDispatcherRotationTest::RunTest(const FString& Parameters)
+{
+	IConsoleVariable* BudgetVar = IConsoleManager::Get().FindConsoleVariable(TEXT("moq.Dispatch.BudgetMs"));
+	if (!TestNotNull(TEXT("Dispatch budget console variable"), BudgetVar))
+	{
+		return false;
+	}
+	const float PreviousBudget = BudgetVar->GetFloat();
+	BudgetVar->Set(1.0f, ECVF_SetByCode);
+
+	TStrongObjectPtr<UMoqSubscriber> Busy(NewObject<UMoqSubscriber>());
+	TStrongObjectPtr<UMoqSubscriber> Quiet(NewObject<UMoqSubscriber>());
+
+	// Every object the busy subscriber broadcasts overruns the budget and brings in another one
+	UMoqSubscriber* BusySubscriber = Busy.Get();
+	Busy->OnPayloadReceived.AddLambda([BusySubscriber](TConstArrayView<uint8> Payload)
+	{
+		FPlatformProcess::Sleep(0.002f);
+		UMoqSubscriber::OnDataReceivedCallback(BusySubscriber->GetCallbackUserData(), Payload.GetData(), Payload.Num());
+	});
+
+	int32 QuietDelivered = 0;
+	Quiet->OnPayloadReceived.AddLambda([&QuietDelivered](TConstArrayView<uint8> Payload)
+	{
+		++QuietDelivered;
+	});
+
+	const uint8 TestData[] = { 1 };
+	UMoqSubscriber::OnDataReceivedCallback(Busy->GetCallbackUserData(), TestData, 1);
+	UMoqSubscriber::OnDataReceivedCallback(Quiet->GetCallbackUserData(), TestData, 1);
+
+	// Whichever of the two the rotation reaches first, the other must be served by the next frame
+	for (int32 Frame = 0; Frame < 2; ++Frame)
+	{
+		FMoqReceiveDispatcher::Get().DispatchAll();
+	}
+	TestEqual(TEXT("Quiet subscriber served despite the busy one spending every budget"), QuietDelivered, 1);
+	TestTrue(TEXT("Busy subscriber still has a backlog"), Busy->GetReceiveQueueStats().QueuedObjects > 0);
+
+	Busy->OnPayloadReceived.Clear();
+	Busy->DispatchPendingEvents();
+	BudgetVar->Set(PreviousBudget, ECVF_SetByCode);
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
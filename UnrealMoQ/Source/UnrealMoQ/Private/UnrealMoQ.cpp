@@ -2,6 +2,9 @@
 
 #include "UnrealMoQ.h"
 #include "Modules/ModuleManager.h"
+#include "MoqPayloadPool.h"
+#include "MoqPublishSender.h"
+#include "MoqReceiveDispatcher.h"
 #include "moq_ffi.h"
 
 #define LOCTEXT_NAMESPACE "FUnrealMoQModule"
@@ -16,10 +19,16 @@ void FUnrealMoQModule::StartupModule()
 	{
 		UE_LOG(LogTemp, Error, TEXT("UnrealMoQ: Failed to initialize moq_ffi"));
 	}
+
+	FMoqReceiveDispatcher::Get().Startup();
 }
 
 void FUnrealMoQModule::ShutdownModule()
 {
+	FMoqReceiveDispatcher::Get().Shutdown();
+	FMoqPublishSender::Get().Shutdown();
+	FMoqPayloadPool::Get().Trim();
+
 	// Statically linked moq_ffi does not require explicit shutdown work here.
 }
 
@@ -0,0 +1,69 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+/**
+ * Shared datagrams for small objects of many tracks, used by UMoqClient::EnableDatagramAggregation.
+ *
+ * A publishing client packs datagram objects of its publishers into MoqEnvelope::EKind::Aggregate
+ * envelopes on one aggregation track. Each object is tagged with the route id of the track it was
+ * published on, so a subscribing client can hand it to its own subscriber of that track as if it
+ * had arrived there. Route ids are hashes of the track names, so both sides agree on them without
+ * any signalling.
+ */
+namespace MoqAggregation
+{
+	/** Bytes of the route id in front of every object */
+	static constexpr int32 RouteIdSize = 4;
+
+	/** Route id of a track: a hash of its UTF-8 namespace and name */
+	UNREALMOQ_API uint32 GetRouteId(const FString& Namespace, const FString& TrackName);
+
+	/** Bytes AppendObject adds for an object of Size bytes */
+	UNREALMOQ_API int32 GetObjectOverhead(int64 Size);
+
+	/** Append one object to an aggregate envelope started with MoqEnvelope::WriteHeader */
+	UNREALMOQ_API void AppendObject(TArray<uint8>& Out, uint32 RouteId, TConstArrayView<uint8> Data);
+}
+
+/**
+ * Subscriber side of MoqAggregation: splits shared datagrams and passes each object to the
+ * UMoqSubscriber callbacks registered for its route.
+ *
+ * Subscriber callback handles are generation-checked, so a subscriber destroyed after registering
+ * simply stops receiving; its stale handles are pruned whenever its route is registered again.
+ * Safe to use from any thread.
+ */
+class UNREALMOQ_API FMoqDatagramDemux
+{
+public:
+	/** Deliver objects of RouteId to the subscriber with this callback handle (UMoqSubscriber::GetCallbackUserData) */
+	void AddRoute(uint32 RouteId, void* SubscriberHandle);
+
+	/**
+	 * Hand every object of an aggregate envelope to the subscribers of its route.
+	 * @return False if the datagram is not an aggregate envelope or is cut short; objects before the damage are still delivered
+	 */
+	bool Dispatch(TConstArrayView<uint8> Datagram);
+
+	/** Objects handed to at least one subscriber */
+	int64 GetNumDemuxed() const { return NumDemuxed.load(std::memory_order_relaxed); }
+
+	/** Objects for routes nobody registered */
+	int64 GetNumUnrouted() const { return NumUnrouted.load(std::memory_order_relaxed); }
+
+	/** Datagrams rejected by Dispatch */
+	int64 GetNumMalformed() const { return NumMalformed.load(std::memory_order_relaxed); }
+
+private:
+	FRWLock RoutesLock;
+	TMap<uint32, TArray<void*, TInlineAllocator<1>>> Routes;
+
+	std::atomic<int64> NumDemuxed{ 0 };
+	std::atomic<int64> NumUnrouted{ 0 };
+	std::atomic<int64> NumMalformed{ 0 };
+};
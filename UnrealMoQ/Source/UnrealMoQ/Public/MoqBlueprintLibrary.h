@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Kismet/BlueprintFunctionLibrary.h"
+#include "MoqTypes.h"
 #include "MoqBlueprintLibrary.generated.h"
 
 class UMoqClient;
@@ -47,6 +48,24 @@ public:
 	UFUNCTION(BlueprintPure, Category = "MoQ|Utilities")
 	static TArray<uint8> StringToBytes(const FString& Text);
 
+	/**
+	 * Get what the last frame's receive dispatch delivered and left waiting across all subscribers,
+	 * to tell whether moq.Dispatch.BudgetMs keeps up with incoming objects
+	 * @return Dispatched objects, backlog size and age of the oldest waiting object
+	 */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Utilities")
+	static FMoqDispatchStats GetDispatchStats();
+
+	/**
+	 * Decode a payload published with Publish Struct
+	 * @param Data Payload from OnDataReceived
+	 * @param OutValue Struct to decode into; must be the type that was published
+	 * @return True if Data was an encoding of the struct's type
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "MoQ|Utilities", meta = (CustomStructureParam = "OutValue"))
+	static bool DecodeStruct(const TArray<uint8>& Data, int32& OutValue);
+	DECLARE_FUNCTION(execDecodeStruct);
+
 	/**
 	 * Create a new MoQ client UObject that can be reused across Blueprint graphs
 	 * @param Outer Owning object for the new client (defaults to transient package if not provided)
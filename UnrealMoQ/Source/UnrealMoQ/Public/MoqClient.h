@@ -10,6 +10,9 @@
 
 class UMoqPublisher;
 class UMoqSubscriber;
+class FMoqDatagramAggregator;
+class FMoqDatagramDemux;
+class FMoqRateLimiter;
 
 /** Delegate for connection state changes */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqConnectionStateChanged, EMoqConnectionState, NewState);
@@ -37,6 +40,7 @@ public:
 	virtual ~UMoqClient();
 
 	// UObject interface
+	virtual void PostInitProperties() override;
 	virtual void BeginDestroy() override;
 
 	/**
@@ -79,6 +83,67 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
 	UMoqPublisher* CreatePublisher(const FString& Namespace, const FString& TrackName, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
 
+	/**
+	 * Create a publisher for a specific track with explicit send options
+	 * @param Namespace Namespace of the track
+	 * @param TrackName Name of the track
+	 * @param DeliveryMode Delivery mode (datagram or stream)
+	 * @param Options Publish mode and send queue configuration
+	 * @return Handle to the publisher or null on failure
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	UMoqPublisher* CreatePublisherWithOptions(const FString& Namespace, const FString& TrackName, EMoqDeliveryMode DeliveryMode, const FMoqPublishOptions& Options);
+
+	/**
+	 * Limit the combined rate of every publisher created by this client, on top of their own limits.
+	 * Applies immediately to existing publishers; while limited, their publishes are always queued.
+	 * @param Limit Bytes and objects per second, 0 for unlimited
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void SetPublishRateLimit(const FMoqRateLimit& Limit);
+
+	/** Current aggregate publish rate limit */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	FMoqRateLimit GetPublishRateLimit() const;
+
+	/** Objects and bytes this client's publishers released on the sender thread, and how many had to wait for a rate limit */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	FMoqPacingStats GetPacingStats() const;
+
+	/**
+	 * Pack small datagram objects of every publisher of this client into shared datagrams on one
+	 * track, so tracks of tiny objects stop paying a packet's overhead each. Objects wait at most
+	 * Options.MaxDelayMs for company; larger objects and publishers with FEC, delta encoding or groups
+	 * keep their own track.
+	 * Subscribers only receive the packed objects after SubscribeAggregationTrack. Calling this
+	 * again replaces the track.
+	 * @param Namespace Namespace of the aggregation track
+	 * @param Options Aggregation track name, size limits and delay
+	 * @return Result of creating the aggregation track
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	FMoqResult EnableDatagramAggregation(const FString& Namespace, const FMoqAggregationOptions& Options);
+
+	/** Send what is packed and go back to one datagram per object */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void DisableDatagramAggregation();
+
+	/**
+	 * Receive the shared datagrams of a client with datagram aggregation enabled, handing each
+	 * object to this client's subscribers of the track it was published on. One thread serves every
+	 * aggregated track, so it never waits for a full queue: subscribers using EMoqOverflowPolicy::Block
+	 * drop the newest object instead, for objects that arrive this way.
+	 * @param Namespace Namespace of the aggregation track
+	 * @param TrackName FMoqAggregationOptions::TrackName of the publishing client
+	 * @return Result of the subscription
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	FMoqResult SubscribeAggregationTrack(const FString& Namespace, const FString& TrackName = TEXT("_aggregate"));
+
+	/** Objects packed into shared datagrams by this client, and objects it unpacked from them */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Client")
+	FMoqAggregationStats GetAggregationStats() const;
+
 	/**
 	 * Subscribe to a track
 	 * @param Namespace Namespace of the track
@@ -88,6 +153,16 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
 	UMoqSubscriber* Subscribe(const FString& Namespace, const FString& TrackName);
 
+	/**
+	 * Subscribe to a track with explicit receive options
+	 * @param Namespace Namespace of the track
+	 * @param TrackName Name of the track
+	 * @param Options Receive queue configuration applied before any data arrives
+	 * @return Handle to the subscriber or null on failure
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	UMoqSubscriber* SubscribeWithOptions(const FString& Namespace, const FString& TrackName, const FMoqSubscribeOptions& Options);
+
 	/** Event fired when connection state changes */
 	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
 	FMoqConnectionStateChanged OnConnectionStateChanged;
@@ -105,12 +180,33 @@ private:
 	/** Handle to the native MoQ client */
 	MoqClient* ClientHandle;
 
+	/** Registry handle passed to moq-ffi as callback user data instead of a raw UObject pointer */
+	void* CallbackHandle;
+
 	/** C callback for connection state changes */
 	static void OnConnectionStateChangedCallback(void* UserData, MoqConnectionState State);
 
 	/** C callback for track announcements */
 	static void OnTrackAnnouncedCallback(void* UserData, const char* Namespace, const char* TrackName);
 
+	/** C callback for shared datagrams on an aggregation track */
+	static void OnAggregateDataCallback(void* UserData, const uint8_t* Data, size_t DataLen);
+
+	/** Destroy the aggregation track subscriptions */
+	void DestroyAggregationSubscriptions();
+
 	/** Current connection state */
 	EMoqConnectionState CurrentState;
+
+	/** Aggregate publish rate limit, shared with every publisher this client creates */
+	TSharedPtr<FMoqRateLimiter, ESPMode::ThreadSafe> PublishRateLimiter;
+
+	/** Packs small datagram objects of every publisher this client creates, once enabled */
+	TSharedPtr<FMoqDatagramAggregator, ESPMode::ThreadSafe> DatagramAggregator;
+
+	/** Routes objects from aggregation tracks to this client's subscribers */
+	TSharedPtr<FMoqDatagramDemux, ESPMode::ThreadSafe> DatagramDemux;
+
+	/** Native subscriptions to aggregation tracks */
+	TArray<MoqSubscriber*> AggregationSubscriptions;
 };
@@ -0,0 +1,286 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoqEnvelope.h"
+#include "MoqUtf8.h"
+#include <type_traits>
+#include <utility>
+
+/**
+ * Compile-time message codecs for hot message types, for when the reflection walk of
+ * MoqStructSerializer is still too slow. A type opts in by specializing TMoqMessage with its fields:
+ *
+ *	template <>
+ *	struct TMoqMessage<FPlayerPose>
+ *	{
+ *		using Fields = TMoqFields<&FPlayerPose::Position, &FPlayerPose::Yaw, &FPlayerPose::Name>;
+ *	};
+ *
+ * TMoqCodec<FPlayerPose> then writes the fixed-size fields (numbers, enums, bools and trivially
+ * copyable structs such as FVector) back to back at offsets computed at compile time, so they are
+ * encoded and decoded with straight-line copies behind a single length check. Variable-size fields
+ * (FString as UTF-8 and TArray of fixed-size elements) follow in field order, each with a varint
+ * length. Nothing is allocated once the output array and the message's strings and arrays have
+ * grown to fit.
+ *
+ * Values are stored in memory byte order, which is little-endian on every platform Unreal
+ * supports. There is no header or schema check beyond the total length, so both ends must be built
+ * with the same field list and a track should carry a single message type.
+ */
+template <typename MessageType>
+struct TMoqMessage;
+
+/** Field list of a TMoqMessage specialization: pointers to the members to encode, in wire order */
+template <auto... Members>
+struct TMoqFields
+{
+};
+
+/**
+ * How values of one field type are written; trivially copyable types are copied as they are in memory.
+ * Fixed-size codecs write to and read from their place in the fixed-size block, the others append
+ * to the output and read from an offset that they advance.
+ */
+template <typename FieldType>
+struct TMoqFieldCodec
+{
+	static_assert(std::is_trivially_copyable_v<FieldType>, "Message fields must be trivially copyable, FString or TArray; specialize TMoqFieldCodec for other types");
+
+	static constexpr bool bFixedSize = true;
+	static constexpr int32 FixedSize = sizeof(FieldType);
+
+	static FORCEINLINE void Write(const FieldType& Value, uint8* Out)
+	{
+		FMemory::Memcpy(Out, &Value, FixedSize);
+	}
+
+	static FORCEINLINE void Read(const uint8* Data, FieldType& OutValue)
+	{
+		FMemory::Memcpy(&OutValue, Data, FixedSize);
+	}
+};
+
+/** One byte like a copied bool, but any byte other than 0 decodes as true: a bool holding anything but 0 or 1 is undefined */
+template <>
+struct TMoqFieldCodec<bool>
+{
+	static constexpr bool bFixedSize = true;
+	static constexpr int32 FixedSize = 1;
+
+	static FORCEINLINE void Write(const bool& Value, uint8* Out)
+	{
+		*Out = Value ? 1 : 0;
+	}
+
+	static FORCEINLINE void Read(const uint8* Data, bool& OutValue)
+	{
+		OutValue = *Data != 0;
+	}
+};
+
+template <>
+struct TMoqFieldCodec<FString>
+{
+	static constexpr bool bFixedSize = false;
+	static constexpr int32 FixedSize = 0;
+
+	static void Write(const FString& Value, TArray<uint8>& Out)
+	{
+		const int32 Utf8Length = FPlatformString::ConvertedLength<UTF8CHAR>(*Value, Value.Len());
+		MoqEnvelope::WriteVarint(Out, Utf8Length);
+		const int32 Start = Out.AddUninitialized(Utf8Length);
+		FPlatformString::Convert(reinterpret_cast<UTF8CHAR*>(Out.GetData() + Start), Utf8Length, *Value, Value.Len());
+	}
+
+	static bool Read(TConstArrayView<uint8> Data, int32& Offset, FString& OutValue)
+	{
+		uint64 Length = 0;
+		if (!MoqEnvelope::ReadVarint(Data, Offset, Length) || Length > static_cast<uint64>(Data.Num() - Offset))
+		{
+			return false;
+		}
+
+		const TConstArrayView<uint8> Utf8 = Data.Slice(Offset, static_cast<int32>(Length));
+		Offset += static_cast<int32>(Length);
+		return MoqUtf8::DecodeToString(Utf8, OutValue);
+	}
+};
+
+template <typename ElementType, typename AllocatorType>
+struct TMoqFieldCodec<TArray<ElementType, AllocatorType>>
+{
+	static_assert(std::is_trivially_copyable_v<ElementType>, "Array message fields must hold trivially copyable elements");
+
+	static constexpr bool bFixedSize = false;
+	static constexpr int32 FixedSize = 0;
+
+	static void Write(const TArray<ElementType, AllocatorType>& Value, TArray<uint8>& Out)
+	{
+		MoqEnvelope::WriteVarint(Out, Value.Num());
+		Out.Append(reinterpret_cast<const uint8*>(Value.GetData()), Value.Num() * static_cast<int32>(sizeof(ElementType)));
+	}
+
+	static bool Read(TConstArrayView<uint8> Data, int32& Offset, TArray<ElementType, AllocatorType>& OutValue)
+	{
+		uint64 Count = 0;
+		if (!MoqEnvelope::ReadVarint(Data, Offset, Count) || Count > static_cast<uint64>(Data.Num() - Offset) / sizeof(ElementType))
+		{
+			return false;
+		}
+
+		const int32 Bytes = static_cast<int32>(Count * sizeof(ElementType));
+		OutValue.SetNumUninitialized(static_cast<int32>(Count), EAllowShrinking::No);
+		if constexpr (std::is_same_v<ElementType, bool>)
+		{
+			for (int32 Index = 0; Index < Bytes; ++Index)
+			{
+				OutValue[Index] = Data[Offset + Index] != 0;
+			}
+		}
+		else
+		{
+			FMemory::Memcpy(OutValue.GetData(), Data.GetData() + Offset, Bytes);
+		}
+		Offset += Bytes;
+		return true;
+	}
+};
+
+/** One entry of a TMoqFields list */
+template <auto Member>
+struct TMoqField;
+
+template <typename ClassType, typename FieldType, FieldType ClassType::*Member>
+struct TMoqField<Member>
+{
+	using FClass = ClassType;
+	using FCodec = TMoqFieldCodec<FieldType>;
+
+	static FieldType& Get(ClassType& Message) { return Message.*Member; }
+	static const FieldType& Get(const ClassType& Message) { return Message.*Member; }
+};
+
+/** Encoder and decoder generated from TMoqMessage<MessageType>::Fields */
+template <typename MessageType, typename FieldList = typename TMoqMessage<MessageType>::Fields>
+struct TMoqCodec;
+
+template <typename MessageType, auto... Members>
+struct TMoqCodec<MessageType, TMoqFields<Members...>>
+{
+	static_assert(sizeof...(Members) > 0, "TMoqFields needs at least one field");
+	static_assert((std::is_base_of_v<typename TMoqField<Members>::FClass, MessageType> && ...), "TMoqFields must list members of the message type");
+
+private:
+	static constexpr int32 NumFields = sizeof...(Members);
+	static constexpr int32 FieldSizes[] = { TMoqField<Members>::FCodec::FixedSize... };
+
+	/** Offset of field Index in the fixed-size block; variable-size fields take no room in it */
+	static constexpr int32 GetWireOffset(int32 Index)
+	{
+		int32 Offset = 0;
+		for (int32 Field = 0; Field < Index; ++Field)
+		{
+			Offset += FieldSizes[Field];
+		}
+		return Offset;
+	}
+
+public:
+	/** Bytes taken by the fixed-size fields, and the whole encoding if there are no others */
+	static constexpr int32 FixedSize = (TMoqField<Members>::FCodec::FixedSize + ...);
+
+	/** Whether every message encodes to exactly FixedSize bytes */
+	static constexpr bool bFixedSize = (TMoqField<Members>::FCodec::bFixedSize && ...);
+
+	/** Replace Out with the encoding of Message, reusing its allocation */
+	static void Encode(const MessageType& Message, TArray<uint8>& Out)
+	{
+		Out.SetNumUninitialized(FixedSize, EAllowShrinking::No);
+		EncodeFields(Message, Out, std::make_index_sequence<NumFields>());
+	}
+
+	/**
+	 * Decode Data into OutMessage; string and array fields keep their allocations when they fit.
+	 * @return False if Data is not a complete encoding; OutMessage may be partly overwritten
+	 */
+	static bool Decode(TConstArrayView<uint8> Data, MessageType& OutMessage)
+	{
+		if (bFixedSize ? Data.Num() != FixedSize : Data.Num() < FixedSize)
+		{
+			return false;
+		}
+		return DecodeFields(Data, OutMessage, std::make_index_sequence<NumFields>());
+	}
+
+private:
+	template <size_t... Indices>
+	static FORCEINLINE void EncodeFields(const MessageType& Message, TArray<uint8>& Out, std::index_sequence<Indices...>)
+	{
+		// Fixed-size fields first, while the block they go in cannot move
+		uint8* Block = Out.GetData();
+		(WriteFixed<Members, GetWireOffset(Indices)>(Message, Block), ...);
+		(WriteVariable<Members>(Message, Out), ...);
+	}
+
+	template <size_t... Indices>
+	static FORCEINLINE bool DecodeFields(TConstArrayView<uint8> Data, MessageType& OutMessage, std::index_sequence<Indices...>)
+	{
+		const uint8* Block = Data.GetData();
+		(ReadFixed<Members, GetWireOffset(Indices)>(Block, OutMessage), ...);
+		if constexpr (bFixedSize)
+		{
+			return true;
+		}
+		else
+		{
+			int32 Offset = FixedSize;
+			return (ReadVariable<Members>(Data, Offset, OutMessage) && ...) && Offset == Data.Num();
+		}
+	}
+
+	template <auto Member, int32 WireOffset>
+	static FORCEINLINE void WriteFixed(const MessageType& Message, uint8* Block)
+	{
+		using FField = TMoqField<Member>;
+		if constexpr (FField::FCodec::bFixedSize)
+		{
+			FField::FCodec::Write(FField::Get(Message), Block + WireOffset);
+		}
+	}
+
+	template <auto Member, int32 WireOffset>
+	static FORCEINLINE void ReadFixed(const uint8* Block, MessageType& OutMessage)
+	{
+		using FField = TMoqField<Member>;
+		if constexpr (FField::FCodec::bFixedSize)
+		{
+			FField::FCodec::Read(Block + WireOffset, FField::Get(OutMessage));
+		}
+	}
+
+	template <auto Member>
+	static FORCEINLINE void WriteVariable(const MessageType& Message, TArray<uint8>& Out)
+	{
+		using FField = TMoqField<Member>;
+		if constexpr (!FField::FCodec::bFixedSize)
+		{
+			FField::FCodec::Write(FField::Get(Message), Out);
+		}
+	}
+
+	template <auto Member>
+	static FORCEINLINE bool ReadVariable(TConstArrayView<uint8> Data, int32& Offset, MessageType& OutMessage)
+	{
+		using FField = TMoqField<Member>;
+		if constexpr (!FField::FCodec::bFixedSize)
+		{
+			return FField::FCodec::Read(Data, Offset, FField::Get(OutMessage));
+		}
+		else
+		{
+			return true;
+		}
+	}
+};
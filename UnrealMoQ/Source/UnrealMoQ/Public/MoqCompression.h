@@ -0,0 +1,43 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoqTypes.h"
+
+/**
+ * Payload codecs behind FMoqPublishOptions::Compression.
+ *
+ * Zlib, LZ4 and Oodle go through FCompression. ZlibDictionary runs raw deflate with a preset
+ * dictionary, which is what makes small, repetitive objects (JSON, serialized structs) compress
+ * at all: each object is too short to build up its own history, so the dictionary supplies it.
+ */
+namespace MoqCompression
+{
+	/** Largest useful dictionary: the deflate window */
+	static constexpr int32 MaxDictionarySize = 32 * 1024;
+
+	/**
+	 * Build a preset dictionary from representative objects of a track.
+	 * Substrings that recur across samples are kept, most frequent last, where deflate reaches them cheapest.
+	 * @param Samples Objects captured from real traffic; a few hundred is usually plenty
+	 * @param MaxBytes Dictionary size cap, at most MaxDictionarySize
+	 */
+	UNREALMOQ_API TArray<uint8> TrainDictionary(TConstArrayView<TConstArrayView<uint8>> Samples, int32 MaxBytes = MaxDictionarySize);
+
+	/** Identifier carried with every object compressed with Dictionary, never 0 */
+	UNREALMOQ_API uint32 GetDictionaryId(TConstArrayView<uint8> Dictionary);
+
+	/**
+	 * Compress Data, appending the result to Out.
+	 * @param Dictionary Only used by EMoqCompression::ZlibDictionary
+	 * @return False if the codec failed or the output would not be smaller than Data; Out is left as it was
+	 */
+	UNREALMOQ_API bool Compress(EMoqCompression Codec, TConstArrayView<uint8> Data, TConstArrayView<uint8> Dictionary, TArray<uint8>& Out);
+
+	/**
+	 * Decompress exactly OutSize bytes into Out.
+	 * @return False if the data is corrupt or does not decompress to OutSize bytes
+	 */
+	UNREALMOQ_API bool Decompress(EMoqCompression Codec, TConstArrayView<uint8> Compressed, TConstArrayView<uint8> Dictionary, uint8* Out, int64 OutSize);
+}
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+#include "Tasks/Task.h"
+
+/** Where a native data sink is invoked */
+enum class EMoqSinkThread : uint8
+{
+	/**
+	 * Directly on the moq-ffi callback thread, before the object is queued for the game thread.
+	 * Lowest latency, but the sink stalls the network thread for as long as it runs.
+	 */
+	CallbackThread,
+
+	/**
+	 * On a task graph worker. Each sink has its own bounded queue and is never run concurrently
+	 * with itself, so objects arrive in order on one worker at a time.
+	 */
+	Worker
+};
+
+/**
+ * Native (non-UObject) consumer of subscriber data.
+ *
+ * Sinks let decoders for audio, poses or telemetry run off the game thread and only hand finished
+ * results to gameplay. They are not part of the game thread drain and must not touch UObjects
+ * without marshalling back themselves. A sink is called by at most one thread at a time.
+ */
+class IMoqDataSink
+{
+public:
+	virtual ~IMoqDataSink() = default;
+
+	/**
+	 * Called once per received object.
+	 * @param Payload Pooled payload bytes; keep a reference to hold on to the data without copying
+	 */
+	virtual void OnMoqDataReceived(const FSharedBuffer& Payload) = 0;
+};
+
+/** Options for a sink registered with UMoqSubscriber::AddDataSink */
+struct FMoqDataSinkOptions
+{
+	/** Thread the sink runs on */
+	EMoqSinkThread Thread = EMoqSinkThread::Worker;
+
+	/** Task priority used for EMoqSinkThread::Worker */
+	UE::Tasks::ETaskPriority Priority = UE::Tasks::ETaskPriority::Normal;
+
+	/** Objects buffered for a worker sink before the subscriber's overflow policy applies */
+	int32 QueueCapacity = 256;
+};
+
+/** Wrap a function as a data sink. The function follows the same threading rules as IMoqDataSink. */
+UNREALMOQ_API TSharedRef<IMoqDataSink, ESPMode::ThreadSafe> MakeMoqDataSink(TUniqueFunction<void(const FSharedBuffer&)>&& Function);
@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * XOR/run-length delta between two versions of an object, used by FMoqPublishOptions::bDeltaEncoding.
+ *
+ * A delta is a sequence of (varint unchanged count, varint changed count, changed bytes XORed with
+ * the base) runs covering the target from its start; bytes past the last run are unchanged. The base
+ * is treated as zero-padded when the target is longer, and is simply cut when it is shorter.
+ */
+namespace MoqDelta
+{
+	/**
+	 * Append the delta that turns Base into Target to Out.
+	 * @return False if the delta would not be smaller than Target itself; Out is left as it was
+	 */
+	UNREALMOQ_API bool Encode(TConstArrayView<uint8> Base, TConstArrayView<uint8> Target, TArray<uint8>& Out);
+
+	/**
+	 * Rebuild a target of OutSize bytes from Base and a delta produced by Encode.
+	 * @return False if the delta is malformed or runs past OutSize
+	 */
+	UNREALMOQ_API bool Apply(TConstArrayView<uint8> Base, TConstArrayView<uint8> Delta, uint8* Out, int64 OutSize);
+}
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+
+/**
+ * Framing for objects that the plugin transforms on the wire (coalesced, compressed, delta-encoded, grouped,
+ * fragmented, FEC-protected and aggregated publishes).
+ *
+ * An enveloped object starts with MagicByte followed by an EKind byte; the layout of the rest
+ * depends on the kind. 0xF5 can never start valid UTF-8, so text tracks are never mistaken for
+ * envelopes. A publisher that emits envelopes wraps any plain payload that happens to start with
+ * the magic byte as EKind::Raw, so a subscriber with envelope decoding on sees exactly what was
+ * published. Lengths are unsigned LEB128 varints.
+ */
+namespace MoqEnvelope
+{
+	static constexpr uint8 MagicByte = 0xF5;
+
+	/** Bytes taken by the magic and kind bytes */
+	static constexpr int32 HeaderSize = 2;
+
+	enum class EKind : uint8
+	{
+		/** One plain payload that would otherwise start with MagicByte */
+		Raw = 0,
+
+		/** Several payloads, each prefixed with its varint length; a payload that starts with MagicByte is itself a Raw or Grouped envelope */
+		Coalesced = 1,
+
+		/**
+		 * Codec byte (EMoqCompression), varint dictionary id (0 without one), varint uncompressed size,
+		 * then the compressed bytes. Decompresses to exactly what would otherwise have been sent,
+		 * which may itself be an envelope.
+		 */
+		Compressed = 2,
+
+		/**
+		 * Varint sequence number, then the full object. Starts a new delta chain; decodes to exactly
+		 * what would otherwise have been sent, which may itself be an envelope.
+		 */
+		Keyframe = 3,
+
+		/**
+		 * Varint sequence number, varint object size, then a MoqDelta delta against the object with
+		 * the previous sequence number. Only decodable if that object was received.
+		 */
+		Delta = 4,
+
+		/**
+		 * Varint group id, varint object id within the group, then one plain payload. Object 0 starts
+		 * a group and is a point a subscriber can start decoding from.
+		 */
+		Grouped = 5,
+
+		/**
+		 * Varint object id, varint object size, varint fragment index, varint fragment count, then
+		 * one piece of an object too large for a datagram (see MoqFragment). The reassembled object
+		 * is exactly what would otherwise have been sent, which may itself be an envelope.
+		 */
+		Fragment = 6,
+
+		/** Varint FEC block id, varint index in the block, then one datagram as it would otherwise have been sent (see MoqFec) */
+		FecData = 7,
+
+		/**
+		 * Varint FEC block id, varint datagrams in the block, varint XOR of their sizes, then the XOR
+		 * of the datagrams; rebuilds one lost datagram of the block.
+		 */
+		FecParity = 8,
+
+		/**
+		 * Small objects of several tracks sharing one datagram on a client's aggregation track (see
+		 * MoqAggregation): per object, a 32-bit little-endian route id, its varint size, then the
+		 * object as its own track would otherwise have carried it.
+		 */
+		Aggregate = 9,
+	};
+
+	/** True if Data starts with an envelope header */
+	inline bool IsEnvelope(TConstArrayView<uint8> Data)
+	{
+		return Data.Num() >= HeaderSize && Data[0] == MagicByte;
+	}
+
+	/** Append Value as an unsigned LEB128 varint */
+	UNREALMOQ_API void WriteVarint(TArray<uint8>& Out, uint64 Value);
+
+	/**
+	 * Read an unsigned LEB128 varint at Offset and advance it.
+	 * @return False if the data ends early or the varint is longer than ten bytes
+	 */
+	UNREALMOQ_API bool ReadVarint(TConstArrayView<uint8> Data, int32& Offset, uint64& OutValue);
+
+	/** Bytes WriteVarint uses for Value */
+	UNREALMOQ_API int32 GetVarintSize(uint64 Value);
+
+	/** Append an envelope header of the given kind */
+	UNREALMOQ_API void WriteHeader(TArray<uint8>& Out, EKind Kind);
+
+	/**
+	 * Read the ids of an EKind::Grouped envelope.
+	 * @param OutPayloadOffset Receives where the payload starts
+	 * @return False if Data is not a well-formed grouped envelope with a payload
+	 */
+	UNREALMOQ_API bool ReadGroupHeader(TConstArrayView<uint8> Data, uint64& OutGroupId, uint64& OutObjectId, int32& OutPayloadOffset);
+
+	/** True if Data is the first object of a group */
+	UNREALMOQ_API bool IsGroupStart(TConstArrayView<uint8> Data);
+
+	/**
+	 * Split an envelope into the payloads it carries, as views that share Envelope's memory.
+	 * @param Envelope Object received from the wire; must satisfy IsEnvelope
+	 * @param OutPayloads Receives the payloads, in publish order
+	 * @return False if the envelope is truncated or of a kind that needs per-track state or carries
+	 *         metadata (every kind but Raw and Coalesced, see FMoqEnvelopeDecoder);
+	 *         OutPayloads is left untouched
+	 */
+	UNREALMOQ_API bool Unpack(const FSharedBuffer& Envelope, TArray<FSharedBuffer>& OutPayloads);
+}
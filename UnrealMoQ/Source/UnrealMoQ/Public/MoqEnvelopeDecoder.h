@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Memory/SharedBuffer.h"
+#include "MoqFec.h"
+#include "MoqFragment.h"
+#include <atomic>
+
+/** One payload recovered from a received object */
+struct FMoqDecodedObject
+{
+	FSharedBuffer Payload;
+
+	/** MoQ group and object ids given by the publisher (UMoqPublisher::StartGroup), INDEX_NONE if it does not use groups */
+	int64 GroupId = INDEX_NONE;
+	int64 ObjectId = INDEX_NONE;
+};
+
+/**
+ * Per-track receive side of MoqEnvelope: turns one object from the wire into the payloads that
+ * were published. Stateless kinds are handed to MoqEnvelope::Unpack; this adds what needs state
+ * kept across objects: the dictionaries used by compressed objects, the last state of a
+ * delta-encoded track, which delta objects are applied to, fragments of objects that are not
+ * complete yet, and the FEC blocks lost datagrams are rebuilt from.
+ *
+ * Decode must only be called from one thread at a time (the moq-ffi callback thread); dictionaries
+ * can be added from any thread.
+ */
+class UNREALMOQ_API FMoqEnvelopeDecoder
+{
+public:
+	/**
+	 * Decode one received object.
+	 * @param Object Object as received; payloads that are not envelopes are passed through unchanged
+	 * @param OutObjects Receives the payloads to deliver with their group ids, in publish order
+	 * @return False if the object is a malformed envelope, or needs a dictionary that was never added.
+	 *         A delta that arrives while waiting for a keyframe, or a fragment of an object that is not
+	 *         complete yet, is not an error: it decodes to nothing.
+	 */
+	bool Decode(const FSharedBuffer& Object, TArray<FMoqDecodedObject>& OutObjects);
+
+	/** Make a dictionary available to compressed objects that name its id */
+	void AddDictionary(TConstArrayView<uint8> Dictionary);
+
+	/** Bound the memory and time spent on fragmented objects, see FMoqFragmentReassembler */
+	void SetReassemblyLimits(int64 MaxBytes, double TimeoutSeconds) { Reassembler.SetLimits(MaxBytes, TimeoutSeconds); }
+
+	const FMoqFragmentReassembler& GetReassembler() const { return Reassembler; }
+	const FMoqFecDecoder& GetFecDecoder() const { return FecDecoder; }
+
+	int64 GetCompressedBytes() const { return CompressedBytes.load(std::memory_order_relaxed); }
+	int64 GetDecompressedBytes() const { return DecompressedBytes.load(std::memory_order_relaxed); }
+	double GetDecompressionSeconds() const { return DecompressionCycles.load(std::memory_order_relaxed) * FPlatformTime::GetSecondsPerCycle64(); }
+	int64 GetNumKeyframes() const { return NumKeyframes.load(std::memory_order_relaxed); }
+	int64 GetNumDeltas() const { return NumDeltas.load(std::memory_order_relaxed); }
+	int64 GetNumSkippedDeltas() const { return NumSkippedDeltas.load(std::memory_order_relaxed); }
+
+private:
+	/** Decode one datagram or stream object as it was before FEC */
+	bool DecodeObject(const FSharedBuffer& Received, TArray<FMoqDecodedObject>& OutObjects);
+
+	/** Decode an object as it was before compression */
+	bool DecodeUncompressed(const FSharedBuffer& Object, TArray<FSharedBuffer>& OutPayloads);
+
+	bool Decompress(const FSharedBuffer& Object, FSharedBuffer& OutDecompressed);
+
+	/**
+	 * Rebuild the state carried by a keyframe or delta object.
+	 * @param OutState Left null if the object was skipped while waiting for a keyframe
+	 */
+	bool ApplyDelta(const FSharedBuffer& Object, FSharedBuffer& OutState);
+
+	/** Dictionaries by id; replaced as a whole under DictionariesLock so Decode only copies a pointer */
+	TSharedPtr<const TMap<uint32, TArray<uint8>>, ESPMode::ThreadSafe> Dictionaries;
+	FCriticalSection DictionariesLock;
+
+	std::atomic<int64> CompressedBytes{ 0 };
+	std::atomic<int64> DecompressedBytes{ 0 };
+	std::atomic<uint64> DecompressionCycles{ 0 };
+
+	/** Last state rebuilt from a keyframe or delta, and its sequence number (Decode thread only) */
+	FSharedBuffer DeltaBase;
+	uint64 DeltaSequence = 0;
+	bool bDeltaSynced = false;
+
+	std::atomic<int64> NumKeyframes{ 0 };
+	std::atomic<int64> NumDeltas{ 0 };
+	std::atomic<int64> NumSkippedDeltas{ 0 };
+
+	/** Objects whose fragments are still arriving (Decode thread only, stats from any thread) */
+	FMoqFragmentReassembler Reassembler;
+
+	/** Recent FEC blocks (Decode thread only, stats from any thread) */
+	FMoqFecDecoder FecDecoder;
+};
@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+#include <atomic>
+
+/**
+ * XOR parity forward error correction for datagram tracks, used by FMoqPublishOptions::FecBlockSize.
+ *
+ * Datagrams are sent in blocks of N as MoqEnvelope::EKind::FecData envelopes (varint block id,
+ * varint index in the block, then the datagram). After the last one the publisher sends an
+ * EKind::FecParity envelope (varint block id, varint N, XOR of the datagram sizes as a varint,
+ * then the XOR of the datagrams zero-padded to the longest), from which a subscriber rebuilds any
+ * one datagram of the block that was lost.
+ */
+namespace MoqFec
+{
+	/** Bytes the FEC headers can add to a datagram, data or parity */
+	static constexpr int32 MaxOverhead = 22;
+
+	/** Largest block accepted by the decoder */
+	static constexpr int32 MaxBlockSize = 256;
+}
+
+/** Publisher side of MoqFec. Not thread safe; FMoqPublisherSendState guards it with a lock held until the datagrams are sent. */
+class UNREALMOQ_API FMoqFecEncoder
+{
+public:
+	/** Datagrams per parity datagram, 0 to turn FEC off; a block in progress is abandoned */
+	void SetBlockSize(int32 InBlockSize);
+
+	bool IsEnabled() const { return BlockSize > 0; }
+
+	/** Replace Out with Datagram wrapped for the current block, and add it to the block's parity */
+	void WrapData(TConstArrayView<uint8> Datagram, TArray<uint8>& Out);
+
+	/**
+	 * Replace Out with the parity datagram once the current block is complete, and start the next block.
+	 * @return False while the block is still missing datagrams
+	 */
+	bool TakeParity(TArray<uint8>& Out);
+
+private:
+	/** Close the block in progress */
+	void StartBlock();
+
+	int32 BlockSize = 0;
+	uint64 BlockId = 0;
+	int32 NextIndex = 0;
+	TArray<uint8> Parity;
+	uint64 SizeParity = 0;
+};
+
+/**
+ * Subscriber side of MoqFec: unwraps FEC datagrams and rebuilds lost ones from parity.
+ *
+ * The most recent blocks are kept (MaxBlocks); when an older block is dropped to make room, any of
+ * its datagrams still missing are counted as lost. A block id far behind the newest one means the
+ * publisher was recreated and numbers its blocks from 0 again, so tracking starts over. Add must only
+ * be called from one thread at a time; the stats can be read from any thread.
+ */
+class UNREALMOQ_API FMoqFecDecoder
+{
+public:
+	/** Blocks kept waiting for parity or a missing datagram */
+	static constexpr int32 MaxBlocks = 16;
+
+	/**
+	 * Add one FecData or FecParity envelope.
+	 * @param OutDatagrams Receives the unwrapped datagram, a datagram rebuilt from parity, both or neither
+	 * @return False if the envelope is malformed or does not match the rest of its block
+	 */
+	bool Add(const FSharedBuffer& Datagram, TArray<FSharedBuffer>& OutDatagrams);
+
+	/** Datagrams rebuilt from parity */
+	int64 GetNumRecovered() const { return NumRecovered.load(std::memory_order_relaxed); }
+
+	/** Datagrams that were neither received nor rebuilt */
+	int64 GetNumLost() const { return NumLost.load(std::memory_order_relaxed); }
+
+private:
+	struct FBlock
+	{
+		/** Parity XOR every datagram received so far: the missing datagram once only one is missing */
+		TArray<uint8> Xor;
+		uint64 SizeXor = 0;
+		TBitArray<> Received;
+		int32 NumReceived = 0;
+		int32 MaxIndex = INDEX_NONE;
+
+		/** Datagrams in the block, 0 until the parity arrived */
+		int32 Count = 0;
+	};
+
+	/** Block BlockId, created if needed; null for blocks already given up on */
+	FBlock* FindOrAddBlock(uint64 BlockId);
+
+	/** Drop every block and forget the ids seen so far, for a publisher whose block ids start over */
+	void Restart();
+
+	/** Drop the oldest block and count what it still misses as lost */
+	void EvictOldest();
+
+	/** Rebuild the missing datagram if the parity and all other datagrams of Block are in */
+	void TryRecover(FBlock& Block, TArray<FSharedBuffer>& OutDatagrams);
+
+	TMap<uint64, FBlock> Blocks;
+
+	/** Blocks below this id were evicted; their late datagrams are passed through without FEC */
+	uint64 EvictedBelow = 0;
+
+	/** Highest block id seen since the last restart */
+	uint64 NewestBlockId = 0;
+
+	std::atomic<int64> NumRecovered{ 0 };
+	std::atomic<int64> NumLost{ 0 };
+};
@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Memory/SharedBuffer.h"
+#include <atomic>
+
+/**
+ * Splitting of datagram objects larger than one QUIC datagram, used by FMoqPublishOptions::bFragmentDatagrams.
+ *
+ * Every fragment is a MoqEnvelope::EKind::Fragment envelope: varint object id, varint object size,
+ * varint fragment index, varint fragment count, then the bytes. All fragments but the last carry
+ * ceil(size / count) bytes, so the receiver can place each one without any other fragment.
+ */
+namespace MoqFragment
+{
+	/**
+	 * Number of fragments needed to send Size bytes in datagrams of at most MaxDatagramSize bytes.
+	 * @return 0 if MaxDatagramSize cannot even fit the fragment header
+	 */
+	UNREALMOQ_API int32 GetFragmentCount(int64 Size, uint64 ObjectId, int32 MaxDatagramSize);
+
+	/** Replace Out with fragment Index of Count of Data */
+	UNREALMOQ_API void WriteFragment(TConstArrayView<uint8> Data, uint64 ObjectId, int32 Index, int32 Count, TArray<uint8>& Out);
+}
+
+/**
+ * Receive side of MoqFragment: collects fragments until their object is complete.
+ *
+ * Objects are reassembled in place in a buffer of their final size. The table is bounded in objects
+ * and bytes; objects that are not complete within the timeout, or that have to make room for newer
+ * ones, are discarded and counted as failures, checked whenever a new object starts. Add must only
+ * be called from one thread at a time; the limits and stats can be used from any thread.
+ */
+class UNREALMOQ_API FMoqFragmentReassembler
+{
+public:
+	/** Most objects reassembled at once */
+	static constexpr int32 MaxPendingObjects = 32;
+
+	/**
+	 * @param InMaxBytes Memory cap for partially received objects; larger objects are discarded
+	 * @param InTimeoutSeconds Time from the first fragment after which an incomplete object is discarded
+	 */
+	void SetLimits(int64 InMaxBytes, double InTimeoutSeconds);
+
+	/**
+	 * Add one fragment.
+	 * @param Fragment A MoqEnvelope::EKind::Fragment envelope
+	 * @param OutObject Receives the whole object once its last fragment arrived, left null until then
+	 * @return False if the fragment is malformed or does not match the other fragments of its object
+	 */
+	bool Add(const FSharedBuffer& Fragment, double Now, FSharedBuffer& OutObject);
+
+	int64 GetNumFragments() const { return NumFragments.load(std::memory_order_relaxed); }
+	int64 GetNumReassembled() const { return NumReassembled.load(std::memory_order_relaxed); }
+	int64 GetNumFailed() const { return NumFailed.load(std::memory_order_relaxed); }
+	int64 GetPendingBytes() const { return PendingBytes.load(std::memory_order_relaxed); }
+
+private:
+	struct FPendingObject
+	{
+		FUniqueBuffer Buffer;
+		TBitArray<> Received;
+		int32 NumReceived = 0;
+		double FirstArrival = 0.0;
+	};
+
+	/** Discard an incomplete object and count it as failed */
+	void Discard(uint64 ObjectId);
+
+	/** Discard objects past the timeout, then the oldest ones until Size more bytes fit */
+	void MakeRoom(int64 Size, double Now);
+
+	TMap<uint64, FPendingObject> Pending;
+
+	std::atomic<int64> MaxBytes{ 4 * 1024 * 1024 };
+	std::atomic<double> TimeoutSeconds{ 0.25 };
+
+	std::atomic<int64> NumFragments{ 0 };
+	std::atomic<int64> NumReassembled{ 0 };
+	std::atomic<int64> NumFailed{ 0 };
+	std::atomic<int64> PendingBytes{ 0 };
+};
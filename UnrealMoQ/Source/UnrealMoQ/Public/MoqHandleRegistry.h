@@ -0,0 +1,289 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include <atomic>
+
+/**
+ * Lock-free table of generation-checked handles handed to moq-ffi as callback user data.
+ *
+ * A handle packs a slot index and the slot's generation into the void* the C API carries, so a
+ * callback resolves it in O(1) without dereferencing a possibly destroyed object. While a callback
+ * holds a pin the slot cannot be unregistered; Unregister bumps the generation, so callbacks that
+ * arrive afterwards fail to pin and are dropped, then waits for in-flight pins to be released.
+ * Slots live in fixed-size pages that are never moved, and freed slots are recycled through a
+ * tagged lock-free free list.
+ */
+template <typename ObjectType>
+class TMoqHandleRegistry
+{
+	struct FSlot;
+
+public:
+	/** Slots per page */
+	static constexpr uint32 PageSize = 1024;
+
+	/** Upper bound on pages, and so on live handles (PageSize * MaxPages) */
+	static constexpr uint32 MaxPages = 1024;
+
+	/** Scoped pin on a resolved handle; the object stays registered until this goes out of scope */
+	class FPin
+	{
+	public:
+		FPin() = default;
+		FPin(const FPin&) = delete;
+		FPin& operator=(const FPin&) = delete;
+
+		FPin(FPin&& Other)
+			: Slot(Other.Slot)
+		{
+			Other.Slot = nullptr;
+		}
+
+		~FPin()
+		{
+			if (Slot)
+			{
+				Slot->State.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		ObjectType* Get() const { return Slot ? Slot->Object.load(std::memory_order_relaxed) : nullptr; }
+		explicit operator bool() const { return Slot != nullptr; }
+		ObjectType* operator->() const { return Get(); }
+
+	private:
+		friend class TMoqHandleRegistry;
+		FSlot* Slot = nullptr;
+	};
+
+	TMoqHandleRegistry() = default;
+	TMoqHandleRegistry(const TMoqHandleRegistry&) = delete;
+	TMoqHandleRegistry& operator=(const TMoqHandleRegistry&) = delete;
+
+	~TMoqHandleRegistry()
+	{
+		for (std::atomic<FSlot*>& Page : Pages)
+		{
+			delete[] Page.load(std::memory_order_relaxed);
+		}
+	}
+
+	/** Registry shared by every instance of ObjectType */
+	static TMoqHandleRegistry& Get()
+	{
+		static TMoqHandleRegistry Instance;
+		return Instance;
+	}
+
+	/**
+	 * Allocate a handle for Object.
+	 * @return Opaque user data for the C API, or nullptr if the registry is full
+	 */
+	void* Register(ObjectType* Object)
+	{
+		uint32 Index;
+		if (!PopFreeIndex(Index) && !AllocateIndex(Index))
+		{
+			return nullptr;
+		}
+
+		FSlot& Slot = GetSlot(Index);
+		Slot.Object.store(Object, std::memory_order_relaxed);
+
+		// The slot generation was advanced when it was last unregistered, so old handles cannot match it
+		const uint32 Generation = static_cast<uint32>(Slot.State.load(std::memory_order_acquire) >> GenerationShift);
+		return PackHandle(Index, Generation);
+	}
+
+	/**
+	 * Invalidate a handle. Callbacks that have not pinned it yet are dropped; callbacks that already
+	 * hold a pin are waited for. Must not be called while the calling thread holds a pin on Handle.
+	 * @return False if Handle was not (or is no longer) registered
+	 */
+	bool Unregister(void* Handle)
+	{
+		FSlot* Slot = FindSlot(Handle);
+		if (!Slot)
+		{
+			return false;
+		}
+
+		const uint64 Generation = UnpackGeneration(Handle);
+		uint64 State = Slot->State.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			if ((State >> GenerationShift) != Generation)
+			{
+				return false;
+			}
+
+			const uint64 NextState = (static_cast<uint64>(static_cast<uint32>(Generation + 1)) << GenerationShift) | (State & PinMask);
+			if (Slot->State.compare_exchange_weak(State, NextState, std::memory_order_acq_rel))
+			{
+				break;
+			}
+		}
+
+		while ((Slot->State.load(std::memory_order_acquire) & PinMask) != 0)
+		{
+			FPlatformProcess::YieldThread();
+		}
+
+		Slot->Object.store(nullptr, std::memory_order_relaxed);
+		PushFreeIndex(UnpackIndex(Handle));
+		return true;
+	}
+
+	/**
+	 * Resolve a handle from any thread.
+	 * @return A pin that converts to false if Handle is stale or unknown
+	 */
+	FPin Pin(void* Handle) const
+	{
+		FPin Result;
+		FSlot* Slot = FindSlot(Handle);
+		if (!Slot)
+		{
+			return Result;
+		}
+
+		const uint64 Generation = UnpackGeneration(Handle);
+		uint64 State = Slot->State.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			if ((State >> GenerationShift) != Generation)
+			{
+				return Result;
+			}
+
+			if (Slot->State.compare_exchange_weak(State, State + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			{
+				Result.Slot = Slot;
+				return Result;
+			}
+		}
+	}
+
+	/**
+	 * Look up a handle without pinning it. Only safe on the thread that calls Unregister (the game
+	 * thread for UObjects), where the object cannot be unregistered while the caller uses it.
+	 */
+	ObjectType* Resolve(void* Handle) const
+	{
+		FPin Pinned = Pin(Handle);
+		return Pinned.Get();
+	}
+
+	/** Handles currently registered */
+	int32 Num() const { return NumLive.load(std::memory_order_relaxed); }
+
+private:
+	struct FSlot
+	{
+		/** Generation in the high 32 bits, active pins in the low 32 bits */
+		std::atomic<uint64> State{ static_cast<uint64>(1) << GenerationShift };
+		std::atomic<ObjectType*> Object{ nullptr };
+		std::atomic<uint32> NextFree{ 0 };
+	};
+
+	static constexpr uint32 GenerationShift = 32;
+	static constexpr uint64 PinMask = 0xFFFFFFFFull;
+
+	/** Index 0 is never handed out so a valid handle is never nullptr */
+	static void* PackHandle(uint32 Index, uint32 Generation)
+	{
+		return reinterpret_cast<void*>(static_cast<UPTRINT>((static_cast<uint64>(Generation) << GenerationShift) | (Index + 1)));
+	}
+
+	static uint32 UnpackIndex(void* Handle)
+	{
+		return static_cast<uint32>(reinterpret_cast<UPTRINT>(Handle) & PinMask) - 1;
+	}
+
+	static uint64 UnpackGeneration(void* Handle)
+	{
+		return static_cast<uint64>(reinterpret_cast<UPTRINT>(Handle)) >> GenerationShift;
+	}
+
+	FSlot& GetSlot(uint32 Index) const
+	{
+		return Pages[Index / PageSize].load(std::memory_order_acquire)[Index % PageSize];
+	}
+
+	FSlot* FindSlot(void* Handle) const
+	{
+		if (!Handle || (reinterpret_cast<UPTRINT>(Handle) & PinMask) == 0)
+		{
+			return nullptr;
+		}
+
+		const uint32 Index = UnpackIndex(Handle);
+		if (Index >= NumAllocated.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+		return &GetSlot(Index);
+	}
+
+	bool PopFreeIndex(uint32& OutIndex)
+	{
+		// Head is (tag << 32) | (index + 1); the tag changes on every pop to defeat ABA
+		uint64 Head = FreeHead.load(std::memory_order_acquire);
+		while ((Head & PinMask) != 0)
+		{
+			const uint32 Index = static_cast<uint32>(Head & PinMask) - 1;
+			const uint64 Next = (((Head >> 32) + 1) << 32) | GetSlot(Index).NextFree.load(std::memory_order_relaxed);
+			if (FreeHead.compare_exchange_weak(Head, Next, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				OutIndex = Index;
+				NumLive.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void PushFreeIndex(uint32 Index)
+	{
+		FSlot& Slot = GetSlot(Index);
+		uint64 Head = FreeHead.load(std::memory_order_relaxed);
+		do
+		{
+			Slot.NextFree.store(static_cast<uint32>(Head & PinMask), std::memory_order_relaxed);
+		}
+		while (!FreeHead.compare_exchange_weak(Head, (Head & ~PinMask) | (Index + 1), std::memory_order_release, std::memory_order_relaxed));
+		NumLive.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	bool AllocateIndex(uint32& OutIndex)
+	{
+		// Growing is rare, so it may take a lock; resolving never does
+		FScopeLock Lock(&GrowLock);
+		const uint32 Index = NumAllocated.load(std::memory_order_relaxed);
+		if (Index >= PageSize * MaxPages)
+		{
+			return false;
+		}
+
+		std::atomic<FSlot*>& Page = Pages[Index / PageSize];
+		if (!Page.load(std::memory_order_relaxed))
+		{
+			Page.store(new FSlot[PageSize], std::memory_order_release);
+		}
+
+		NumAllocated.store(Index + 1, std::memory_order_release);
+		NumLive.fetch_add(1, std::memory_order_relaxed);
+		OutIndex = Index;
+		return true;
+	}
+
+	std::atomic<FSlot*> Pages[MaxPages] = {};
+	std::atomic<uint32> NumAllocated{ 0 };
+	std::atomic<uint64> FreeHead{ 0 };
+	std::atomic<int32> NumLive{ 0 };
+	FCriticalSection GrowLock;
+};
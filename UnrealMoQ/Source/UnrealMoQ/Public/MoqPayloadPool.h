@@ -0,0 +1,70 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/LockFreeList.h"
+#include "Memory/SharedBuffer.h"
+#include <atomic>
+
+/**
+ * Slab pool backing received payloads.
+ *
+ * Payloads are copied out of the moq-ffi buffer exactly once into a pooled block wrapped in an
+ * FSharedBuffer. The buffer is then moved through the receive queue and handed to listeners as a
+ * view; when the last reference goes away the block returns to its size class instead of the heap.
+ * Blocks are bucketed by power-of-two size, larger payloads fall back to a plain allocation.
+ */
+class UNREALMOQ_API FMoqPayloadPool
+{
+public:
+	/** Smallest pooled block (bytes, as a power of two exponent) */
+	static constexpr int32 MinBlockShift = 6;
+
+	/** Largest pooled block (bytes, as a power of two exponent); bigger payloads are not pooled */
+	static constexpr int32 MaxBlockShift = 20;
+
+	static constexpr int32 NumBuckets = MaxBlockShift - MinBlockShift + 1;
+
+	static FMoqPayloadPool& Get();
+
+	~FMoqPayloadPool();
+
+	/**
+	 * Copy Size bytes from Data into a pooled block.
+	 * Safe to call from any thread.
+	 */
+	FSharedBuffer CopyFrom(const void* Data, uint64 Size);
+
+	/**
+	 * Take a Size-byte pooled block and let Fill write it in place, for payloads produced by
+	 * conversion rather than copied. Safe to call from any thread.
+	 */
+	FSharedBuffer Allocate(uint64 Size, TFunctionRef<void(uint8*)> Fill);
+
+	/** Free every cached block (called from module shutdown) */
+	void Trim();
+
+	/** Allocations served from a cached block */
+	int64 GetNumReused() const { return NumReused.load(std::memory_order_relaxed); }
+
+	/** Allocations that had to go to the heap */
+	int64 GetNumAllocated() const { return NumAllocated.load(std::memory_order_relaxed); }
+
+private:
+	struct FBucket
+	{
+		TLockFreePointerListUnordered<uint8, PLATFORM_CACHE_LINE_SIZE> FreeBlocks;
+		std::atomic<int32> NumCached{ 0 };
+	};
+
+	static int32 GetBucketIndex(uint64 Size);
+	static uint64 GetBlockSize(int32 BucketIndex);
+	static int32 GetMaxCachedBlocks(int32 BucketIndex);
+
+	void Release(uint8* Block, int32 BucketIndex);
+
+	FBucket Buckets[NumBuckets];
+	std::atomic<int64> NumReused{ 0 };
+	std::atomic<int64> NumAllocated{ 0 };
+};
@@ -4,17 +4,32 @@
 
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
+#include "Memory/SharedBuffer.h"
 #include "moq_ffi.h"
 #include "MoqTypes.h"
 #include "MoqPublisher.generated.h"
 
 // Forward declarations
 class UMoqClient;
+class FMoqPublisherSendState;
+
+/** Delegate for publishes that failed on the sender thread */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqPublishFailed, const FString&, ErrorMessage);
+
+/** Delegate for the send window filling up or draining */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqBackpressureChanged, bool, bBackpressured);
 
 /**
  * UMoqPublisher - Unreal wrapper for MoQ publisher functionality
  * 
  * This class provides a Blueprint-friendly interface to publish data on a MoQ track.
+ * In EMoqPublishMode::Async, publishes are copied into a lock-free queue and sent by the
+ * module's sender thread, so the caller never waits on moq-ffi. The queue is bounded by a send
+ * window; when it fills, EMoqBackpressurePolicy decides what happens to new objects and
+ * OnBackpressureChanged lets producers slow down until it drains. With FMoqPublishOptions::bCoalesce,
+ * stream publishes made during a frame are packed into one object sent at the end of the frame.
+ * A rate limit, on the publisher or on its client, spreads bursts out over time on the sender thread,
+ * which serves queued publishers by priority and can discard objects that waited too long.
  */
 UCLASS(BlueprintType)
 class UNREALMOQ_API UMoqPublisher : public UObject
@@ -28,15 +43,38 @@ public:
 	// UObject interface
 	virtual void BeginDestroy() override;
 
+	/**
+	 * Event fired on the game thread when a queued publish fails on the sender thread.
+	 * Failures in EMoqPublishMode::Immediate are returned directly instead.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
+	FMoqPublishFailed OnPublishFailed;
+
+	/**
+	 * Event fired on the game thread when the async send window fills (true) and when the queue
+	 * has drained to half of it again (false)
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
+	FMoqBackpressureChanged OnBackpressureChanged;
+
 	/**
 	 * Publish binary data on the track
 	 * @param Data Array of bytes to publish
 	 * @param DeliveryMode Delivery mode (datagram or stream)
-	 * @return Result of the publish operation
+	 * @return Result of the publish operation; in async mode, whether the data was queued
 	 */
 	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
 	FMoqResult PublishData(const TArray<uint8>& Data, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
 
+	/** Publish borrowed bytes; copied only if the publish is queued for the sender thread */
+	FMoqResult PublishData(TConstArrayView<uint8> Data, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
+	/** Publish a shared buffer; in async mode the buffer itself is queued, without a copy */
+	FMoqResult PublishData(const FSharedBuffer& Payload, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
+	/** Publish an array the caller gives up; in async mode its allocation is queued, without a copy */
+	FMoqResult PublishData(TArray<uint8>&& Data, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
 	/**
 	 * Publish a string as UTF-8 data on the track
 	 * @param Text Text to publish
@@ -46,10 +84,137 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
 	FMoqResult PublishText(const FString& Text, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
 
+	/**
+	 * Publish a reflected struct in the compact binary form of MoqStructSerializer, for subscribers
+	 * to decode with UMoqSubscriber::OnStructReceived or the Decode Struct node
+	 * @param Value Struct to publish
+	 * @param DeliveryMode Delivery mode (datagram or stream)
+	 * @return Result of the publish operation
+	 */
+	template <typename StructType>
+	FMoqResult PublishStruct(const StructType& Value, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream)
+	{
+		return PublishStruct(StructType::StaticStruct(), &Value, DeliveryMode);
+	}
+
+	/** Publish Value, an instance of Struct, in the binary form of MoqStructSerializer */
+	FMoqResult PublishStruct(const UScriptStruct* Struct, const void* Value, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
+	/**
+	 * Publish any struct in a compact binary form, for subscribers to read back with the Decode Struct
+	 * node. Much smaller and cheaper than publishing it as JSON text.
+	 * @param Value Struct to publish
+	 * @param DeliveryMode Delivery mode (datagram or stream)
+	 * @return Result of the publish operation
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk, Category = "MoQ|Publishing", meta = (DisplayName = "Publish Struct", CustomStructureParam = "Value"))
+	FMoqResult K2_PublishStruct(const int32& Value, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+	DECLARE_FUNCTION(execK2_PublishStruct);
+
+	/**
+	 * Publish several objects on the track in one call
+	 * @param Objects Payloads to publish, in order
+	 * @param DeliveryMode Delivery mode applied to every object
+	 * @return Count of published (or queued) objects, the indices that failed and the first error
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing", meta = (DisplayName = "Publish Batch"))
+	FMoqBatchPublishResult PublishBatch(const TArray<FMoqPublishPayload>& Objects, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
+	/** Publish several objects without copying them into Blueprint payload structs first */
+	FMoqBatchPublishResult PublishBatch(TConstArrayView<TConstArrayView<uint8>> Objects, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+	FMoqBatchPublishResult PublishBatch(const TArray<TArray<uint8>>& Objects, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream);
+
+	/**
+	 * Switch between publishing on the calling thread and queueing for the sender thread. Safe to call at any time.
+	 * @param Mode Immediate calls moq-ffi directly, Async returns as soon as the data is queued
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void SetPublishMode(EMoqPublishMode Mode);
+
+	/** Current publish mode */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	EMoqPublishMode GetPublishMode() const;
+
+	/**
+	 * Change the order in which the sender thread serves this publisher relative to others
+	 * @param Priority Lower values are sent first (default 128)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void SetPriority(uint8 Priority);
+
+	/** Current send priority */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	uint8 GetPriority() const;
+
+	/**
+	 * Pace this publisher's objects on the sender thread; also subject to the client's aggregate limit.
+	 * While any limit applies, publishes are queued even in EMoqPublishMode::Immediate.
+	 * @param Limit Bytes and objects per second, 0 for unlimited
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void SetRateLimit(const FMoqRateLimit& Limit);
+
+	/**
+	 * Send stream publishes buffered by FMoqPublishOptions::bCoalesce now instead of at the end of the frame
+	 * @return Result of publishing the packed object; success if nothing was buffered
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	FMoqResult FlushCoalesced();
+
+	/** With FMoqPublishOptions::bDeltaEncoding, send the next object as a full keyframe (e.g. when a subscriber joins) */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	void RequestKeyframe();
+
+	/**
+	 * Start a new MoQ group with the next publish. From the first call on, every publish carries its
+	 * group id and object id within the group, and the first object of each group is sent whole (a
+	 * delta keyframe, and never packed behind earlier publishes), so a subscriber that joins there can
+	 * decode it. Call it with each state snapshot or keyframe. Subscribers need bDecodeEnvelopes.
+	 * @return Id of the new group, counting from 0; -1 if the publisher is not initialized
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Publishing")
+	int64 StartGroup();
+
+	/** Id of the group being published, -1 before the first StartGroup */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	int64 GetCurrentGroupId() const;
+
+	/** Whether the async send window is currently full (see OnBackpressureChanged) */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	bool IsBackpressured() const;
+
+	/** Snapshot of the send counters, queue depth and enqueue-to-send latency */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Publishing")
+	FMoqPublisherStats GetPublisherStats() const;
+
+	/** Apply publish options (internal use, before or after InitializeFromHandle) */
+	void ApplyOptions(const FMoqPublishOptions& Options);
+
+	/** Route id of this track for the client's datagram aggregation (internal use, before InitializeFromHandle) */
+	void SetAggregationRoute(uint32 RouteId) { AggregationRouteId = RouteId; }
+
 	/** Initialize from native handle (internal use) */
 	void InitializeFromHandle(MoqPublisher* Handle);
 
+	/** Broadcast OnBackpressureChanged if the send state changed since the last broadcast (internal use, game thread) */
+	void UpdateBackpressureState();
+
 private:
-	/** Handle to the native MoQ publisher */
-	MoqPublisher* PublisherHandle;
+	/** Publish borrowed bytes according to the current mode, copying them if they are queued */
+	FMoqResult PublishBytes(const uint8* Data, int64 Size, EMoqDeliveryMode DeliveryMode);
+
+	/** Publish an owned buffer according to the current mode, queueing it as-is */
+	FMoqResult PublishBuffer(FSharedBuffer&& Payload, EMoqDeliveryMode DeliveryMode);
+
+	/** Options used for the send state, kept so they can be applied before the handle exists */
+	FMoqPublishOptions PublishOptions;
+
+	/** MoqAggregation::GetRouteId of this track */
+	uint32 AggregationRouteId = 0;
+
+	/** Backpressure state last broadcast, so late or duplicate notifications are ignored */
+	bool bBackpressureBroadcast = false;
+
+	/** Owns the native MoQ publisher handle; shared with the sender thread */
+	TSharedPtr<FMoqPublisherSendState, ESPMode::ThreadSafe> SendState;
 };
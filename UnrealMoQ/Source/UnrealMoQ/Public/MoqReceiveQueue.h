@@ -0,0 +1,349 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "Memory/SharedBuffer.h"
+#include "Templates/UniquePtr.h"
+#include "MoqTypes.h"
+#include <atomic>
+
+/** A single object handed from the moq-ffi callback thread to the game thread */
+struct FMoqReceivedObject
+{
+	/** Raw payload bytes, filled once from the moq-ffi buffer and shared from then on */
+	FSharedBuffer Payload;
+
+	/** FPlatformTime::Seconds() when the moq-ffi callback delivered the object */
+	double ArrivalTime = 0.0;
+
+	/** Per-subscriber arrival index, assigned on the callback thread */
+	int64 Sequence = 0;
+
+	/** MoQ group and object ids set by the publisher with UMoqPublisher::StartGroup, INDEX_NONE if it does not use groups */
+	int64 GroupId = INDEX_NONE;
+	int64 ObjectId = INDEX_NONE;
+
+	/** View of the payload bytes, valid for as long as this object (or a copy of Payload) lives */
+	TConstArrayView<uint8> GetData() const
+	{
+		return MakeArrayView(static_cast<const uint8*>(Payload.GetData()), static_cast<int32>(Payload.GetSize()));
+	}
+};
+
+/**
+ * Bounded lock-free ring buffer used to move received objects off the moq-ffi callback thread.
+ *
+ * Each slot carries its own sequence number (Vyukov-style), which keeps the ring safe when the
+ * producer has to evict the oldest entry itself under EMoqOverflowPolicy::DropOldest. In the
+ * common case there is exactly one producer (the network callback) and one consumer (the game
+ * thread drain), and neither side ever takes a lock.
+ */
+template <typename ElementType>
+class TMoqBoundedRing
+{
+public:
+	explicit TMoqBoundedRing(int32 InCapacity = 256)
+	{
+		Reset(InCapacity);
+	}
+
+	TMoqBoundedRing(const TMoqBoundedRing&) = delete;
+	TMoqBoundedRing& operator=(const TMoqBoundedRing&) = delete;
+
+	/** Reallocate the ring. Not thread safe: only call while no producer or consumer is active. */
+	void Reset(int32 InCapacity)
+	{
+		const uint32 NewCapacity = FMath::RoundUpToPowerOfTwo(static_cast<uint32>(FMath::Max(InCapacity, 2)));
+		Mask = NewCapacity - 1;
+		Slots = MakeUnique<FSlot[]>(NewCapacity);
+		for (uint32 Index = 0; Index < NewCapacity; ++Index)
+		{
+			Slots[Index].Sequence.store(Index, std::memory_order_relaxed);
+		}
+		EnqueuePos.store(0, std::memory_order_relaxed);
+		DequeuePos.store(0, std::memory_order_relaxed);
+		NumEnqueued.store(0, std::memory_order_relaxed);
+		NumDropped.store(0, std::memory_order_relaxed);
+		NumBlocked.store(0, std::memory_order_relaxed);
+		PeakNum.store(0, std::memory_order_relaxed);
+		bClosed.store(false, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Move Item into the ring if there is room. Item is left untouched on failure.
+	 * @param Timestamp Caller's time for the element, reported by PeekOldestTimestamp
+	 */
+	bool TryEnqueue(ElementType& Item, double Timestamp = 0.0)
+	{
+		uint64 Pos = EnqueuePos.load(std::memory_order_relaxed);
+		FSlot* Slot;
+		for (;;)
+		{
+			Slot = &Slots[Pos & Mask];
+			const uint64 Sequence = Slot->Sequence.load(std::memory_order_acquire);
+			const int64 Diff = static_cast<int64>(Sequence) - static_cast<int64>(Pos);
+			if (Diff == 0)
+			{
+				if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		Slot->Value = MoveTemp(Item);
+		Slot->Timestamp.store(Timestamp, std::memory_order_relaxed);
+		Slot->Sequence.store(Pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Pop the oldest element. Returns false when the ring is empty. */
+	bool TryDequeue(ElementType& OutItem)
+	{
+		uint64 Pos = DequeuePos.load(std::memory_order_relaxed);
+		FSlot* Slot;
+		for (;;)
+		{
+			Slot = &Slots[Pos & Mask];
+			const uint64 Sequence = Slot->Sequence.load(std::memory_order_acquire);
+			const int64 Diff = static_cast<int64>(Sequence) - static_cast<int64>(Pos + 1);
+			if (Diff == 0)
+			{
+				if (DequeuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if (Diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = DequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		OutItem = MoveTemp(Slot->Value);
+		Slot->Value = ElementType();
+		Slot->Sequence.store(Pos + Mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Push an element, applying the overflow policy when the ring is full.
+	 * Block degrades to DropNewest on the game thread (it would never drain) and once the ring is closed.
+	 * @return True if Item was stored in the ring
+	 */
+	bool Enqueue(ElementType&& Item, EMoqOverflowPolicy Policy, double Timestamp = 0.0)
+	{
+		bool bStored = TryEnqueue(Item, Timestamp);
+		if (!bStored)
+		{
+			switch (Policy)
+			{
+			case EMoqOverflowPolicy::DropOldest:
+				while (!bStored)
+				{
+					ElementType Evicted;
+					if (TryDequeue(Evicted))
+					{
+						NumDropped.fetch_add(1, std::memory_order_relaxed);
+					}
+					bStored = TryEnqueue(Item, Timestamp);
+				}
+				break;
+
+			case EMoqOverflowPolicy::Block:
+				if (!IsInGameThread())
+				{
+					NumBlocked.fetch_add(1, std::memory_order_relaxed);
+					while (!bStored && !bClosed.load(std::memory_order_acquire))
+					{
+						FPlatformProcess::SleepNoStats(0.0f);
+						bStored = TryEnqueue(Item, Timestamp);
+					}
+				}
+				if (!bStored)
+				{
+					NumDropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				break;
+
+			case EMoqOverflowPolicy::DropNewest:
+			default:
+				NumDropped.fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+		}
+
+		if (bStored)
+		{
+			NumEnqueued.fetch_add(1, std::memory_order_relaxed);
+			const int32 Depth = Num();
+			int32 Peak = PeakNum.load(std::memory_order_relaxed);
+			while (Depth > Peak && !PeakNum.compare_exchange_weak(Peak, Depth, std::memory_order_relaxed))
+			{
+			}
+		}
+		return bStored;
+	}
+
+	/**
+	 * Timestamp the oldest element was pushed with, without removing it (consumer side only). Only the
+	 * slot's atomics are read, so a DropOldest producer may evict and refill the slot meanwhile; that is
+	 * detected and the read is retried on the new head.
+	 * @return False when the ring is empty
+	 */
+	bool PeekOldestTimestamp(double& OutTimestamp) const
+	{
+		uint64 Pos = DequeuePos.load(std::memory_order_acquire);
+		for (;;)
+		{
+			const FSlot& Slot = Slots[Pos & Mask];
+			const bool bReady = Slot.Sequence.load(std::memory_order_acquire) == Pos + 1;
+			if (bReady)
+			{
+				OutTimestamp = Slot.Timestamp.load(std::memory_order_relaxed);
+			}
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64 CurrentPos = DequeuePos.load(std::memory_order_relaxed);
+			if (CurrentPos == Pos)
+			{
+				return bReady;
+			}
+			Pos = CurrentPos;
+		}
+	}
+
+	/** Release any producer blocked under EMoqOverflowPolicy::Block; further blocking pushes drop instead. */
+	void Close()
+	{
+		bClosed.store(true, std::memory_order_release);
+	}
+
+	/** Approximate number of queued elements (exact when called from the only consumer with no producer active). */
+	int32 Num() const
+	{
+		const uint64 Head = DequeuePos.load(std::memory_order_relaxed);
+		const uint64 Tail = EnqueuePos.load(std::memory_order_relaxed);
+		return Tail > Head ? static_cast<int32>(FMath::Min<uint64>(Tail - Head, Mask + 1)) : 0;
+	}
+
+	int32 Capacity() const { return static_cast<int32>(Mask + 1); }
+	int64 GetNumEnqueued() const { return NumEnqueued.load(std::memory_order_relaxed); }
+	int64 GetNumDropped() const { return NumDropped.load(std::memory_order_relaxed); }
+	int64 GetNumBlocked() const { return NumBlocked.load(std::memory_order_relaxed); }
+	int32 GetPeakNum() const { return PeakNum.load(std::memory_order_relaxed); }
+
+private:
+	struct FSlot
+	{
+		std::atomic<uint64> Sequence{ 0 };
+
+		/** Set with Value, but atomic so the consumer can read the head while producers run */
+		std::atomic<double> Timestamp{ 0.0 };
+		ElementType Value;
+	};
+
+	TUniquePtr<FSlot[]> Slots;
+	uint64 Mask = 0;
+
+	/** Producer and consumer cursors are kept on separate cache lines */
+	std::atomic<uint64> EnqueuePos{ 0 };
+	uint8 CursorPadding[PLATFORM_CACHE_LINE_SIZE];
+	std::atomic<uint64> DequeuePos{ 0 };
+
+	std::atomic<int64> NumEnqueued{ 0 };
+	std::atomic<int64> NumDropped{ 0 };
+	std::atomic<int64> NumBlocked{ 0 };
+	std::atomic<int32> PeakNum{ 0 };
+	std::atomic<bool> bClosed{ false };
+};
+
+/**
+ * Single-slot mailbox that only keeps the newest element (a lock-free triple buffer).
+ *
+ * The producer writes into a private back slot and swaps it with the shared middle slot; the
+ * consumer swaps the middle slot with its private front slot when a new value is flagged. Neither
+ * side waits and nothing is queued, so an element that is not taken before the next one arrives
+ * is superseded. Supports one producer and one consumer at a time.
+ */
+template <typename ElementType>
+class TMoqLatestValue
+{
+public:
+	TMoqLatestValue() = default;
+
+	TMoqLatestValue(const TMoqLatestValue&) = delete;
+	TMoqLatestValue& operator=(const TMoqLatestValue&) = delete;
+
+	/**
+	 * Publish Item, replacing any element the consumer has not taken yet.
+	 * @return True if an untaken element was superseded
+	 */
+	bool Exchange(ElementType&& Item)
+	{
+		Slots[BackIndex] = MoveTemp(Item);
+		const uint8 Previous = Middle.exchange(BackIndex | NewValueFlag, std::memory_order_acq_rel);
+		BackIndex = Previous & IndexMask;
+		NumPublished.fetch_add(1, std::memory_order_relaxed);
+
+		if (Previous & NewValueFlag)
+		{
+			// Release the superseded element now rather than when this slot is next written
+			Slots[BackIndex] = ElementType();
+			NumSuperseded.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	/** Take the newest element if one was published since the last call */
+	bool TryTake(ElementType& OutItem)
+	{
+		if (!HasNewValue())
+		{
+			return false;
+		}
+
+		const uint8 Previous = Middle.exchange(FrontIndex, std::memory_order_acq_rel);
+		FrontIndex = Previous & IndexMask;
+		OutItem = MoveTemp(Slots[FrontIndex]);
+		Slots[FrontIndex] = ElementType();
+		return true;
+	}
+
+	bool HasNewValue() const { return (Middle.load(std::memory_order_acquire) & NewValueFlag) != 0; }
+	int64 GetNumPublished() const { return NumPublished.load(std::memory_order_relaxed); }
+	int64 GetNumSuperseded() const { return NumSuperseded.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr uint8 IndexMask = 0x3;
+	static constexpr uint8 NewValueFlag = 0x4;
+
+	ElementType Slots[3];
+
+	/** Consumer-owned slot */
+	uint8 FrontIndex = 0;
+
+	/** Shared slot index plus NewValueFlag */
+	std::atomic<uint8> Middle{ 1 };
+
+	/** Producer-owned slot */
+	uint8 BackIndex = 2;
+
+	std::atomic<int64> NumPublished{ 0 };
+	std::atomic<int64> NumSuperseded{ 0 };
+};
@@ -0,0 +1,58 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UScriptStruct;
+
+/**
+ * Compact binary encoding of reflected structs, used by UMoqPublisher::PublishStruct and
+ * UMoqSubscriber::OnStructReceived.
+ *
+ * An encoded struct starts with FormatVersion and the struct's 32-bit schema hash (little-endian),
+ * then its properties in declaration order: numbers and enums as they are in memory, with runs
+ * of them that are adjacent in memory copied as one block; bools as one byte, 0 or 1, and any
+ * other byte decodes as true; strings and names as a varint UTF-8 length and the bytes; arrays as a varint count and their elements; nested structs inline.
+ * Object references, maps, sets and text are not encoded, are left untouched on decode and are
+ * not part of the schema. Values are stored in memory byte order, which is little-endian on every
+ * platform Unreal supports.
+ *
+ * The reflection data is walked once per struct to build a layout plan, which is cached, so
+ * encoding and decoding are a loop over a handful of copy steps. The schema hash covers the name
+ * and type of every encoded property, so a struct published by a build with a different layout
+ * is rejected instead of misread. Safe to use from any thread.
+ */
+namespace MoqStructSerializer
+{
+	/** First byte of every encoded struct */
+	static constexpr uint8 FormatVersion = 1;
+
+	/** Bytes before the first property */
+	static constexpr int32 HeaderSize = 5;
+
+	/** Hash of the names and types of the properties of Struct that are encoded */
+	UNREALMOQ_API uint32 GetSchemaHash(const UScriptStruct* Struct);
+
+	/** Replace Out with the encoding of Value, an instance of Struct */
+	UNREALMOQ_API void Serialize(const UScriptStruct* Struct, const void* Value, TArray<uint8>& Out);
+
+	/**
+	 * Decode Data into OutValue, an instance of Struct.
+	 * @param OutError Receives why decoding failed; only built when set
+	 * @return False if Data is not an encoding of Struct with the same schema; OutValue may be partly overwritten
+	 */
+	UNREALMOQ_API bool Deserialize(const UScriptStruct* Struct, TConstArrayView<uint8> Data, void* OutValue, FString* OutError = nullptr);
+
+	template <typename StructType>
+	void Serialize(const StructType& Value, TArray<uint8>& Out)
+	{
+		Serialize(StructType::StaticStruct(), &Value, Out);
+	}
+
+	template <typename StructType>
+	bool Deserialize(TConstArrayView<uint8> Data, StructType& OutValue, FString* OutError = nullptr)
+	{
+		return Deserialize(StructType::StaticStruct(), Data, &OutValue, OutError);
+	}
+}
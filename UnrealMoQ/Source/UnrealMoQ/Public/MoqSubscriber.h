@@ -5,10 +5,16 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "moq_ffi.h"
+#include "MoqTypes.h"
+#include "MoqReceiveQueue.h"
+#include "MoqDataSink.h"
+#include "MoqEnvelopeDecoder.h"
+#include "UObject/StructOnScope.h"
 #include "MoqSubscriber.generated.h"
 
 // Forward declarations
 class UMoqClient;
+class FMoqDataSinkBinding;
 
 /** Delegate for data received events */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqDataReceived, const TArray<uint8>&, Data);
@@ -16,10 +22,28 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqDataReceived, const TArray<uint8
 /** Delegate for text received events */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqTextReceived, FString, Text);
 
+/** Delegate for all objects delivered in one frame */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqDataBatchReceived, const TArray<FMoqReceivedMessage>&, Messages);
+
+/** Native delegate for data received events; the view is only valid for the duration of the broadcast */
+DECLARE_MULTICAST_DELEGATE_OneParam(FMoqPayloadReceivedNative, TConstArrayView<uint8>);
+
+/** Delegate for the first object of a group, fired before the object itself is delivered */
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FMoqGroupStarted, int64, GroupId);
+
+/** Native delegate for objects decoded as the subscriber's struct type; the value is only valid for the duration of the broadcast */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FMoqStructReceivedNative, const UScriptStruct*, const void*);
+
+/** Native delegate for all objects delivered in one frame; payloads may be retained by copying the FMoqReceivedObject */
+DECLARE_MULTICAST_DELEGATE_OneParam(FMoqPayloadBatchReceivedNative, TConstArrayView<FMoqReceivedObject>);
+
 /**
  * UMoqSubscriber - Unreal wrapper for MoQ subscriber functionality
  * 
  * This class provides a Blueprint-friendly interface to subscribe to data on a MoQ track.
+ * Objects arriving on the moq-ffi callback thread are pushed into a bounded receive queue
+ * which the module drains once per frame on the game thread. Native consumers can register
+ * an IMoqDataSink to receive the same objects on the callback thread or a worker instead.
  */
 UCLASS(BlueprintType)
 class UNREALMOQ_API UMoqSubscriber : public UObject
@@ -31,23 +55,309 @@ public:
 	virtual ~UMoqSubscriber();
 
 	// UObject interface
+	virtual void PostInitProperties() override;
 	virtual void BeginDestroy() override;
 
 	/** Event fired when binary data is received */
 	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
 	FMoqDataReceived OnDataReceived;
 
-	/** Event fired when text data is received (convenience, attempts UTF-8 decode) */
+	/**
+	 * Event fired when text data is received (convenience, attempts UTF-8 decode).
+	 * Decoding happens on the game thread and only while something is bound, unless the track content says otherwise.
+	 */
 	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
 	FMoqTextReceived OnTextReceived;
 
+	/**
+	 * Native event fired when binary data is received, before OnDataReceived.
+	 * Receives a view of the pooled payload so no copy is made; copy the bytes if they must outlive the call.
+	 */
+	FMoqPayloadReceivedNative OnPayloadReceived;
+
+	/**
+	 * Event fired once per frame with every object delivered in that frame, in arrival order.
+	 * Cheaper than OnDataReceived for high-rate tracks: one delegate call per track per frame.
+	 */
+	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
+	FMoqDataBatchReceived OnDataBatchReceived;
+
+	/** Native counterpart of OnDataBatchReceived; shares the pooled payloads instead of copying them */
+	FMoqPayloadBatchReceivedNative OnPayloadBatchReceived;
+
+	/**
+	 * Native event fired, after OnPayloadReceived, with every object that decodes as the struct type
+	 * set by SetReceiveStruct (see UMoqPublisher::PublishStruct). The value is decoded into storage
+	 * reused from one object to the next. Blueprints decode OnDataReceived with the Decode Struct node.
+	 */
+	FMoqStructReceivedNative OnStructReceived;
+
+	/**
+	 * Decode objects as StructType for OnStructReceived; objects of another schema are counted in
+	 * FMoqReceiveQueueStats::StructDecodeFailures. Game thread only.
+	 */
+	void SetReceiveStruct(const UScriptStruct* StructType);
+
+	/** Decode objects as StructType and call Handler with each one, through OnStructReceived */
+	template <typename StructType, typename FunctorType>
+	FDelegateHandle AddStructHandler(FunctorType&& Handler)
+	{
+		SetReceiveStruct(StructType::StaticStruct());
+		return OnStructReceived.AddLambda([Handler = Forward<FunctorType>(Handler)](const UScriptStruct* Struct, const void* Value)
+		{
+			if (Struct == StructType::StaticStruct())
+			{
+				Handler(*static_cast<const StructType*>(Value));
+			}
+		});
+	}
+
+	/** Event fired when the publisher starts a new group (UMoqPublisher::StartGroup): a keyframe that decodes on its own follows */
+	UPROPERTY(BlueprintAssignable, Category = "MoQ|Events")
+	FMoqGroupStarted OnGroupStarted;
+
+	/**
+	 * Change how the receive queue behaves when it is full. Safe to call at any time.
+	 * @param Policy New overflow policy
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void SetOverflowPolicy(EMoqOverflowPolicy Policy);
+
+	/** Current receive queue overflow policy */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	EMoqOverflowPolicy GetOverflowPolicy() const;
+
+	/**
+	 * Switch between delivering every object and only the newest one per frame. Safe to call at any time;
+	 * objects already queued are still delivered after switching to conflation.
+	 * @param Mode Queue delivers everything, Conflate keeps only the latest object (for absolute state such as transforms)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void SetReceiveMode(EMoqReceiveMode Mode);
+
+	/** Current receive mode */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	EMoqReceiveMode GetReceiveMode() const;
+
+	/**
+	 * Declare what the track carries so the receive path can skip unnecessary UTF-8 decoding.
+	 * @param Content Auto decodes only while OnTextReceived is bound, Binary never decodes, Text skips the OnDataReceived copy
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void SetTrackContent(EMoqTrackContent Content);
+
+	/** Current track content setting */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	EMoqTrackContent GetTrackContent() const;
+
+	/** Snapshot of the receive queue counters */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	FMoqReceiveQueueStats GetReceiveQueueStats() const;
+
+	/**
+	 * Register a native sink that receives every object off the game thread.
+	 * Safe to call from any thread; objects already received are not replayed.
+	 * @param Sink Consumer to invoke; the subscriber keeps a reference until it is removed or destroyed
+	 * @param Options Thread, task priority and queue size for the sink
+	 */
+	void AddDataSink(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& Sink, const FMoqDataSinkOptions& Options = FMoqDataSinkOptions());
+
+	/**
+	 * Unregister a sink. Safe to call from any thread, including from inside the sink.
+	 * A worker sink may still receive objects that were queued before removal.
+	 */
+	void RemoveDataSink(const TSharedRef<IMoqDataSink, ESPMode::ThreadSafe>& Sink);
+
+	/**
+	 * Enable or disable the game thread receive queue and its events. Disable it when only native
+	 * sinks consume the track so nothing is queued for the game thread. Safe to call at any time.
+	 */
+	void SetGameThreadDeliveryEnabled(bool bEnabled);
+
+	/** Whether objects are queued for OnPayloadReceived, OnDataReceived and OnTextReceived */
+	bool IsGameThreadDeliveryEnabled() const;
+
+	/**
+	 * Enable or disable the module's per-frame drain for this subscriber. While disabled no events are
+	 * broadcast and objects stay in the receive queue until pulled with TryDequeue, DrainInto or PollMessages.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void SetAutoDispatchEnabled(bool bEnabled);
+
+	/** Whether the module broadcasts events for this subscriber every frame */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	bool IsAutoDispatchEnabled() const;
+
+	/**
+	 * Enable or disable unpacking of objects the publisher framed (see MoqEnvelope), such as coalesced
+	 * publishes. Unpacked payloads are delivered one by one as if they had been separate objects.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void SetEnvelopeDecodingEnabled(bool bEnabled);
+
+	/** Whether framed objects are unpacked before delivery */
+	UFUNCTION(BlueprintPure, Category = "MoQ|Subscribing")
+	bool IsEnvelopeDecodingEnabled() const;
+
+	/**
+	 * Register the preset dictionary a publisher uses with EMoqCompression::ZlibDictionary. Objects
+	 * name their dictionary by id, so several can be registered while a publisher rolls over to a new one.
+	 * Safe to call at any time; compressed objects that arrive before their dictionary are counted as malformed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	void AddCompressionDictionary(const TArray<uint8>& Dictionary);
+
+	/**
+	 * Pull the oldest received object. Safe to call from any thread; under EMoqReceiveMode::Conflate
+	 * only one thread may pull at a time. Do not mix with auto dispatch.
+	 * @return False if nothing is waiting
+	 */
+	bool TryDequeue(FMoqReceivedObject& OutObject);
+
+	/**
+	 * Append up to MaxObjects received objects to OutObjects, oldest first. Same threading rules as TryDequeue.
+	 * @return Number of objects appended
+	 */
+	int32 DrainInto(TArray<FMoqReceivedObject>& OutObjects, int32 MaxObjects = MAX_int32);
+
+	/**
+	 * Blueprint counterpart of DrainInto, copying payloads into FMoqReceivedMessage.
+	 * @param MaxMessages Upper bound on messages returned, 0 for everything waiting
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MoQ|Subscribing")
+	TArray<FMoqReceivedMessage> PollMessages(int32 MaxMessages = 0);
+
+	/** Apply subscribe options (internal use, must happen before InitializeFromHandle) */
+	void ApplyOptions(const FMoqSubscribeOptions& Options);
+
 	/** Initialize from native handle (internal use) */
 	void InitializeFromHandle(MoqSubscriber* Handle);
 
-	/** C callback for data received */
+	/**
+	 * Broadcast everything currently waiting in the receive queue (internal use, game thread only).
+	 * Called by the module once per frame; exposed so tests and custom loops can pump it directly.
+	 * @param EndTimeSeconds FPlatformTime::Seconds() after which remaining objects are carried over to the next call
+	 * @return Number of objects delivered
+	 */
+	int32 DispatchPendingEvents(double EndTimeSeconds = TNumericLimits<double>::Max());
+
+	/** Opaque handle passed to moq-ffi as callback user data (internal use) */
+	void* GetCallbackUserData() const { return CallbackHandle; }
+
+	/** C callback for data received; UserData is the handle from GetCallbackUserData */
 	static void OnDataReceivedCallback(void* UserData, const uint8_t* Data, size_t DataLen);
 
+	/**
+	 * Receive an object of this track unpacked from the client's aggregation track. That thread serves
+	 * every aggregated track, so it never blocks: EMoqOverflowPolicy::Block drops the new object instead.
+	 */
+	static void OnAggregatedDataReceived(void* UserData, const uint8_t* Data, size_t DataLen);
+
 private:
+	/** Shared body of the two receive callbacks; bMayBlock is false on threads shared with other tracks */
+	static void ReceiveData(void* UserData, const uint8_t* Data, size_t DataLen, bool bMayBlock);
+
+	/** Apply the wait for a group start to one decoded payload (ReceiveLock held) */
+	bool AcceptPayload(const FMoqDecodedObject& Decoded);
+
+	/** Hand one payload to the data sinks and the game thread queue (moq-ffi callback thread) */
+	void DeliverPayload(FMoqDecodedObject&& Decoded, double ArrivalTime, const TArray<TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>>* Sinks, EMoqOverflowPolicy Policy);
+
+	/** Broadcast one object to every per-object listener and add it to the pending batch */
+	void DeliverObject(FMoqReceivedObject&& Object);
+
+	/** Broadcast the batch events for everything delivered by the current drain */
+	void BroadcastBatch();
+
 	/** Handle to the native MoQ subscriber */
 	MoqSubscriber* SubscriberHandle;
+
+	/** Registry handle resolved by the callback thread instead of a raw UObject pointer */
+	void* CallbackHandle;
+
+	/** Objects waiting to be broadcast on the game thread */
+	TMoqBoundedRing<FMoqReceivedObject> ReceiveQueue;
+
+	/** Newest object waiting for the game thread under EMoqReceiveMode::Conflate */
+	TMoqLatestValue<FMoqReceivedObject> LatestObject;
+
+	/** Receive mode read by the network thread on every push */
+	std::atomic<EMoqReceiveMode> ReceiveMode;
+
+	/** Overflow policy read by the network thread on every push */
+	std::atomic<EMoqOverflowPolicy> OverflowPolicy;
+
+	/** Whether the network thread should queue objects for the game thread */
+	std::atomic<bool> bGameThreadDelivery;
+
+	/** Registered native sinks; replaced (never mutated) under DataSinksLock so the callback thread only copies a pointer */
+	TSharedPtr<const TArray<TSharedRef<FMoqDataSinkBinding, ESPMode::ThreadSafe>>, ESPMode::ThreadSafe> DataSinks;
+	mutable FCriticalSection DataSinksLock;
+
+	/** Whether the track carries text, binary or either (game thread only) */
+	EMoqTrackContent TrackContent;
+
+	/** Objects broadcast or pulled so far */
+	std::atomic<int64> NumDelivered;
+
+	/** Whether the dispatcher drains this subscriber */
+	std::atomic<bool> bAutoDispatch;
+
+	/** Move the object held back by the dispatch budget into OutObject; false if there is none */
+	bool TakeCarriedOverObject(FMoqReceivedObject& OutObject);
+
+	/**
+	 * Oldest undelivered object, held back when the dispatch budget ran out. Set on the game thread,
+	 * taken by the next drain or pull, under CarriedOverLock.
+	 */
+	TOptional<FMoqReceivedObject> CarriedOverObject;
+	mutable FCriticalSection CarriedOverLock;
+
+	/** Whether CarriedOverObject is set, so pulls only take the lock when there is something to take */
+	std::atomic<bool> bHasCarriedOverObject{ false };
+
+	/** Drains cut short by the dispatch budget (game thread only) */
+	int64 NumBudgetDeferrals;
+
+	/** Reused storage for OnDataReceived, which needs a TArray (game thread only) */
+	TArray<uint8> DynamicPayloadScratch;
+
+	/** Struct type OnStructReceived decodes objects as */
+	UPROPERTY(Transient)
+	TObjectPtr<const UScriptStruct> ReceiveStruct;
+
+	/** Reused instance of ReceiveStruct that objects are decoded into (game thread only) */
+	TSharedPtr<FStructOnScope> ReceiveStructValue;
+
+	/** Objects that did not decode as ReceiveStruct (game thread only) */
+	int64 NumStructDecodeFailures;
+
+	/** Objects delivered by the current drain, collected while a batch event is bound (game thread only) */
+	TArray<FMoqReceivedObject> PendingBatch;
+
+	/** Sequence number given to the next object queued for the game thread */
+	std::atomic<int64> NextSequence;
+
+	/** Whether the network thread unpacks enveloped objects */
+	std::atomic<bool> bDecodeEnvelopes;
+
+	/**
+	 * Held by the network thread while decoding an object and while publishing it to LatestObject, but
+	 * not across pushes that may block. Objects of this track can also arrive through the client's
+	 * aggregation track, on another callback thread, and the decoder and LatestObject each take one
+	 * producer at a time; the receive queue takes any number.
+	 */
+	FCriticalSection ReceiveLock;
+
+	/** Per-track state for decoding envelopes (ReceiveLock held) */
+	FMoqEnvelopeDecoder EnvelopeDecoder;
+
+	/** Envelopes discarded because they could not be decoded */
+	std::atomic<int64> NumMalformed;
+
+	/** Whether objects are discarded until a group starts; cleared by the first group start (network thread) */
+	std::atomic<bool> bWaitForGroupStart;
+
+	/** Objects discarded while waiting for a group start */
+	std::atomic<int64> NumSkippedBeforeGroupStart;
 };
@@ -0,0 +1,108 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MoqCodec.h"
+#include "MoqPublisher.h"
+#include "MoqSubscriber.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+/**
+ * Publishes messages of one TMoqMessage type on a UMoqPublisher, encoded with TMoqCodec into a
+ * buffer reused from one message to the next. Does not keep the publisher alive. Use from one
+ * thread at a time.
+ */
+template <typename MessageType>
+class TMoqTypedPublisher
+{
+public:
+	TMoqTypedPublisher() = default;
+
+	explicit TMoqTypedPublisher(UMoqPublisher* InPublisher)
+		: Publisher(InPublisher)
+	{
+	}
+
+	/** Encode and publish Message; the encoding is copied only if the publish is queued */
+	FMoqResult Publish(const MessageType& Message, EMoqDeliveryMode DeliveryMode = EMoqDeliveryMode::Stream)
+	{
+		UMoqPublisher* Target = Publisher.Get();
+		if (!Target)
+		{
+			return FMoqResult(false, TEXT("Publisher is not valid"));
+		}
+
+		TMoqCodec<MessageType>::Encode(Message, Scratch);
+		return Target->PublishData(TConstArrayView<uint8>(Scratch), DeliveryMode);
+	}
+
+	UMoqPublisher* GetPublisher() const { return Publisher.Get(); }
+
+private:
+	TWeakObjectPtr<UMoqPublisher> Publisher;
+
+	/** Encoding of the last message */
+	TArray<uint8> Scratch;
+};
+
+/**
+ * Decodes the objects of a UMoqSubscriber as messages of one TMoqMessage type and broadcasts them
+ * on the game thread. Messages are decoded into one value reused from one object to the next, so
+ * OnMessage listeners copy what they keep. Objects that do not decode are counted and dropped.
+ * Does not keep the subscriber alive; stops listening when destroyed.
+ */
+template <typename MessageType>
+class TMoqTypedSubscriber
+{
+public:
+	using FOnMessage = TMulticastDelegate<void(const MessageType&)>;
+
+	explicit TMoqTypedSubscriber(UMoqSubscriber* InSubscriber)
+		: Subscriber(InSubscriber)
+	{
+		if (InSubscriber)
+		{
+			PayloadHandle = InSubscriber->OnPayloadReceived.AddRaw(this, &TMoqTypedSubscriber::HandlePayload);
+		}
+	}
+
+	~TMoqTypedSubscriber()
+	{
+		if (UMoqSubscriber* Target = Subscriber.Get())
+		{
+			Target->OnPayloadReceived.Remove(PayloadHandle);
+		}
+	}
+
+	// Bound to the subscriber by address
+	TMoqTypedSubscriber(const TMoqTypedSubscriber&) = delete;
+	TMoqTypedSubscriber& operator=(const TMoqTypedSubscriber&) = delete;
+
+	/** Event fired with each decoded message; the value is only valid for the duration of the broadcast */
+	FOnMessage OnMessage;
+
+	UMoqSubscriber* GetSubscriber() const { return Subscriber.Get(); }
+
+	/** Objects that were not an encoding of MessageType */
+	int64 GetNumDecodeFailures() const { return NumDecodeFailures; }
+
+private:
+	void HandlePayload(TConstArrayView<uint8> Payload)
+	{
+		if (TMoqCodec<MessageType>::Decode(Payload, Message))
+		{
+			OnMessage.Broadcast(Message);
+		}
+		else if (NumDecodeFailures++ == 0)
+		{
+			// Once; a publisher built with another field list fails every object the same way
+			UE_LOG(LogTemp, Warning, TEXT("Cannot decode object: %d bytes do not match the message's field list"), Payload.Num());
+		}
+	}
+
+	TWeakObjectPtr<UMoqSubscriber> Subscriber;
+	FDelegateHandle PayloadHandle;
+	MessageType Message{};
+	int64 NumDecodeFailures = 0;
+};
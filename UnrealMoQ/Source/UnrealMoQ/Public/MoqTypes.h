@@ -46,3 +46,746 @@ struct UNREALMOQ_API FMoqResult
     {
     }
 };
+
+/** Behaviour of a bounded receive queue when a new object arrives and the queue is full */
+UENUM(BlueprintType)
+enum class EMoqOverflowPolicy : uint8
+{
+    DropOldest = 0 UMETA(DisplayName = "Drop Oldest"),
+    DropNewest = 1 UMETA(DisplayName = "Drop Newest"),
+    Block = 2 UMETA(DisplayName = "Block Network Thread")
+};
+
+/** What kind of payload a subscribed track carries, which decides whether UTF-8 decoding runs */
+UENUM(BlueprintType)
+enum class EMoqTrackContent : uint8
+{
+    Auto = 0 UMETA(DisplayName = "Auto (Decode Text Only When Listened To)"),
+    Binary = 1 UMETA(DisplayName = "Binary (Never Decode Text)"),
+    Text = 2 UMETA(DisplayName = "Text (Skip OnDataReceived Copy)")
+};
+
+/** How received objects are handed to the game thread */
+UENUM(BlueprintType)
+enum class EMoqReceiveMode : uint8
+{
+    Queue = 0 UMETA(DisplayName = "Queue (Deliver Every Object)"),
+    Conflate = 1 UMETA(DisplayName = "Conflate (Latest Object Per Frame)")
+};
+
+/** Options applied to a subscriber before it starts receiving data */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqSubscribeOptions
+{
+    GENERATED_BODY()
+
+    /** Maximum number of received objects buffered between game thread frames (rounded up to a power of two) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "1"))
+    int32 ReceiveQueueCapacity;
+
+    /** What to do when the receive queue is full */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqOverflowPolicy OverflowPolicy;
+
+    /** Deliver every object, or only the newest one per frame for tracks carrying absolute state */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqReceiveMode ReceiveMode;
+
+    /** Payload kind carried by the track; controls when OnTextReceived decoding happens */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqTrackContent Content;
+
+    /** Queue objects for the game thread events; turn off when only native data sinks consume the track */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bDeliverOnGameThread;
+
+    /** Broadcast events from the module's per-frame drain; turn off to pull objects with UMoqSubscriber::TryDequeue or DrainInto instead */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bAutoDispatch;
+
+    /** Unpack objects framed by the publisher (coalesced, compressed or delta-encoded publishes); only enable when the track's publisher frames its objects */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bDecodeEnvelopes;
+
+    /** On a track published in groups, discard objects until the start of the next group, the first point that decodes on its own; needs bDecodeEnvelopes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (EditCondition = "bDecodeEnvelopes"))
+    bool bJoinAtGroupStart;
+
+    /** Time a fragmented datagram object may take to arrive in full before its fragments are discarded */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", EditCondition = "bDecodeEnvelopes"))
+    float ReassemblyTimeoutMs;
+
+    /** Memory cap for partially received fragmented objects; the oldest are discarded to stay under it */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", EditCondition = "bDecodeEnvelopes"))
+    int32 MaxReassemblyBytes;
+
+    FMoqSubscribeOptions()
+        : ReceiveQueueCapacity(256)
+        , OverflowPolicy(EMoqOverflowPolicy::DropOldest)
+        , ReceiveMode(EMoqReceiveMode::Queue)
+        , Content(EMoqTrackContent::Auto)
+        , bDeliverOnGameThread(true)
+        , bAutoDispatch(true)
+        , bDecodeEnvelopes(false)
+        , bJoinAtGroupStart(false)
+        , ReassemblyTimeoutMs(250.0f)
+        , MaxReassemblyBytes(4 * 1024 * 1024)
+    {
+    }
+};
+
+/** One received object with its delivery metadata, as passed to UMoqSubscriber::OnDataBatchReceived */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqReceivedMessage
+{
+    GENERATED_BODY()
+
+    /** Payload bytes */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    TArray<uint8> Data;
+
+    /** FPlatformTime::Seconds() when the object arrived from the network */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    double ArrivalTime;
+
+    /** Per-subscriber arrival index starting at 0; gaps mean objects were dropped or superseded */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 Sequence;
+
+    /** Group the publisher sent the object in (UMoqPublisher::StartGroup), -1 if it does not use groups */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 GroupId;
+
+    /** Position of the object within its group; 0 starts the group, -1 if the publisher does not use groups */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ObjectId;
+
+    FMoqReceivedMessage()
+        : ArrivalTime(0.0)
+        , Sequence(0)
+        , GroupId(INDEX_NONE)
+        , ObjectId(INDEX_NONE)
+    {
+    }
+};
+
+/** Snapshot of a subscriber's receive queue counters */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqReceiveQueueStats
+{
+    GENERATED_BODY()
+
+    /** Number of slots in the receive queue */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 Capacity;
+
+    /** Objects currently waiting for the game thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 QueuedObjects;
+
+    /** Highest number of objects observed waiting at once */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 PeakQueuedObjects;
+
+    /** Objects accepted from the network thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ReceivedObjects;
+
+    /** Objects broadcast on the game thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeliveredObjects;
+
+    /** Objects discarded because the queue was full */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DroppedObjects;
+
+    /** Pushes that had to wait for space under EMoqOverflowPolicy::Block */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 BlockedPushes;
+
+    /** Objects replaced by a newer one before the game thread saw them (EMoqReceiveMode::Conflate) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SupersededObjects;
+
+    /** Drains cut short by the per-frame dispatch budget (moq.Dispatch.BudgetMs) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 BudgetDeferrals;
+
+    /** Age in milliseconds of the oldest object waiting to be dispatched, 0 when there is no backlog */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float BacklogAgeMs;
+
+    /** Envelopes that could not be decoded and were discarded (FMoqSubscribeOptions::bDecodeEnvelopes) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 MalformedObjects;
+
+    /** Compressed objects received, before decompression (bytes) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 CompressedBytes;
+
+    /** The same objects after decompression (bytes) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DecompressedBytes;
+
+    /** Total time spent decompressing on the network thread, in milliseconds */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float DecompressionTimeMs;
+
+    /** Full state objects received from delta-encoded publishers */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 KeyframeObjects;
+
+    /** Delta objects applied to the previous state */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeltaObjects;
+
+    /** Delta objects discarded because the one before was lost, while waiting for the next keyframe */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SkippedDeltaObjects;
+
+    /** Objects discarded before the first group start (FMoqSubscribeOptions::bJoinAtGroupStart) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SkippedBeforeGroupStart;
+
+    /** Datagram fragments received (FMoqPublishOptions::bFragmentDatagrams) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ReceivedFragments;
+
+    /** Objects rebuilt from all of their fragments */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ReassembledObjects;
+
+    /** Fragmented objects discarded incomplete: a fragment was lost, arrived too late or did not fit in memory */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ReassemblyFailures;
+
+    /** Memory currently held by partially received objects (bytes) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ReassemblyBytes;
+
+    /** Lost datagrams rebuilt from parity (FMoqPublishOptions::FecBlockSize) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FecRecoveredObjects;
+
+    /** Datagrams of FEC-protected blocks that were lost and could not be rebuilt */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FecLostObjects;
+
+    /** Objects that did not decode as the struct type set with UMoqSubscriber::SetReceiveStruct */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 StructDecodeFailures;
+
+    FMoqReceiveQueueStats()
+        : Capacity(0)
+        , QueuedObjects(0)
+        , PeakQueuedObjects(0)
+        , ReceivedObjects(0)
+        , DeliveredObjects(0)
+        , DroppedObjects(0)
+        , BlockedPushes(0)
+        , SupersededObjects(0)
+        , BudgetDeferrals(0)
+        , BacklogAgeMs(0.0f)
+        , MalformedObjects(0)
+        , CompressedBytes(0)
+        , DecompressedBytes(0)
+        , DecompressionTimeMs(0.0f)
+        , KeyframeObjects(0)
+        , DeltaObjects(0)
+        , SkippedDeltaObjects(0)
+        , SkippedBeforeGroupStart(0)
+        , ReceivedFragments(0)
+        , ReassembledObjects(0)
+        , ReassemblyFailures(0)
+        , ReassemblyBytes(0)
+        , FecRecoveredObjects(0)
+        , FecLostObjects(0)
+        , StructDecodeFailures(0)
+    {
+    }
+};
+
+/** Backlog left by the module's per-frame receive dispatch (moq.Dispatch.BudgetMs), across all subscribers */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqDispatchStats
+{
+    GENERATED_BODY()
+
+    /** Objects delivered by the last frame's dispatch */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 DispatchedObjects;
+
+    /** Objects still waiting after the last frame's dispatch */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 BacklogObjects;
+
+    /** Age in milliseconds of the oldest waiting object after the last frame's dispatch, 0 when there is no backlog */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float BacklogAgeMs;
+
+    FMoqDispatchStats()
+        : DispatchedObjects(0)
+        , BacklogObjects(0)
+        , BacklogAgeMs(0.0f)
+    {
+    }
+};
+
+/** Where UMoqPublisher performs the moq-ffi publish call */
+UENUM(BlueprintType)
+enum class EMoqPublishMode : uint8
+{
+    Immediate = 0 UMETA(DisplayName = "Immediate (Calling Thread)"),
+    Async = 1 UMETA(DisplayName = "Async (Sender Thread)")
+};
+
+/** Payload compression applied by a publisher; the codec travels with each object, so subscribers need no matching setting */
+UENUM(BlueprintType)
+enum class EMoqCompression : uint8
+{
+    None = 0 UMETA(DisplayName = "None"),
+    Zlib = 1 UMETA(DisplayName = "Zlib"),
+    LZ4 = 2 UMETA(DisplayName = "LZ4"),
+    Oodle = 3 UMETA(DisplayName = "Oodle"),
+    ZlibDictionary = 4 UMETA(DisplayName = "Zlib With Trained Dictionary")
+};
+
+/** What an async publisher does with a new object when its send window is full */
+UENUM(BlueprintType)
+enum class EMoqBackpressurePolicy : uint8
+{
+    FailFast = 0 UMETA(DisplayName = "Fail Fast (Return an Error)"),
+    DropNewest = 1 UMETA(DisplayName = "Drop Newest"),
+    DropOldest = 2 UMETA(DisplayName = "Drop Oldest"),
+    CoalesceLatest = 3 UMETA(DisplayName = "Coalesce (Keep Only the Latest)")
+};
+
+/** Token-bucket limit on how fast objects are handed to moq-ffi; a rate of 0 leaves that dimension unlimited */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqRateLimit
+{
+    GENERATED_BODY()
+
+    /** Sustained payload bytes per second */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    int64 BytesPerSecond;
+
+    /** Sustained objects per second */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    float ObjectsPerSecond;
+
+    /** Bucket size, as milliseconds of the sustained rate that may be sent back to back after an idle period */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "1"))
+    float BurstMs;
+
+    FMoqRateLimit()
+        : BytesPerSecond(0)
+        , ObjectsPerSecond(0.0f)
+        , BurstMs(50.0f)
+    {
+    }
+
+    bool IsLimited() const { return BytesPerSecond > 0 || ObjectsPerSecond > 0.0f; }
+};
+
+/** Options applied to a publisher when it is created */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqPublishOptions
+{
+    GENERATED_BODY()
+
+    /** Publish on the calling thread, or queue for the module's sender thread */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqPublishMode Mode;
+
+    /** Send window in objects waiting for the sender thread; the queue is sized from this when the publisher is created */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "1"))
+    int32 MaxQueuedObjects;
+
+    /** Send window in payload bytes waiting for the sender thread (0 for no byte limit) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    int64 MaxQueuedBytes;
+
+    /** What to do with a publish that does not fit in the send window */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqBackpressurePolicy BackpressurePolicy;
+
+    /** Pack stream publishes made during a frame into one object sent at the end of the frame; subscribers need bDecodeEnvelopes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bCoalesce;
+
+    /** Packed object size at which coalesced publishes are sent before the end of the frame */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "64", EditCondition = "bCoalesce"))
+    int32 CoalesceMaxBytes;
+
+    /** Age of the oldest coalesced publish at which the buffer is sent early, checked on each publish (0 to wait for the end of the frame) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", EditCondition = "bCoalesce"))
+    float CoalesceMaxDelayMs;
+
+    /** Compress each object before it is sent; subscribers need bDecodeEnvelopes (and the dictionary, for ZlibDictionary) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    EMoqCompression Compression;
+
+    /** Objects smaller than this are sent uncompressed */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    int32 CompressionMinBytes;
+
+    /** Preset dictionary for EMoqCompression::ZlibDictionary, usually built with MoqCompression::TrainDictionary */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    TArray<uint8> CompressionDictionary;
+
+    /** Send each object as a delta against the previous one, with periodic keyframes; subscribers need bDecodeEnvelopes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bDeltaEncoding;
+
+    /** Objects between keyframes, counting the keyframe (0 for no object limit) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", EditCondition = "bDeltaEncoding"))
+    int32 KeyframeInterval;
+
+    /** Longest time between keyframes, bounding how long a subscriber that joins or loses an object waits (0 for no time limit) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", EditCondition = "bDeltaEncoding"))
+    float KeyframeIntervalMs;
+
+    /** Pace objects to this rate on the sender thread; a limited publisher queues every publish, whatever its Mode */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    FMoqRateLimit RateLimit;
+
+    /**
+     * Send order among queued publishers of the module, lower first, as in MoQ publisher priority.
+     * moq-ffi has no priority of its own, so this only orders publishes that go through the sender
+     * thread (async or rate limited).
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    uint8 Priority;
+
+    /** Queued objects older than this when their turn comes are discarded instead of sent (0 to always send) */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    float MaxQueueDelayMs;
+
+    /** Split datagram objects larger than MaxDatagramSize into fragments instead of failing; subscribers need bDecodeEnvelopes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    bool bFragmentDatagrams;
+
+    /** Largest datagram sent, envelope header included; the default fits the 1200-byte minimum QUIC packet with room for QUIC and MoQ headers */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "64", EditCondition = "bFragmentDatagrams"))
+    int32 MaxDatagramSize;
+
+    /**
+     * Datagrams per XOR parity datagram, 0 for no forward error correction. Any one datagram lost per
+     * block is rebuilt by the subscriber, for 1 / FecBlockSize extra bandwidth; subscribers need bDecodeEnvelopes.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0", ClampMax = "256"))
+    int32 FecBlockSize;
+
+    FMoqPublishOptions()
+        : Mode(EMoqPublishMode::Immediate)
+        , MaxQueuedObjects(1024)
+        , MaxQueuedBytes(0)
+        , BackpressurePolicy(EMoqBackpressurePolicy::FailFast)
+        , bCoalesce(false)
+        , CoalesceMaxBytes(16 * 1024)
+        , CoalesceMaxDelayMs(0.0f)
+        , Compression(EMoqCompression::None)
+        , CompressionMinBytes(64)
+        , bDeltaEncoding(false)
+        , KeyframeInterval(30)
+        , KeyframeIntervalMs(500.0f)
+        , Priority(128)
+        , MaxQueueDelayMs(0.0f)
+        , bFragmentDatagrams(false)
+        , MaxDatagramSize(1100)
+        , FecBlockSize(0)
+    {
+    }
+};
+
+/** Snapshot of a publisher's send counters */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqPublisherStats
+{
+    GENERATED_BODY()
+
+    /** Objects waiting for the sender thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 QueuedObjects;
+
+    /** Highest number of objects observed waiting at once */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 PeakQueuedObjects;
+
+    /** Payload bytes waiting for the sender thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 QueuedBytes;
+
+    /** True from the moment the send window fills until the queue drains below half of it */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    bool bBackpressured;
+
+    /** Objects handed to moq-ffi successfully */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentObjects;
+
+    /** Bytes handed to moq-ffi successfully, as sent on the wire */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentBytes;
+
+    /** Objects moq-ffi refused */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FailedObjects;
+
+    /** Objects rejected or discarded by the backpressure policy because the send window was full */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DroppedObjects;
+
+    /** Queued objects discarded because they waited longer than FMoqPublishOptions::MaxQueueDelayMs */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 ExpiredObjects;
+
+    /** Publishes that were packed together with others into one coalesced object */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 CoalescedObjects;
+
+    /** Objects sent compressed (objects that did not shrink are sent as-is and not counted) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 CompressedObjects;
+
+    /** Bytes of the compressed objects before compression */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 UncompressedBytes;
+
+    /** Bytes of the compressed objects on the wire */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 CompressedBytes;
+
+    /** Total time spent compressing, in milliseconds */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float CompressionTimeMs;
+
+    /** Objects sent as full state by a delta-encoding publisher */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 KeyframeObjects;
+
+    /** Objects sent as a delta against the previous object */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeltaObjects;
+
+    /** Mean number of objects per keyframe actually achieved, including the keyframe */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float AverageKeyframeInterval;
+
+    /** Bytes after delta encoding divided by bytes before it (1 means no saving) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float DeltaRatio;
+
+    /** Objects that had to wait for the publisher's or the client's rate limit before being sent */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeferredObjects;
+
+    /** Payload bytes of the deferred objects */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeferredBytes;
+
+    /** Datagram objects split into fragments (FMoqPublishOptions::bFragmentDatagrams) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FragmentedObjects;
+
+    /** Fragments handed to moq-ffi, each its own datagram */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentFragments;
+
+    /** Parity datagrams sent for forward error correction (FMoqPublishOptions::FecBlockSize) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FecParityObjects;
+
+    /** Bytes of the parity datagrams, the bandwidth spent on forward error correction */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FecParityBytes;
+
+    /** Mean time from PublishData to the moq-ffi call returning, in milliseconds (async mode) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float AverageSendLatencyMs;
+
+    /** Worst time from PublishData to the moq-ffi call returning, in milliseconds (async mode) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float MaxSendLatencyMs;
+
+    FMoqPublisherStats()
+        : QueuedObjects(0)
+        , PeakQueuedObjects(0)
+        , QueuedBytes(0)
+        , bBackpressured(false)
+        , SentObjects(0)
+        , SentBytes(0)
+        , FailedObjects(0)
+        , DroppedObjects(0)
+        , ExpiredObjects(0)
+        , CoalescedObjects(0)
+        , CompressedObjects(0)
+        , UncompressedBytes(0)
+        , CompressedBytes(0)
+        , CompressionTimeMs(0.0f)
+        , KeyframeObjects(0)
+        , DeltaObjects(0)
+        , AverageKeyframeInterval(0.0f)
+        , DeltaRatio(1.0f)
+        , DeferredObjects(0)
+        , DeferredBytes(0)
+        , FragmentedObjects(0)
+        , SentFragments(0)
+        , FecParityObjects(0)
+        , FecParityBytes(0)
+        , AverageSendLatencyMs(0.0f)
+        , MaxSendLatencyMs(0.0f)
+    {
+    }
+};
+
+/** Objects released under a client's aggregate publish rate limit (UMoqClient::SetPublishRateLimit) */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqPacingStats
+{
+    GENERATED_BODY()
+
+    /** Objects of the client's publishers released to moq-ffi by the sender thread */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentObjects;
+
+    /** Payload bytes of those objects */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentBytes;
+
+    /** Objects that had to wait for a rate limit before being released */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeferredObjects;
+
+    /** Payload bytes of the deferred objects */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DeferredBytes;
+
+    FMoqPacingStats()
+        : SentObjects(0)
+        , SentBytes(0)
+        , DeferredObjects(0)
+        , DeferredBytes(0)
+    {
+    }
+};
+
+/** Packing of small datagram objects into shared datagrams (UMoqClient::EnableDatagramAggregation) */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqAggregationOptions
+{
+    GENERATED_BODY()
+
+    /** Track in the aggregation namespace that carries the shared datagrams; subscribers must use the same name */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    FString TrackName;
+
+    /** Datagram objects up to this many bytes, after compression, are aggregated; larger ones keep their own track */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "1"))
+    int32 MaxObjectSize;
+
+    /** Largest shared datagram, headers included; keep it under the path MTU */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "64"))
+    int32 MaxDatagramSize;
+
+    /** Longest an object waits for others to share its datagram; a full datagram is sent at once */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ", meta = (ClampMin = "0"))
+    float MaxDelayMs;
+
+    FMoqAggregationOptions()
+        : TrackName(TEXT("_aggregate"))
+        , MaxObjectSize(200)
+        , MaxDatagramSize(1100)
+        , MaxDelayMs(0.5f)
+    {
+    }
+};
+
+/** Counters of a client's datagram aggregation, both directions */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqAggregationStats
+{
+    GENERATED_BODY()
+
+    /** Objects of the client's publishers sent inside shared datagrams */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 AggregatedObjects;
+
+    /** Shared datagrams sent */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentDatagrams;
+
+    /** Bytes of the shared datagrams sent */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 SentBytes;
+
+    /** Shared datagrams moq-ffi refused, with every object in them */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 FailedDatagrams;
+
+    /** Longest an object waited in a shared datagram before it was sent */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    float MaxAddedDelayMs;
+
+    /** Objects received in shared datagrams and handed to the subscriber of their track */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 DemuxedObjects;
+
+    /** Objects received for tracks this client is not subscribed to */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 UnroutedObjects;
+
+    /** Shared datagrams that could not be parsed to the end */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int64 MalformedDatagrams;
+
+    FMoqAggregationStats()
+        : AggregatedObjects(0)
+        , SentDatagrams(0)
+        , SentBytes(0)
+        , FailedDatagrams(0)
+        , MaxAddedDelayMs(0.0f)
+        , DemuxedObjects(0)
+        , UnroutedObjects(0)
+        , MalformedDatagrams(0)
+    {
+    }
+};
+
+/** One object in a Blueprint batch publish */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqPublishPayload
+{
+    GENERATED_BODY()
+
+    /** Payload bytes */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MoQ")
+    TArray<uint8> Data;
+};
+
+/** Outcome of UMoqPublisher::PublishBatch */
+USTRUCT(BlueprintType)
+struct UNREALMOQ_API FMoqBatchPublishResult
+{
+    GENERATED_BODY()
+
+    /** Objects published (or queued, in async mode) */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    int32 NumSucceeded;
+
+    /** Indices into the batch of the objects that failed, in order */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    TArray<int32> FailedIndices;
+
+    /** Error for the first failed object; later errors are counted but not kept */
+    UPROPERTY(BlueprintReadOnly, Category = "MoQ")
+    FString FirstErrorMessage;
+
+    FMoqBatchPublishResult()
+        : NumSucceeded(0)
+    {
+    }
+
+    bool AllSucceeded() const { return FailedIndices.Num() == 0; }
+};
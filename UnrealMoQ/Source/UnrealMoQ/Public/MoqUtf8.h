@@ -0,0 +1,32 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * UTF-8 validation and UTF-8 -> TCHAR transcoding shared by UMoqBlueprintLibrary and UMoqSubscriber.
+ *
+ * Validation uses the lookup-table algorithm (Keiser & Lemire) with AVX2, SSE4.1 or NEON depending on
+ * what the target is compiled for, and a scalar reference implementation everywhere else. Decoding
+ * validates while it transcodes, widening pure ASCII blocks with SIMD, so text is only walked once.
+ */
+namespace MoqUtf8
+{
+	/** True if Data is well-formed UTF-8 (no overlongs, surrogates or code points above U+10FFFF) */
+	UNREALMOQ_API bool IsValid(TConstArrayView<uint8> Data);
+
+	/** Byte-at-a-time reference validator, kept for testing and benchmarking the vector kernels */
+	UNREALMOQ_API bool IsValidScalar(TConstArrayView<uint8> Data);
+
+	/**
+	 * Validate and transcode Data in a single pass.
+	 * @param Data UTF-8 bytes
+	 * @param OutText Receives the decoded text; emptied on failure
+	 * @return False if Data is not well-formed UTF-8
+	 */
+	UNREALMOQ_API bool DecodeToString(TConstArrayView<uint8> Data, FString& OutText);
+
+	/** Name of the validation kernel compiled into this build ("AVX2", "SSE4.1", "NEON" or "Scalar") */
+	UNREALMOQ_API const TCHAR* GetKernelName();
+}
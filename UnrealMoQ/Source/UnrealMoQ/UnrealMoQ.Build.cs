@@ -26,6 +26,9 @@ public class UnrealMoQ : ModuleRules
 			}
 		);
 
+		// Raw deflate with preset dictionaries for EMoqCompression::ZlibDictionary
+		AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+
 		// Add moq-ffi third party library
 		string PluginPath = Path.GetFullPath(Path.Combine(ModuleDirectory, "../../"));
 		string ThirdPartyPath = Path.Combine(PluginPath, "ThirdParty");
@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqAggregation.h"
+#include "MoqEnvelope.h"
+#include "MoqSubscriber.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+TArray<uint8> MakeObject(int32 Size, uint8 Value)
+{
+	TArray<uint8> Object;
+	Object.Init(Value, Size);
+	return Object;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqAggregationDemuxTest, "UnrealMoQ.Aggregation.Demux", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqAggregationDemuxTest::RunTest(const FString& Parameters)
+{
+	// Test that objects of several tracks packed into one datagram each reach the subscriber of their own track, in order
+	const uint32 PoseRoute = MoqAggregation::GetRouteId(TEXT("game"), TEXT("pose"));
+	const uint32 InputRoute = MoqAggregation::GetRouteId(TEXT("game"), TEXT("input"));
+	TestNotEqual(TEXT("Tracks should have distinct route ids"), PoseRoute, InputRoute);
+	TestNotEqual(TEXT("Namespace and track name should not run together"), MoqAggregation::GetRouteId(TEXT("a/b"), TEXT("c")), MoqAggregation::GetRouteId(TEXT("a"), TEXT("b/c")));
+	
+	UMoqSubscriber* PoseSubscriber = NewObject<UMoqSubscriber>();
+	UMoqSubscriber* InputSubscriber = NewObject<UMoqSubscriber>();
+	TArray<TArray<uint8>> Poses;
+	TArray<TArray<uint8>> Inputs;
+	PoseSubscriber->OnPayloadReceived.AddLambda([&Poses](TConstArrayView<uint8> Payload)
+	{
+		Poses.Emplace(Payload);
+	});
+	InputSubscriber->OnPayloadReceived.AddLambda([&Inputs](TConstArrayView<uint8> Payload)
+	{
+		Inputs.Emplace(Payload);
+	});
+	
+	FMoqDatagramDemux Demux;
+	Demux.AddRoute(PoseRoute, PoseSubscriber->GetCallbackUserData());
+	Demux.AddRoute(InputRoute, InputSubscriber->GetCallbackUserData());
+	
+	TArray<uint8> Datagram;
+	MoqEnvelope::WriteHeader(Datagram, MoqEnvelope::EKind::Aggregate);
+	MoqAggregation::AppendObject(Datagram, PoseRoute, MakeObject(48, 1));
+	MoqAggregation::AppendObject(Datagram, InputRoute, MakeObject(20, 2));
+	MoqAggregation::AppendObject(Datagram, PoseRoute + InputRoute, MakeObject(30, 3));
+	MoqAggregation::AppendObject(Datagram, PoseRoute, MakeObject(200, 4));
+	TestEqual(TEXT("Packed size should match the per-object overhead"), Datagram.Num(),
+		MoqEnvelope::HeaderSize + 48 + 20 + 30 + 200 + 3 * MoqAggregation::GetObjectOverhead(48) + MoqAggregation::GetObjectOverhead(200));
+	
+	TestTrue(TEXT("Aggregate datagram should dispatch"), Demux.Dispatch(Datagram));
+	PoseSubscriber->DispatchPendingEvents();
+	InputSubscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("Pose track should receive its two objects"), Poses.Num(), 2);
+	TestEqual(TEXT("Input track should receive its object"), Inputs.Num(), 1);
+	if (Poses.Num() == 2 && Inputs.Num() == 1)
+	{
+		TestTrue(TEXT("Objects should arrive intact and in order"), Poses[0] == MakeObject(48, 1) && Poses[1] == MakeObject(200, 4) && Inputs[0] == MakeObject(20, 2));
+	}
+	TestEqual(TEXT("Routed objects should be counted"), Demux.GetNumDemuxed(), (int64)3);
+	TestEqual(TEXT("Object without a subscriber should be counted"), Demux.GetNumUnrouted(), (int64)1);
+	
+	Datagram.Pop();
+	TestFalse(TEXT("Truncated datagram should be rejected"), Demux.Dispatch(Datagram));
+	TestFalse(TEXT("Other envelopes should be rejected"), Demux.Dispatch(MakeObject(10, MoqEnvelope::MagicByte)));
+	TestEqual(TEXT("Rejected datagrams should be counted"), Demux.GetNumMalformed(), (int64)2);
+	
+	return true;
+}
@@ -278,3 +278,33 @@ bool FMoqClientFMoqResultDefaultTest::RunTest(const FString& Parameters)
 	
 	return true;
 }
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqClientPublishRateLimitTest, "UnrealMoQ.Client.PublishRateLimit", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqClientPublishRateLimitTest::RunTest(const FString& Parameters)
+{
+	// Test that the aggregate rate limit defaults to unlimited and round-trips through the client
+	UMoqClient* Client = NewObject<UMoqClient>();
+	
+	TestFalse(TEXT("Default limit should be unlimited"), Client->GetPublishRateLimit().IsLimited());
+	
+	FMoqRateLimit Limit;
+	Limit.BytesPerSecond = 1024 * 1024;
+	Limit.ObjectsPerSecond = 500.0f;
+	Limit.BurstMs = 20.0f;
+	Client->SetPublishRateLimit(Limit);
+	
+	const FMoqRateLimit Applied = Client->GetPublishRateLimit();
+	TestTrue(TEXT("Limit should be active"), Applied.IsLimited());
+	TestEqual(TEXT("Byte rate should be kept"), Applied.BytesPerSecond, Limit.BytesPerSecond);
+	TestEqual(TEXT("Object rate should be kept"), Applied.ObjectsPerSecond, Limit.ObjectsPerSecond);
+	
+	const FMoqPacingStats Stats = Client->GetPacingStats();
+	TestEqual(TEXT("Nothing should have been sent"), Stats.SentObjects, (int64)0);
+	TestEqual(TEXT("Nothing should have been deferred"), Stats.DeferredObjects, (int64)0);
+	
+	Client->SetPublishRateLimit(FMoqRateLimit());
+	TestFalse(TEXT("Resetting the limit should lift it"), Client->GetPublishRateLimit().IsLimited());
+	
+	return true;
+}
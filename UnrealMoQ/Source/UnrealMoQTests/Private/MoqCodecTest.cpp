@@ -0,0 +1,268 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqCodec.h"
+#include "MoqTypedTrack.h"
+#include "Dom/JsonObject.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+struct FTestPose
+{
+	FVector3f Position = FVector3f::ZeroVector;
+	float Yaw = 0.0f;
+	uint16 Flags = 0;
+	FString Name;
+	TArray<int32> Inputs;
+};
+
+struct FTestInput
+{
+	int32 Tick = 0;
+	uint8 Buttons = 0;
+};
+
+struct FTestSwitches
+{
+	bool bEnabled = false;
+	int16 Channel = 0;
+	TArray<bool> Held;
+};
+
+FTestPose MakePose(int32 Index)
+{
+	FTestPose Pose;
+	Pose.Position = FVector3f(Index * 0.5f, -2.0f, 100.25f);
+	Pose.Yaw = 90.0f + Index;
+	Pose.Flags = static_cast<uint16>(Index);
+	Pose.Name = TEXT("Player Zoë");
+	Pose.Inputs = { Index, Index + 1, Index + 2 };
+	return Pose;
+}
+}
+
+template <>
+struct TMoqMessage<FTestPose>
+{
+	using Fields = TMoqFields<&FTestPose::Position, &FTestPose::Name, &FTestPose::Yaw, &FTestPose::Inputs, &FTestPose::Flags>;
+};
+
+template <>
+struct TMoqMessage<FTestInput>
+{
+	using Fields = TMoqFields<&FTestInput::Tick, &FTestInput::Buttons>;
+};
+
+template <>
+struct TMoqMessage<FTestSwitches>
+{
+	using Fields = TMoqFields<&FTestSwitches::bEnabled, &FTestSwitches::Channel, &FTestSwitches::Held>;
+};
+
+static_assert(TMoqCodec<FTestPose>::FixedSize == sizeof(FVector3f) + sizeof(float) + sizeof(uint16), "Fixed-size fields should be packed without padding");
+static_assert(!TMoqCodec<FTestPose>::bFixedSize, "Strings and arrays make the encoding variable-size");
+static_assert(TMoqCodec<FTestInput>::FixedSize == 5 && TMoqCodec<FTestInput>::bFixedSize, "Numbers only should encode to a fixed size");
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCodecRoundTripTest, "UnrealMoQ.Codec.RoundTrip", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqCodecRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Test that messages decode to the values they were encoded from and malformed encodings are rejected
+	const FTestPose Pose = MakePose(7);
+	TArray<uint8> Encoded;
+	TMoqCodec<FTestPose>::Encode(Pose, Encoded);
+	TestEqual(TEXT("Encoding should be the fixed block, then each variable field with its length"), Encoded.Num(),
+		TMoqCodec<FTestPose>::FixedSize + 1 + 11 + 1 + 3 * (int32)sizeof(int32));
+	
+	FTestPose Decoded;
+	TestTrue(TEXT("Encoding should decode"), TMoqCodec<FTestPose>::Decode(Encoded, Decoded));
+	TestEqual(TEXT("Vector should round-trip"), Decoded.Position, Pose.Position);
+	TestEqual(TEXT("Float should round-trip"), Decoded.Yaw, Pose.Yaw);
+	TestEqual(TEXT("Integer should round-trip"), Decoded.Flags, Pose.Flags);
+	TestEqual(TEXT("Non-ASCII string should round-trip"), Decoded.Name, Pose.Name);
+	TestTrue(TEXT("Array should round-trip"), Decoded.Inputs == Pose.Inputs);
+	
+	// A second message of the same shape fits the buffers the first one grew
+	const uint8* EncodedData = Encoded.GetData();
+	const int32* InputsData = Decoded.Inputs.GetData();
+	TMoqCodec<FTestPose>::Encode(MakePose(8), Encoded);
+	TestTrue(TEXT("Next message should decode"), TMoqCodec<FTestPose>::Decode(Encoded, Decoded));
+	TestEqual(TEXT("Next message should overwrite the previous one"), Decoded.Flags, (uint16)8);
+	TestTrue(TEXT("Encoding should reuse the output allocation"), Encoded.GetData() == EncodedData);
+	TestTrue(TEXT("Decoding should reuse the array allocation"), Decoded.Inputs.GetData() == InputsData);
+	
+	TArray<uint8> Truncated = Encoded;
+	Truncated.Pop();
+	TestFalse(TEXT("Truncated encoding should be rejected"), TMoqCodec<FTestPose>::Decode(Truncated, Decoded));
+	TestFalse(TEXT("Fixed block alone should be rejected"), TMoqCodec<FTestPose>::Decode(MakeArrayView(Encoded.GetData(), TMoqCodec<FTestPose>::FixedSize), Decoded));
+	
+	TArray<uint8> Trailing = Encoded;
+	Trailing.Add(0);
+	TestFalse(TEXT("Trailing bytes should be rejected"), TMoqCodec<FTestPose>::Decode(Trailing, Decoded));
+	
+	TArray<uint8> BadText = Encoded;
+	BadText[TMoqCodec<FTestPose>::FixedSize + 1] = 0xC0;
+	TestFalse(TEXT("Invalid UTF-8 should be rejected"), TMoqCodec<FTestPose>::Decode(BadText, Decoded));
+	
+	FTestInput Input;
+	Input.Tick = -123456;
+	Input.Buttons = 0x5A;
+	TMoqCodec<FTestInput>::Encode(Input, Encoded);
+	TestEqual(TEXT("Fixed-size message should encode to its fixed size"), Encoded.Num(), TMoqCodec<FTestInput>::FixedSize);
+	
+	FTestInput DecodedInput;
+	TestTrue(TEXT("Fixed-size message should decode"), TMoqCodec<FTestInput>::Decode(Encoded, DecodedInput));
+	TestTrue(TEXT("Fixed-size message should round-trip"), DecodedInput.Tick == Input.Tick && DecodedInput.Buttons == Input.Buttons);
+	Encoded.Add(0);
+	TestFalse(TEXT("Fixed-size message of the wrong size should be rejected"), TMoqCodec<FTestInput>::Decode(Encoded, DecodedInput));
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCodecBoolTest, "UnrealMoQ.Codec.Bool", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqCodecBoolTest::RunTest(const FString& Parameters)
+{
+	// Test that bool bytes other than 0 or 1 from the wire decode to a valid true instead of being copied into the bool
+	FTestSwitches Switches;
+	Switches.bEnabled = true;
+	Switches.Channel = -3;
+	Switches.Held = { true, false, true };
+	TArray<uint8> Encoded;
+	TMoqCodec<FTestSwitches>::Encode(Switches, Encoded);
+	TestEqual(TEXT("Bool should encode as one byte"), Encoded.Num() > 0 ? Encoded[0] : (uint8)0, (uint8)1);
+	
+	// The fixed block is the bool and the int16, then the array's count and one byte per element
+	Encoded[0] = 0xFF;
+	Encoded[4] = 2;
+	Encoded[5] = 0x80;
+	FTestSwitches Decoded;
+	TestTrue(TEXT("Encoding with odd bool bytes should decode"), TMoqCodec<FTestSwitches>::Decode(Encoded, Decoded));
+	TestEqual(TEXT("Bool field should hold exactly 1 in memory"), *reinterpret_cast<const uint8*>(&Decoded.bEnabled), (uint8)1);
+	TestEqual(TEXT("Field after the bool should still decode"), Decoded.Channel, Switches.Channel);
+	TestEqual(TEXT("Bool array should keep its length"), Decoded.Held.Num(), 3);
+	for (const bool& bHeld : Decoded.Held)
+	{
+		TestEqual(TEXT("Bool array element should hold 0 or 1 in memory"), *reinterpret_cast<const uint8*>(&bHeld) <= 1, true);
+	}
+	TestTrue(TEXT("Bool array should decode nonzero bytes as true"), Decoded.Held == TArray<bool>({ true, true, true }));
+	
+	Encoded[0] = 0;
+	TestTrue(TEXT("Encoding with a false bool should decode"), TMoqCodec<FTestSwitches>::Decode(Encoded, Decoded));
+	TestFalse(TEXT("Zero byte should decode to false"), Decoded.bEnabled);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCodecTypedTrackTest, "UnrealMoQ.Codec.TypedTrack", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqCodecTypedTrackTest::RunTest(const FString& Parameters)
+{
+	// Test that a typed subscriber decodes the objects of its subscriber and counts the ones it cannot
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	TArray<uint16> Received;
+	{
+		TMoqTypedSubscriber<FTestPose> Typed(Subscriber);
+		Typed.OnMessage.AddLambda([&Received](const FTestPose& Pose)
+		{
+			Received.Add(Pose.Flags);
+		});
+		
+		TArray<uint8> Encoded;
+		for (int32 Index = 0; Index < 3; ++Index)
+		{
+			TMoqCodec<FTestPose>::Encode(MakePose(Index), Encoded);
+			UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Encoded.GetData(), Encoded.Num());
+		}
+		
+		AddExpectedMessage(TEXT("Cannot decode object"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1);
+		const uint8 Garbage[] = { 1, 2, 3 };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Garbage, sizeof(Garbage));
+		Subscriber->DispatchPendingEvents();
+		
+		TestTrue(TEXT("Every message should be decoded in order"), Received == TArray<uint16>({ 0, 1, 2 }));
+		TestEqual(TEXT("Object of another type should be counted"), Typed.GetNumDecodeFailures(), (int64)1);
+	}
+	
+	TArray<uint8> Encoded;
+	TMoqCodec<FTestPose>::Encode(MakePose(3), Encoded);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Encoded.GetData(), Encoded.Num());
+	Subscriber->DispatchPendingEvents();
+	TestEqual(TEXT("Destroyed typed subscriber should stop listening"), Received.Num(), 3);
+	
+	TMoqTypedPublisher<FTestInput> Publisher;
+	TestFalse(TEXT("Publishing without a publisher should fail"), Publisher.Publish(FTestInput()).bSuccess);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCodecBenchmarkTest, "UnrealMoQ.Codec.Benchmark", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FMoqCodecBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// Compare encoding and decoding a message with the codec against JSON text
+	constexpr int32 Iterations = 100000;
+	const FTestPose Pose = MakePose(42);
+	
+	TArray<uint8> Encoded;
+	FTestPose Decoded;
+	const double CodecStart = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		TMoqCodec<FTestPose>::Encode(Pose, Encoded);
+		TMoqCodec<FTestPose>::Decode(Encoded, Decoded);
+	}
+	const double CodecSeconds = FPlatformTime::Seconds() - CodecStart;
+	
+	FString Json;
+	const double JsonStart = FPlatformTime::Seconds();
+	for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+	{
+		TSharedRef<FJsonObject> Object = MakeShared<FJsonObject>();
+		Object->SetNumberField(TEXT("x"), Pose.Position.X);
+		Object->SetNumberField(TEXT("y"), Pose.Position.Y);
+		Object->SetNumberField(TEXT("z"), Pose.Position.Z);
+		Object->SetNumberField(TEXT("yaw"), Pose.Yaw);
+		Object->SetNumberField(TEXT("flags"), Pose.Flags);
+		Object->SetStringField(TEXT("name"), Pose.Name);
+		TArray<TSharedPtr<FJsonValue>> Inputs;
+		for (int32 Input : Pose.Inputs)
+		{
+			Inputs.Add(MakeShared<FJsonValueNumber>(Input));
+		}
+		Object->SetArrayField(TEXT("inputs"), Inputs);
+		
+		Json.Reset();
+		FJsonSerializer::Serialize(Object, TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json));
+		
+		TSharedPtr<FJsonObject> Parsed;
+		FJsonSerializer::Deserialize(TJsonReaderFactory<TCHAR>::Create(Json), Parsed);
+		if (Parsed.IsValid())
+		{
+			Decoded.Position.X = static_cast<float>(Parsed->GetNumberField(TEXT("x")));
+			Decoded.Position.Y = static_cast<float>(Parsed->GetNumberField(TEXT("y")));
+			Decoded.Position.Z = static_cast<float>(Parsed->GetNumberField(TEXT("z")));
+			Decoded.Yaw = static_cast<float>(Parsed->GetNumberField(TEXT("yaw")));
+			Decoded.Flags = static_cast<uint16>(Parsed->GetIntegerField(TEXT("flags")));
+			Decoded.Name = Parsed->GetStringField(TEXT("name"));
+			Decoded.Inputs.Reset();
+			for (const TSharedPtr<FJsonValue>& Input : Parsed->GetArrayField(TEXT("inputs")))
+			{
+				Decoded.Inputs.Add(static_cast<int32>(Input->AsNumber()));
+			}
+		}
+	}
+	const double JsonSeconds = FPlatformTime::Seconds() - JsonStart;
+	
+	AddInfo(FString::Printf(TEXT("Encode + decode: codec %.1f ns (%d bytes), JSON %.1f ns (%d chars), %.1fx"),
+		CodecSeconds * 1.0e9 / Iterations, Encoded.Num(),
+		JsonSeconds * 1.0e9 / Iterations, Json.Len(),
+		JsonSeconds / FMath::Max(CodecSeconds, UE_DOUBLE_SMALL_NUMBER)));
+	
+	TestEqual(TEXT("Both paths should decode the same name"), Decoded.Name, Pose.Name);
+	
+	return true;
+}
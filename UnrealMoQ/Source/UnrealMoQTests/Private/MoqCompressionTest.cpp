@@ -0,0 +1,95 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqCompression.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+TArray<uint8> MakeStateJson(int32 Index)
+{
+	const FString Json = FString::Printf(TEXT("{\"actor\":\"BP_Character_C_%d\",\"location\":{\"x\":%d.5,\"y\":%d.25,\"z\":90.0},\"health\":100,\"state\":\"Idle\"}"), Index % 7, Index * 3, Index * 5);
+	FTCHARToUTF8 Utf8(*Json);
+	return TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCompressionRoundTripTest, "UnrealMoQ.Compression.RoundTrip", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqCompressionRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Test that every codec restores the original bytes and incompressible data is refused
+	TArray<uint8> Data;
+	for (int32 Index = 0; Index < 16; ++Index)
+	{
+		Data.Append(MakeStateJson(Index));
+	}
+	
+	const EMoqCompression Codecs[] = { EMoqCompression::Zlib, EMoqCompression::LZ4, EMoqCompression::Oodle, EMoqCompression::ZlibDictionary };
+	for (const EMoqCompression Codec : Codecs)
+	{
+		TArray<uint8> Compressed;
+		if (!TestTrue(FString::Printf(TEXT("Codec %d should compress repetitive data"), static_cast<int32>(Codec)), MoqCompression::Compress(Codec, Data, TConstArrayView<uint8>(), Compressed)))
+		{
+			continue;
+		}
+		TestTrue(TEXT("Output should be smaller than the input"), Compressed.Num() < Data.Num());
+		
+		TArray<uint8> Restored;
+		Restored.SetNumUninitialized(Data.Num());
+		TestTrue(TEXT("Output should decompress"), MoqCompression::Decompress(Codec, Compressed, TConstArrayView<uint8>(), Restored.GetData(), Restored.Num()));
+		TestEqual(TEXT("Decompressed bytes should match"), Restored, Data);
+		
+		TestFalse(TEXT("A wrong size should be rejected"), MoqCompression::Decompress(Codec, Compressed, TConstArrayView<uint8>(), Restored.GetData(), Restored.Num() - 1));
+	}
+	
+	TArray<uint8> Noise;
+	FRandomStream Random(42);
+	for (int32 Index = 0; Index < 256; ++Index)
+	{
+		Noise.Add(static_cast<uint8>(Random.RandRange(0, 255)));
+	}
+	TArray<uint8> Compressed;
+	TestFalse(TEXT("Incompressible data should be refused"), MoqCompression::Compress(EMoqCompression::Zlib, Noise, TConstArrayView<uint8>(), Compressed));
+	TestEqual(TEXT("A refused compression should leave the output untouched"), Compressed.Num(), 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqCompressionDictionaryTest, "UnrealMoQ.Compression.Dictionary", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqCompressionDictionaryTest::RunTest(const FString& Parameters)
+{
+	// Test that a trained dictionary shrinks small objects that plain deflate cannot
+	TArray<TArray<uint8>> Samples;
+	TArray<TConstArrayView<uint8>> SampleViews;
+	for (int32 Index = 0; Index < 200; ++Index)
+	{
+		Samples.Add(MakeStateJson(Index));
+	}
+	for (const TArray<uint8>& Sample : Samples)
+	{
+		SampleViews.Add(Sample);
+	}
+	
+	const TArray<uint8> Dictionary = MoqCompression::TrainDictionary(SampleViews, 4096);
+	TestTrue(TEXT("Training should produce a dictionary"), Dictionary.Num() > 0);
+	TestTrue(TEXT("Dictionary should respect the size cap"), Dictionary.Num() <= 4096);
+	TestNotEqual(TEXT("Dictionary id should never be 0"), MoqCompression::GetDictionaryId(Dictionary), 0u);
+	
+	const TArray<uint8> Object = MakeStateJson(1000);
+	TArray<uint8> WithDictionary;
+	TArray<uint8> WithoutDictionary;
+	TestTrue(TEXT("Small object should compress with the dictionary"), MoqCompression::Compress(EMoqCompression::ZlibDictionary, Object, Dictionary, WithDictionary));
+	MoqCompression::Compress(EMoqCompression::ZlibDictionary, Object, TConstArrayView<uint8>(), WithoutDictionary);
+	TestTrue(TEXT("Dictionary should beat plain deflate on a small object"), WithoutDictionary.Num() == 0 || WithDictionary.Num() < WithoutDictionary.Num());
+	
+	TArray<uint8> Restored;
+	Restored.SetNumUninitialized(Object.Num());
+	TestTrue(TEXT("Object should decompress with the same dictionary"), MoqCompression::Decompress(EMoqCompression::ZlibDictionary, WithDictionary, Dictionary, Restored.GetData(), Restored.Num()));
+	TestEqual(TEXT("Decompressed object should match"), Restored, Object);
+	TestFalse(TEXT("Object should not decompress without the dictionary"), MoqCompression::Decompress(EMoqCompression::ZlibDictionary, WithDictionary, TConstArrayView<uint8>(), Restored.GetData(), Restored.Num()));
+	
+	return true;
+}
@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqDelta.h"
+#include "MoqEnvelope.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqDeltaRoundTripTest, "UnrealMoQ.Delta.RoundTrip", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqDeltaRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Test that deltas rebuild the target when it changes in place, grows and shrinks
+	TArray<uint8> Base;
+	for (int32 Index = 0; Index < 256; ++Index)
+	{
+		Base.Add(static_cast<uint8>(Index));
+	}
+	
+	TArray<uint8> Changed = Base;
+	Changed[3] = 0xAA;
+	Changed[4] = 0xBB;
+	Changed[200] = 0xCC;
+	
+	TArray<uint8> Grown = Base;
+	Grown.Append({ 1, 2, 3 });
+	
+	TArray<uint8> Shrunk = Base;
+	Shrunk.SetNum(100);
+	Shrunk[10] = 0xDD;
+	
+	const TArray<uint8> Targets[] = { Base, Changed, Grown, Shrunk };
+	for (const TArray<uint8>& Target : Targets)
+	{
+		TArray<uint8> Delta;
+		if (!TestTrue(TEXT("A small change should produce a smaller delta"), MoqDelta::Encode(Base, Target, Delta)))
+		{
+			continue;
+		}
+		TestTrue(TEXT("Delta should be smaller than the target"), Delta.Num() < Target.Num());
+		
+		TArray<uint8> Rebuilt;
+		Rebuilt.SetNumUninitialized(Target.Num());
+		TestTrue(TEXT("Delta should apply"), MoqDelta::Apply(Base, Delta, Rebuilt.GetData(), Rebuilt.Num()));
+		TestEqual(TEXT("Rebuilt object should match the target"), Rebuilt, Target);
+	}
+	
+	TArray<uint8> Delta;
+	TestTrue(TEXT("An unchanged object should encode"), MoqDelta::Encode(Base, Base, Delta));
+	TestEqual(TEXT("An unchanged object should need no runs"), Delta.Num(), 0);
+	
+	TArray<uint8> Unrelated;
+	for (int32 Index = 0; Index < 256; ++Index)
+	{
+		Unrelated.Add(static_cast<uint8>(255 - Index));
+	}
+	TestFalse(TEXT("A completely different object should not be delta encoded"), MoqDelta::Encode(Base, Unrelated, Delta));
+	
+	const uint8 Overrun[] = { 250, 10, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	TArray<uint8> Rebuilt;
+	Rebuilt.SetNumUninitialized(Base.Num());
+	TestFalse(TEXT("A run past the end of the object should be rejected"), MoqDelta::Apply(Base, MakeArrayView(Overrun, sizeof(Overrun)), Rebuilt.GetData(), Rebuilt.Num()));
+	
+	// Run lengths whose sum wraps around 64 bits must not move the write position before the object
+	TArray<uint8> Wrapping;
+	MoqEnvelope::WriteVarint(Wrapping, MAX_uint64 - 3);
+	MoqEnvelope::WriteVarint(Wrapping, 4);
+	Wrapping.Append({ 1, 2, 3, 4 });
+	TestFalse(TEXT("A skip that wraps the run length should be rejected"), MoqDelta::Apply(Base, Wrapping, Rebuilt.GetData(), Rebuilt.Num()));
+	
+	TArray<uint8> LongSkip;
+	MoqEnvelope::WriteVarint(LongSkip, static_cast<uint64>(Base.Num()) + 1);
+	MoqEnvelope::WriteVarint(LongSkip, 1);
+	LongSkip.Add(1);
+	TestFalse(TEXT("A skip past the end of the object should be rejected"), MoqDelta::Apply(Base, LongSkip, Rebuilt.GetData(), Rebuilt.Num()));
+	
+	return true;
+}
@@ -0,0 +1,90 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqEnvelope.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+FSharedBuffer MakeCoalesced(const TArray<TArray<uint8>>& Payloads)
+{
+	TArray<uint8> Bytes;
+	MoqEnvelope::WriteHeader(Bytes, MoqEnvelope::EKind::Coalesced);
+	for (const TArray<uint8>& Payload : Payloads)
+	{
+		MoqEnvelope::WriteVarint(Bytes, Payload.Num());
+		Bytes.Append(Payload);
+	}
+	return FSharedBuffer::Clone(Bytes.GetData(), Bytes.Num());
+}
+
+TArray<uint8> ToArray(const FSharedBuffer& Buffer)
+{
+	return TArray<uint8>(static_cast<const uint8*>(Buffer.GetData()), static_cast<int32>(Buffer.GetSize()));
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqEnvelopeVarintTest, "UnrealMoQ.Envelope.Varint", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqEnvelopeVarintTest::RunTest(const FString& Parameters)
+{
+	// Test that varints round-trip at every size boundary and reject truncated input
+	const uint64 Values[] = { 0, 1, 127, 128, 16383, 16384, 0xFFFFFFFFull, MAX_uint64 };
+	for (const uint64 Value : Values)
+	{
+		TArray<uint8> Bytes;
+		MoqEnvelope::WriteVarint(Bytes, Value);
+		TestEqual(FString::Printf(TEXT("Size of %llu should match GetVarintSize"), Value), Bytes.Num(), MoqEnvelope::GetVarintSize(Value));
+		
+		int32 Offset = 0;
+		uint64 Decoded = 0;
+		TestTrue(FString::Printf(TEXT("%llu should decode"), Value), MoqEnvelope::ReadVarint(Bytes, Offset, Decoded));
+		TestEqual(FString::Printf(TEXT("%llu should round-trip"), Value), Decoded, Value);
+		TestEqual(TEXT("Offset should move past the varint"), Offset, Bytes.Num());
+		
+		if (Bytes.Num() > 1)
+		{
+			Offset = 0;
+			TestFalse(TEXT("Truncated varint should be rejected"), MoqEnvelope::ReadVarint(MakeArrayView(Bytes.GetData(), Bytes.Num() - 1), Offset, Decoded));
+		}
+	}
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqEnvelopeUnpackTest, "UnrealMoQ.Envelope.Unpack", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqEnvelopeUnpackTest::RunTest(const FString& Parameters)
+{
+	// Test that coalesced and raw envelopes unpack to the original payloads and bad ones deliver nothing
+	TArray<TArray<uint8>> Published;
+	Published.Add({ 0x01 });
+	Published.Add({ MoqEnvelope::MagicByte, 0x00, 0x02 });
+	Published.AddDefaulted_GetRef().Init(0x7A, 300);
+	
+	FSharedBuffer Envelope = MakeCoalesced(Published);
+	TestTrue(TEXT("Coalesced object should be recognised"), MoqEnvelope::IsEnvelope(MakeArrayView(static_cast<const uint8*>(Envelope.GetData()), static_cast<int32>(Envelope.GetSize()))));
+	
+	TArray<FSharedBuffer> Payloads;
+	TestTrue(TEXT("Coalesced envelope should unpack"), MoqEnvelope::Unpack(Envelope, Payloads));
+	TestEqual(TEXT("Every payload should be recovered"), Payloads.Num(), Published.Num());
+	for (int32 Index = 0; Index < FMath::Min(Payloads.Num(), Published.Num()); ++Index)
+	{
+		TestEqual(FString::Printf(TEXT("Payload %d should match"), Index), ToArray(Payloads[Index]), Published[Index]);
+	}
+	
+	const uint8 Raw[] = { MoqEnvelope::MagicByte, static_cast<uint8>(MoqEnvelope::EKind::Raw), MoqEnvelope::MagicByte, 0x10 };
+	Payloads.Reset();
+	TestTrue(TEXT("Raw envelope should unpack"), MoqEnvelope::Unpack(FSharedBuffer::Clone(Raw, sizeof(Raw)), Payloads));
+	TestEqual(TEXT("Raw envelope should carry the escaped payload"), Payloads.Num() == 1 ? ToArray(Payloads[0]) : TArray<uint8>(), TArray<uint8>({ MoqEnvelope::MagicByte, 0x10 }));
+	
+	Payloads.Reset();
+	FSharedBuffer Truncated = FSharedBuffer::MakeView(Envelope.GetData(), Envelope.GetSize() - 1, Envelope);
+	TestFalse(TEXT("Truncated envelope should be rejected"), MoqEnvelope::Unpack(Truncated, Payloads));
+	TestEqual(TEXT("A rejected envelope should deliver nothing"), Payloads.Num(), 0);
+	
+	const uint8 Unknown[] = { MoqEnvelope::MagicByte, 0xEE, 0x01 };
+	TestFalse(TEXT("Unknown kinds should be rejected"), MoqEnvelope::Unpack(FSharedBuffer::Clone(Unknown, sizeof(Unknown)), Payloads));
+	
+	return true;
+}
@@ -0,0 +1,213 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqFec.h"
+#include "MoqSubscriber.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+/** Datagram Index of a test stream: its index followed by a size that varies, so sizes must be recovered too */
+TArray<uint8> MakeDatagram(int32 Index)
+{
+	TArray<uint8> Datagram;
+	Datagram.Append(reinterpret_cast<const uint8*>(&Index), sizeof(Index));
+	for (int32 Filler = 0; Filler < 20 + Index % 50; ++Filler)
+	{
+		Datagram.Add(static_cast<uint8>(Index + Filler));
+	}
+	return Datagram;
+}
+
+FSharedBuffer ToBuffer(const TArray<uint8>& Bytes)
+{
+	return FSharedBuffer::Clone(Bytes.GetData(), Bytes.Num());
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqFecRecoveryTest, "UnrealMoQ.Fec.Recovery", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqFecRecoveryTest::RunTest(const FString& Parameters)
+{
+	// Test that parity rebuilds one lost datagram per block, whatever its position, and that two losses are counted once the block is dropped
+	FMoqFecEncoder Encoder;
+	Encoder.SetBlockSize(4);
+	FMoqFecDecoder Decoder;
+	
+	TArray<TArray<uint8>> Delivered;
+	auto Deliver = [this, &Decoder, &Delivered](const TArray<uint8>& Wire)
+	{
+		TArray<FSharedBuffer> Datagrams;
+		TestTrue(TEXT("FEC datagram should decode"), Decoder.Add(ToBuffer(Wire), Datagrams));
+		for (const FSharedBuffer& Datagram : Datagrams)
+		{
+			Delivered.Emplace(static_cast<const uint8*>(Datagram.GetData()), static_cast<int32>(Datagram.GetSize()));
+		}
+	};
+	
+	// Block 0 loses its second datagram, block 1 its first and third
+	const bool bLost[] = { false, true, false, false, true, false, true, false };
+	const int32 NumSent = UE_ARRAY_COUNT(bLost);
+	TArray<uint8> Wire;
+	for (int32 Index = 0; Index < NumSent; ++Index)
+	{
+		Encoder.WrapData(MakeDatagram(Index), Wire);
+		if (!bLost[Index])
+		{
+			Deliver(Wire);
+		}
+		if (Encoder.TakeParity(Wire))
+		{
+			Deliver(Wire);
+		}
+	}
+	
+	TestEqual(TEXT("Every datagram of the first block should arrive"), Delivered.Num(), 4 + 2);
+	TestTrue(TEXT("Lost datagram should be rebuilt exactly"), Delivered.Contains(MakeDatagram(1)));
+	TestEqual(TEXT("One datagram should be recovered"), Decoder.GetNumRecovered(), (int64)1);
+	
+	// Push the second block out of the window
+	for (int32 Index = 0; Index < FMoqFecDecoder::MaxBlocks * 4; ++Index)
+	{
+		Encoder.WrapData(MakeDatagram(Index), Wire);
+		Deliver(Wire);
+		if (Encoder.TakeParity(Wire))
+		{
+			Deliver(Wire);
+		}
+	}
+	TestEqual(TEXT("Two losses in one block cannot be recovered"), Decoder.GetNumLost(), (int64)2);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqFecPublisherRestartTest, "UnrealMoQ.Fec.PublisherRestart", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqFecPublisherRestartTest::RunTest(const FString& Parameters)
+{
+	// Test that a recreated publisher, whose block ids start over at 0, still gets its losses rebuilt
+	FMoqFecDecoder Decoder;
+	TArray<TArray<uint8>> Delivered;
+	auto Deliver = [this, &Decoder, &Delivered](const TArray<uint8>& Wire)
+	{
+		TArray<FSharedBuffer> Datagrams;
+		TestTrue(TEXT("FEC datagram should decode"), Decoder.Add(ToBuffer(Wire), Datagrams));
+		for (const FSharedBuffer& Datagram : Datagrams)
+		{
+			Delivered.Emplace(static_cast<const uint8*>(Datagram.GetData()), static_cast<int32>(Datagram.GetSize()));
+		}
+	};
+	
+	// Enough blocks from the first publisher that block 0 has long been evicted
+	TArray<uint8> Wire;
+	{
+		FMoqFecEncoder Encoder;
+		Encoder.SetBlockSize(4);
+		for (int32 Index = 0; Index < FMoqFecDecoder::MaxBlocks * 4 * 3; ++Index)
+		{
+			Encoder.WrapData(MakeDatagram(Index), Wire);
+			Deliver(Wire);
+			if (Encoder.TakeParity(Wire))
+			{
+				Deliver(Wire);
+			}
+		}
+	}
+	Delivered.Reset();
+	
+	// The second publisher loses the second datagram of its first block
+	FMoqFecEncoder Encoder;
+	Encoder.SetBlockSize(4);
+	for (int32 Index = 0; Index < 4; ++Index)
+	{
+		Encoder.WrapData(MakeDatagram(1000 + Index), Wire);
+		if (Index != 1)
+		{
+			Deliver(Wire);
+		}
+		if (Encoder.TakeParity(Wire))
+		{
+			Deliver(Wire);
+		}
+	}
+	
+	TestEqual(TEXT("Every datagram of the restarted block should arrive"), Delivered.Num(), 4);
+	TestTrue(TEXT("Lost datagram should be rebuilt after the restart"), Delivered.Contains(MakeDatagram(1001)));
+	TestEqual(TEXT("One datagram should be recovered"), Decoder.GetNumRecovered(), (int64)1);
+	TestEqual(TEXT("Complete blocks of the first publisher are not lost"), Decoder.GetNumLost(), (int64)0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqFecLoopbackTest, "UnrealMoQ.Fec.Loopback", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqFecLoopbackTest::RunTest(const FString& Parameters)
+{
+	// Test a FEC-protected datagram stream through a subscriber with 10% random loss, including lost parity
+	constexpr int32 BlockSize = 5;
+	constexpr int32 NumDatagrams = 1000;
+	
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	Subscriber->SetEnvelopeDecodingEnabled(true);
+	
+	TSet<int32> Received;
+	bool bAllIntact = true;
+	Subscriber->OnPayloadReceived.AddLambda([&Received, &bAllIntact](TConstArrayView<uint8> Payload)
+	{
+		int32 Index = INDEX_NONE;
+		FMemory::Memcpy(&Index, Payload.GetData(), sizeof(Index));
+		bAllIntact &= TArray<uint8>(Payload) == MakeDatagram(Index);
+		Received.Add(Index);
+	});
+	
+	FMoqFecEncoder Encoder;
+	Encoder.SetBlockSize(BlockSize);
+	FRandomStream Loss(1234);
+	
+	int32 NumLost = 0;
+	int32 NumExpectedRecovered = 0;
+	int32 LostInBlock = 0;
+	TArray<uint8> Wire;
+	for (int32 Index = 0; Index < NumDatagrams; ++Index)
+	{
+		Encoder.WrapData(MakeDatagram(Index), Wire);
+		if (Loss.FRand() < 0.1f)
+		{
+			++NumLost;
+			++LostInBlock;
+		}
+		else
+		{
+			UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Wire.GetData(), Wire.Num());
+		}
+		
+		if (Encoder.TakeParity(Wire))
+		{
+			const bool bParityLost = Loss.FRand() < 0.1f;
+			if (!bParityLost)
+			{
+				UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Wire.GetData(), Wire.Num());
+			}
+			NumExpectedRecovered += (LostInBlock == 1 && !bParityLost) ? 1 : 0;
+			LostInBlock = 0;
+			
+			// Keep the receive queue from overflowing, as the per-frame drain would
+			Subscriber->DispatchPendingEvents();
+		}
+	}
+	Subscriber->DispatchPendingEvents();
+	
+	const FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	AddInfo(FString::Printf(TEXT("%d of %d datagrams lost, %lld recovered with %d%% parity overhead, %d still missing"),
+		NumLost, NumDatagrams, Stats.FecRecoveredObjects, 100 / BlockSize, NumDatagrams - Received.Num()));
+	
+	TestTrue(TEXT("Loss should have been injected"), NumLost > 0);
+	TestEqual(TEXT("Every single loss with its parity should be recovered"), Stats.FecRecoveredObjects, (int64)NumExpectedRecovered);
+	TestEqual(TEXT("Delivered datagrams should be the received and recovered ones"), Received.Num(), NumDatagrams - NumLost + NumExpectedRecovered);
+	TestTrue(TEXT("Recovered datagrams should be intact"), bAllIntact);
+	TestTrue(TEXT("Losses that were not recovered should be counted once their block is dropped"), Stats.FecLostObjects <= NumLost - NumExpectedRecovered);
+	TestEqual(TEXT("FEC datagrams are not malformed"), Stats.MalformedObjects, (int64)0);
+	
+	return true;
+}
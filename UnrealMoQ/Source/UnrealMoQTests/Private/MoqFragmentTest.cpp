@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqFragment.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+TArray<FSharedBuffer> MakeFragments(const TArray<uint8>& Object, uint64 ObjectId, int32 MaxDatagramSize)
+{
+	TArray<FSharedBuffer> Fragments;
+	const int32 Count = MoqFragment::GetFragmentCount(Object.Num(), ObjectId, MaxDatagramSize);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		TArray<uint8> Fragment;
+		MoqFragment::WriteFragment(Object, ObjectId, Index, Count, Fragment);
+		Fragments.Add(FSharedBuffer::Clone(Fragment.GetData(), Fragment.Num()));
+	}
+	return Fragments;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqFragmentRoundTripTest, "UnrealMoQ.Fragment.RoundTrip", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqFragmentRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Test that fragments fit the datagram size and rebuild the object in any order, duplicates included
+	TArray<uint8> Object;
+	for (int32 Index = 0; Index < 5000; ++Index)
+	{
+		Object.Add(static_cast<uint8>(Index * 7));
+	}
+	
+	TArray<FSharedBuffer> Fragments = MakeFragments(Object, 300, 1100);
+	TestEqual(TEXT("Object should need five fragments"), Fragments.Num(), 5);
+	for (const FSharedBuffer& Fragment : Fragments)
+	{
+		TestTrue(TEXT("Every fragment should fit in a datagram"), Fragment.GetSize() <= 1100);
+	}
+	
+	FMoqFragmentReassembler Reassembler;
+	const int32 Order[] = { 3, 0, 4, 0, 2, 1 };
+	const int32 NumSteps = UE_ARRAY_COUNT(Order);
+	FSharedBuffer Rebuilt;
+	for (int32 Step = 0; Step < NumSteps; ++Step)
+	{
+		TestTrue(TEXT("Fragment should be accepted"), Reassembler.Add(Fragments[Order[Step]], 0.0, Rebuilt));
+		TestEqual(TEXT("Object should only be complete after its last fragment"), Rebuilt.IsNull(), Step < NumSteps - 1);
+	}
+	
+	if (!Rebuilt.IsNull())
+	{
+		TestEqual(TEXT("Rebuilt object should match"), TArray<uint8>(static_cast<const uint8*>(Rebuilt.GetData()), static_cast<int32>(Rebuilt.GetSize())), Object);
+	}
+	TestEqual(TEXT("Fragments should be counted"), Reassembler.GetNumFragments(), (int64)6);
+	TestEqual(TEXT("Object should be counted"), Reassembler.GetNumReassembled(), (int64)1);
+	TestEqual(TEXT("Nothing should remain pending"), Reassembler.GetPendingBytes(), (int64)0);
+	
+	TestEqual(TEXT("A datagram too small for the header cannot carry fragments"), MoqFragment::GetFragmentCount(5000, 300, 8), 0);
+	
+	TArray<uint8> Truncated;
+	MoqFragment::WriteFragment(Object, 1, 0, 5, Truncated);
+	Truncated.Pop();
+	FSharedBuffer Ignored;
+	TestFalse(TEXT("A fragment of the wrong size should be rejected"), Reassembler.Add(FSharedBuffer::Clone(Truncated.GetData(), Truncated.Num()), 0.0, Ignored));
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqFragmentEvictionTest, "UnrealMoQ.Fragment.Eviction", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqFragmentEvictionTest::RunTest(const FString& Parameters)
+{
+	// Test that objects missing a fragment time out and that the memory cap discards the oldest object
+	TArray<uint8> Object;
+	Object.Init(0x5A, 3000);
+	
+	FMoqFragmentReassembler Reassembler;
+	Reassembler.SetLimits(7000, 0.1);
+	
+	FSharedBuffer Rebuilt;
+	const TArray<FSharedBuffer> Lost = MakeFragments(Object, 1, 1100);
+	Reassembler.Add(Lost[0], 0.0, Rebuilt);
+	TestEqual(TEXT("Partial object should hold its full size"), Reassembler.GetPendingBytes(), (int64)3000);
+	
+	// Object 1 never completes; the next object to start finds it past the timeout
+	Reassembler.Add(MakeFragments(Object, 2, 1100)[0], 0.5, Rebuilt);
+	TestEqual(TEXT("Timed out object should count as failed"), Reassembler.GetNumFailed(), (int64)1);
+	TestEqual(TEXT("Timed out object should free its memory"), Reassembler.GetPendingBytes(), (int64)3000);
+	
+	// Two more objects do not fit next to object 2
+	Reassembler.Add(MakeFragments(Object, 3, 1100)[0], 0.55, Rebuilt);
+	Reassembler.Add(MakeFragments(Object, 4, 1100)[0], 0.56, Rebuilt);
+	TestEqual(TEXT("Oldest object should make room"), Reassembler.GetNumFailed(), (int64)2);
+	TestTrue(TEXT("Pending memory should stay under the cap"), Reassembler.GetPendingBytes() <= 7000);
+	
+	TArray<uint8> Huge;
+	Huge.Init(0, 8000);
+	Reassembler.Add(MakeFragments(Huge, 5, 1100)[0], 0.6, Rebuilt);
+	TestEqual(TEXT("Object larger than the cap should fail immediately"), Reassembler.GetNumFailed(), (int64)3);
+	
+	return true;
+}
@@ -0,0 +1,76 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqHandleRegistry.h"
+#include "Async/Async.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+struct FMoqRegistryTestObject
+{
+	int32 Value = 0;
+};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqHandleRegistryLifetimeTest, "UnrealMoQ.HandleRegistry.Lifetime", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqHandleRegistryLifetimeTest::RunTest(const FString& Parameters)
+{
+	// Test that handles resolve while registered and stay dead after their slot is reused
+	TUniquePtr<TMoqHandleRegistry<FMoqRegistryTestObject>> Registry = MakeUnique<TMoqHandleRegistry<FMoqRegistryTestObject>>();
+	
+	FMoqRegistryTestObject First;
+	FMoqRegistryTestObject Second;
+	
+	void* FirstHandle = Registry->Register(&First);
+	TestNotNull(TEXT("Register should return a handle"), FirstHandle);
+	TestTrue(TEXT("Handle should resolve to its object"), Registry->Pin(FirstHandle).Get() == &First);
+	
+	TestTrue(TEXT("Unregister should succeed once"), Registry->Unregister(FirstHandle));
+	TestFalse(TEXT("Unregister should fail for a stale handle"), Registry->Unregister(FirstHandle));
+	TestFalse(TEXT("Stale handle should not resolve"), (bool)Registry->Pin(FirstHandle));
+	
+	void* SecondHandle = Registry->Register(&Second);
+	TestTrue(TEXT("Reused slot should get a new handle"), SecondHandle != FirstHandle);
+	TestNull(TEXT("Stale handle should not resolve to the new object"), Registry->Resolve(FirstHandle));
+	TestTrue(TEXT("New handle should resolve"), Registry->Resolve(SecondHandle) == &Second);
+	TestEqual(TEXT("One handle should be live"), Registry->Num(), 1);
+	
+	TestNull(TEXT("Null user data should not resolve"), Registry->Resolve(nullptr));
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqHandleRegistryPinTest, "UnrealMoQ.HandleRegistry.Pin", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqHandleRegistryPinTest::RunTest(const FString& Parameters)
+{
+	// Test that Unregister waits for a pin held on another thread
+	TUniquePtr<TMoqHandleRegistry<FMoqRegistryTestObject>> Registry = MakeUnique<TMoqHandleRegistry<FMoqRegistryTestObject>>();
+	
+	FMoqRegistryTestObject Object;
+	void* Handle = Registry->Register(&Object);
+	
+	std::atomic<bool> bPinned{ false };
+	std::atomic<bool> bReleased{ false };
+	TFuture<void> Holder = Async(EAsyncExecution::Thread, [&Registry, Handle, &bPinned, &bReleased]()
+	{
+		TMoqHandleRegistry<FMoqRegistryTestObject>::FPin Pin = Registry->Pin(Handle);
+		bPinned = true;
+		FPlatformProcess::Sleep(0.05f);
+		bReleased = true;
+	});
+	
+	while (!bPinned)
+	{
+		FPlatformProcess::YieldThread();
+	}
+	
+	Registry->Unregister(Handle);
+	TestTrue(TEXT("Unregister should return only after the pin is released"), bReleased.load());
+	
+	Holder.Wait();
+	
+	return true;
+}
@@ -224,3 +224,143 @@ bool FMoqPublisherPublishTextLongTextTest::RunTest(const FString& Parameters)
 	
 	return true;
 }
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublisherAsyncModeWithoutInitTest, "UnrealMoQ.Publisher.PublishMode.AsyncWithoutInit", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqPublisherAsyncModeWithoutInitTest::RunTest(const FString& Parameters)
+{
+	// Test that async mode still validates synchronously and queues nothing without a handle
+	UMoqPublisher* Publisher = NewObject<UMoqPublisher>();
+	
+	FMoqPublishOptions Options;
+	Options.Mode = EMoqPublishMode::Async;
+	Publisher->ApplyOptions(Options);
+	TestEqual(TEXT("Publish mode should come from options"), Publisher->GetPublishMode(), EMoqPublishMode::Async);
+	
+	TArray<uint8> TestData = { 0x01, 0x02, 0x03 };
+	FMoqResult Result = Publisher->PublishData(TestData, EMoqDeliveryMode::Datagram);
+	TestFalse(TEXT("Async PublishData without initialization should fail"), Result.bSuccess);
+	TestTrue(TEXT("Error message should mention publisher not initialized"), Result.ErrorMessage.Contains(TEXT("not initialized")));
+	
+	Result = Publisher->PublishData(TArray<uint8>(), EMoqDeliveryMode::Datagram);
+	TestTrue(TEXT("Empty data should still be rejected first"), Result.ErrorMessage.Contains(TEXT("empty")));
+	
+	const FMoqPublisherStats Stats = Publisher->GetPublisherStats();
+	TestEqual(TEXT("Nothing should be queued"), Stats.QueuedObjects, 0);
+	TestEqual(TEXT("Nothing should be counted as dropped"), Stats.DroppedObjects, (int64)0);
+	
+	Publisher->SetPublishMode(EMoqPublishMode::Immediate);
+	TestEqual(TEXT("Publish mode should be switchable"), Publisher->GetPublishMode(), EMoqPublishMode::Immediate);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublisherBatchWithoutInitTest, "UnrealMoQ.Publisher.PublishBatch.WithoutInit", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqPublisherBatchWithoutInitTest::RunTest(const FString& Parameters)
+{
+	// Test that a batch on an uninitialized publisher reports every object as failed
+	UMoqPublisher* Publisher = NewObject<UMoqPublisher>();
+	
+	TArray<FMoqPublishPayload> Objects;
+	Objects.AddDefaulted(3);
+	Objects[0].Data = { 0x01 };
+	Objects[1].Data = { 0x02, 0x03 };
+	
+	FMoqBatchPublishResult Result = Publisher->PublishBatch(Objects, EMoqDeliveryMode::Stream);
+	TestEqual(TEXT("No objects should succeed"), Result.NumSucceeded, 0);
+	TestEqual(TEXT("Every object should be reported as failed"), Result.FailedIndices, TArray<int32>({ 0, 1, 2 }));
+	TestTrue(TEXT("First error should mention publisher not initialized"), Result.FirstErrorMessage.Contains(TEXT("not initialized")));
+	TestFalse(TEXT("Batch should not report success"), Result.AllSucceeded());
+	
+	Result = Publisher->PublishBatch(TArray<FMoqPublishPayload>(), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Empty batch should succeed trivially"), Result.AllSucceeded());
+	TestEqual(TEXT("Empty batch should publish nothing"), Result.NumSucceeded, 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublisherPublishDataOverloadsTest, "UnrealMoQ.Publisher.PublishData.Overloads", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqPublisherPublishDataOverloadsTest::RunTest(const FString& Parameters)
+{
+	// Test that the view, shared buffer and moved array overloads validate like PublishData
+	UMoqPublisher* Publisher = NewObject<UMoqPublisher>();
+	Publisher->SetPublishMode(EMoqPublishMode::Async);
+	
+	const uint8 Bytes[] = { 0x01, 0x02, 0x03 };
+	
+	FMoqResult Result = Publisher->PublishData(TConstArrayView<uint8>(Bytes), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("View publish without initialization should fail"), Result.ErrorMessage.Contains(TEXT("not initialized")));
+	
+	Result = Publisher->PublishData(TConstArrayView<uint8>(), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Empty view should be rejected"), Result.ErrorMessage.Contains(TEXT("empty")));
+	
+	Result = Publisher->PublishData(FSharedBuffer::MakeView(Bytes, sizeof(Bytes)), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Shared buffer publish without initialization should fail"), Result.ErrorMessage.Contains(TEXT("not initialized")));
+	
+	Result = Publisher->PublishData(FSharedBuffer(), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Empty shared buffer should be rejected"), Result.ErrorMessage.Contains(TEXT("empty")));
+	
+	TArray<uint8> Owned = { 0x04, 0x05 };
+	Result = Publisher->PublishData(MoveTemp(Owned), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Moved array publish without initialization should fail"), Result.ErrorMessage.Contains(TEXT("not initialized")));
+	
+	Result = Publisher->PublishText(TEXT("Hello, MoQ!"), EMoqDeliveryMode::Stream);
+	TestTrue(TEXT("Async text publish without initialization should fail"), Result.ErrorMessage.Contains(TEXT("not initialized")));
+	
+	TestEqual(TEXT("Nothing should be queued"), Publisher->GetPublisherStats().QueuedObjects, 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublisherBackpressureOptionsTest, "UnrealMoQ.Publisher.Backpressure.Options", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqPublisherBackpressureOptionsTest::RunTest(const FString& Parameters)
+{
+	// Test the send window defaults and that an uninitialized publisher reports no backpressure
+	FMoqPublishOptions Defaults;
+	TestEqual(TEXT("Default policy should fail fast"), Defaults.BackpressurePolicy, EMoqBackpressurePolicy::FailFast);
+	TestEqual(TEXT("Default byte window should be unlimited"), Defaults.MaxQueuedBytes, (int64)0);
+	
+	UMoqPublisher* Publisher = NewObject<UMoqPublisher>();
+	
+	FMoqPublishOptions Options;
+	Options.Mode = EMoqPublishMode::Async;
+	Options.MaxQueuedObjects = 4;
+	Options.MaxQueuedBytes = 1024;
+	Options.BackpressurePolicy = EMoqBackpressurePolicy::CoalesceLatest;
+	Publisher->ApplyOptions(Options);
+	
+	TestFalse(TEXT("Uninitialized publisher should not be backpressured"), Publisher->IsBackpressured());
+	
+	const FMoqPublisherStats Stats = Publisher->GetPublisherStats();
+	TestEqual(TEXT("No bytes should be queued"), Stats.QueuedBytes, (int64)0);
+	TestFalse(TEXT("Stats should not report backpressure"), Stats.bBackpressured);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqPublisherPriorityTest, "UnrealMoQ.Publisher.Priority", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqPublisherPriorityTest::RunTest(const FString& Parameters)
+{
+	// Test the priority defaults and that priority set before initialization is kept
+	FMoqPublishOptions Defaults;
+	TestEqual(TEXT("Default priority should be in the middle of the range"), Defaults.Priority, (uint8)128);
+	TestEqual(TEXT("Queued objects should never expire by default"), Defaults.MaxQueueDelayMs, 0.0f);
+	
+	UMoqPublisher* Publisher = NewObject<UMoqPublisher>();
+	
+	FMoqPublishOptions Options;
+	Options.Priority = 16;
+	Options.MaxQueueDelayMs = 250.0f;
+	Publisher->ApplyOptions(Options);
+	TestEqual(TEXT("Priority from options should be reported"), Publisher->GetPriority(), (uint8)16);
+	
+	Publisher->SetPriority(200);
+	TestEqual(TEXT("Priority should be updated"), Publisher->GetPriority(), (uint8)200);
+	TestEqual(TEXT("No objects should have expired"), Publisher->GetPublisherStats().ExpiredObjects, (int64)0);
+	
+	return true;
+}
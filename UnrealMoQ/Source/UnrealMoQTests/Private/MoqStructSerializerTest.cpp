@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqStructSerializer.h"
+#include "MoqSubscriber.h"
+#include "MoqTypes.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqStructSerializerRoundTripTest, "UnrealMoQ.StructSerializer.RoundTrip", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqStructSerializerRoundTripTest::RunTest(const FString& Parameters)
+{
+	// Test that structs with numbers, arrays and strings decode to the values they were encoded from
+	FMoqReceivedMessage Message;
+	Message.Data = { 1, 2, 3, 250 };
+	Message.ArrivalTime = 12.5;
+	Message.Sequence = -7;
+	Message.GroupId = 1ll << 40;
+	Message.ObjectId = 3;
+	
+	TArray<uint8> Encoded;
+	MoqStructSerializer::Serialize(Message, Encoded);
+	TestEqual(TEXT("Encoding should start with the format version"), Encoded.Num() > 0 ? Encoded[0] : (uint8)0, MoqStructSerializer::FormatVersion);
+	TestEqual(TEXT("Encoding should be the header, the array and the packed numbers"), Encoded.Num(), MoqStructSerializer::HeaderSize + 1 + 4 + 8 * 4);
+	
+	FMoqReceivedMessage Decoded;
+	TestTrue(TEXT("Encoding should decode"), MoqStructSerializer::Deserialize(Encoded, Decoded));
+	TestTrue(TEXT("Array should round-trip"), Decoded.Data == Message.Data);
+	TestEqual(TEXT("Double should round-trip"), Decoded.ArrivalTime, Message.ArrivalTime);
+	TestEqual(TEXT("Negative integer should round-trip"), Decoded.Sequence, Message.Sequence);
+	TestEqual(TEXT("Large integer should round-trip"), Decoded.GroupId, Message.GroupId);
+	TestEqual(TEXT("Integer should round-trip"), Decoded.ObjectId, Message.ObjectId);
+	
+	FMoqBatchPublishResult Batch;
+	Batch.NumSucceeded = 5;
+	Batch.FailedIndices = { 2, 9 };
+	Batch.FirstErrorMessage = TEXT("Publish failed é");
+	MoqStructSerializer::Serialize(Batch, Encoded);
+	
+	FMoqBatchPublishResult DecodedBatch;
+	TestTrue(TEXT("Struct with a string should decode"), MoqStructSerializer::Deserialize(Encoded, DecodedBatch));
+	TestEqual(TEXT("Int should round-trip"), DecodedBatch.NumSucceeded, Batch.NumSucceeded);
+	TestTrue(TEXT("Int array should round-trip"), DecodedBatch.FailedIndices == Batch.FailedIndices);
+	TestEqual(TEXT("Non-ASCII string should round-trip"), DecodedBatch.FirstErrorMessage, Batch.FirstErrorMessage);
+	
+	const FVector Vector(1.0, -2.0, 3.5);
+	MoqStructSerializer::Serialize(TBaseStructure<FVector>::Get(), &Vector, Encoded);
+	TestEqual(TEXT("Plain struct should encode as its memory"), Encoded.Num(), MoqStructSerializer::HeaderSize + (int32)sizeof(FVector));
+	
+	FVector DecodedVector;
+	TestTrue(TEXT("Plain struct should decode"), MoqStructSerializer::Deserialize(TBaseStructure<FVector>::Get(), Encoded, &DecodedVector));
+	TestEqual(TEXT("Plain struct should round-trip"), DecodedVector, Vector);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqStructSerializerRejectTest, "UnrealMoQ.StructSerializer.Reject", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqStructSerializerRejectTest::RunTest(const FString& Parameters)
+{
+	// Test that data from another struct, truncated data and trailing data are rejected
+	TestNotEqual(TEXT("Different structs should have different schemas"),
+		MoqStructSerializer::GetSchemaHash(FMoqReceivedMessage::StaticStruct()), MoqStructSerializer::GetSchemaHash(FMoqBatchPublishResult::StaticStruct()));
+	
+	FMoqBatchPublishResult Batch;
+	Batch.FailedIndices = { 1, 2, 3 };
+	Batch.FirstErrorMessage = TEXT("Error");
+	TArray<uint8> Encoded;
+	MoqStructSerializer::Serialize(Batch, Encoded);
+	
+	FString Error;
+	FMoqReceivedMessage Message;
+	TestFalse(TEXT("Another struct's encoding should be rejected"), MoqStructSerializer::Deserialize(Encoded, Message, &Error));
+	TestFalse(TEXT("Schema mismatch should be explained"), Error.IsEmpty());
+	
+	FMoqBatchPublishResult Decoded;
+	TArray<uint8> Truncated = Encoded;
+	Truncated.Pop();
+	TestFalse(TEXT("Truncated encoding should be rejected"), MoqStructSerializer::Deserialize(Truncated, Decoded));
+	TestFalse(TEXT("Header alone should be rejected"), MoqStructSerializer::Deserialize(MakeArrayView(Encoded.GetData(), MoqStructSerializer::HeaderSize), Decoded));
+	
+	TArray<uint8> Trailing = Encoded;
+	Trailing.Add(0);
+	TestFalse(TEXT("Trailing bytes should be rejected"), MoqStructSerializer::Deserialize(Trailing, Decoded));
+	
+	TArray<uint8> OtherVersion = Encoded;
+	OtherVersion[0] = MoqStructSerializer::FormatVersion + 1;
+	TestFalse(TEXT("Unknown format version should be rejected"), MoqStructSerializer::Deserialize(OtherVersion, Decoded));
+	
+	TestTrue(TEXT("Intact encoding should still decode"), MoqStructSerializer::Deserialize(Encoded, Decoded));
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqStructSerializerBoolTest, "UnrealMoQ.StructSerializer.Bool", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqStructSerializerBoolTest::RunTest(const FString& Parameters)
+{
+	// Test that a bool byte other than 0 or 1 from the wire decodes to a valid true instead of being copied into the bool
+	const FMoqResult Result(true, TEXT("Ok"));
+	TArray<uint8> Encoded;
+	MoqStructSerializer::Serialize(Result, Encoded);
+	TestEqual(TEXT("Bool should encode as one byte"), Encoded.Num() > MoqStructSerializer::HeaderSize ? Encoded[MoqStructSerializer::HeaderSize] : (uint8)0, (uint8)1);
+	
+	const uint8 WireBytes[] = { 2, 0x80, 0xFF };
+	for (const uint8 WireByte : WireBytes)
+	{
+		Encoded[MoqStructSerializer::HeaderSize] = WireByte;
+		FMoqResult Decoded;
+		TestTrue(TEXT("Encoding with an odd bool byte should decode"), MoqStructSerializer::Deserialize(Encoded, Decoded));
+		TestEqual(TEXT("Bool should hold exactly 1 in memory"), *reinterpret_cast<const uint8*>(&Decoded.bSuccess), (uint8)1);
+		TestEqual(TEXT("Field after the bool should still decode"), Decoded.ErrorMessage, Result.ErrorMessage);
+	}
+	
+	Encoded[MoqStructSerializer::HeaderSize] = 0;
+	FMoqResult Decoded(true);
+	TestTrue(TEXT("Encoding with a false bool should decode"), MoqStructSerializer::Deserialize(Encoded, Decoded));
+	TestFalse(TEXT("Zero byte should decode to false"), Decoded.bSuccess);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqStructSerializerSubscriberTest, "UnrealMoQ.StructSerializer.Subscriber", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqStructSerializerSubscriberTest::RunTest(const FString& Parameters)
+{
+	// Test that a subscriber decodes objects as its struct type and counts objects that are not
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	TArray<int32> Received;
+	Subscriber->AddStructHandler<FMoqBatchPublishResult>([&Received](const FMoqBatchPublishResult& Result)
+	{
+		Received.Add(Result.NumSucceeded);
+	});
+	
+	TArray<uint8> Encoded;
+	for (int32 Index = 0; Index < 3; ++Index)
+	{
+		FMoqBatchPublishResult Batch;
+		Batch.NumSucceeded = Index;
+		MoqStructSerializer::Serialize(Batch, Encoded);
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Encoded.GetData(), Encoded.Num());
+	}
+	
+	AddExpectedMessage(TEXT("Cannot decode object"), ELogVerbosity::Warning, EAutomationExpectedMessageFlags::Contains, 1);
+	FMoqReceivedMessage Message;
+	MoqStructSerializer::Serialize(Message, Encoded);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Encoded.GetData(), Encoded.Num());
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Encoded.GetData(), Encoded.Num());
+	Subscriber->DispatchPendingEvents();
+	
+	TestTrue(TEXT("Every matching object should be decoded in order"), Received == TArray<int32>({ 0, 1, 2 }));
+	TestEqual(TEXT("Objects of another struct should be counted"), Subscriber->GetReceiveQueueStats().StructDecodeFailures, (int64)2);
+	
+	return true;
+}
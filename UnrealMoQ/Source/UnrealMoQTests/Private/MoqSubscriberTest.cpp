@@ -3,6 +3,10 @@
 #include "MoqSubscriber.h"
 #include "MoqClient.h"
 #include "MoqAutomationTestFlags.h"
+#include "MoqCompression.h"
+#include "MoqDelta.h"
+#include "MoqEnvelope.h"
+#include "MoqPayloadPool.h"
 
 IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberConstructionTest, "UnrealMoQ.Subscriber.Construction", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
 
@@ -82,7 +86,7 @@ bool FMoqSubscriberOnDataReceivedCallbackNullDataTest::RunTest(const FString& Pa
 	// Test callback with null data
 	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, nullptr, 10);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), nullptr, 10);
 	
 	// Should not crash
 	TestTrue(TEXT("OnDataReceivedCallback with null data should not crash"), true);
@@ -98,7 +102,7 @@ bool FMoqSubscriberOnDataReceivedCallbackZeroLengthTest::RunTest(const FString&
 	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
 	uint8 TestData[] = { 0x01 };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData, 0);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 0);
 	
 	// Should not crash
 	TestTrue(TEXT("OnDataReceivedCallback with zero length should not crash"), true);
@@ -120,7 +124,7 @@ bool FMoqSubscriberOnDataReceivedCallbackValidDataTest::RunTest(const FString& P
 	// Here we just verify the callback doesn't crash
 	uint8 TestData[] = { 0x01, 0x02, 0x03, 0x04, 0x05 };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData, 5);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 5);
 	
 	// Should not crash
 	TestTrue(TEXT("OnDataReceivedCallback with valid data should not crash"), true);
@@ -138,7 +142,7 @@ bool FMoqSubscriberOnDataReceivedCallbackValidUTF8Test::RunTest(const FString& P
 	// "Hello" in UTF-8
 	uint8 TestData[] = { 'H', 'e', 'l', 'l', 'o' };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData, 5);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 5);
 	
 	// Should not crash and should broadcast both data and text events
 	TestTrue(TEXT("OnDataReceivedCallback with valid UTF-8 should not crash"), true);
@@ -156,7 +160,7 @@ bool FMoqSubscriberOnDataReceivedCallbackInvalidUTF8Test::RunTest(const FString&
 	// Invalid UTF-8 sequence
 	uint8 TestData[] = { 0xFF, 0xFE, 0xFD };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
 	
 	// Should not crash, should broadcast data event but not text event
 	TestTrue(TEXT("OnDataReceivedCallback with invalid UTF-8 should not crash"), true);
@@ -174,7 +178,7 @@ bool FMoqSubscriberOnDataReceivedCallbackUnicodeTest::RunTest(const FString& Par
 	// "世" in UTF-8: E4 B8 96
 	uint8 TestData[] = { 0xE4, 0xB8, 0x96 };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
 	
 	// Should not crash and should broadcast both data and text events
 	TestTrue(TEXT("OnDataReceivedCallback with Unicode should not crash"), true);
@@ -196,7 +200,7 @@ bool FMoqSubscriberOnDataReceivedCallbackLargeDataTest::RunTest(const FString& P
 		LargeData[i] = static_cast<uint8>(i % 256);
 	}
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, LargeData.GetData(), LargeData.Num());
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), LargeData.GetData(), LargeData.Num());
 	
 	// Should not crash
 	TestTrue(TEXT("OnDataReceivedCallback with large data should not crash"), true);
@@ -215,12 +219,674 @@ bool FMoqSubscriberMultipleCallbacksTest::RunTest(const FString& Parameters)
 	uint8 TestData2[] = { 0x04, 0x05, 0x06 };
 	uint8 TestData3[] = { 0x07, 0x08, 0x09 };
 	
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData1, 3);
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData2, 3);
-	UMoqSubscriber::OnDataReceivedCallback(Subscriber, TestData3, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData1, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData2, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData3, 3);
 	
 	// Should not crash
 	TestTrue(TEXT("Multiple callbacks should not crash"), true);
 	
 	return true;
 }
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberReceiveQueueDispatchTest, "UnrealMoQ.Subscriber.ReceiveQueue.Dispatch", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberReceiveQueueDispatchTest::RunTest(const FString& Parameters)
+{
+	// Test that callbacks are queued and delivered by a single drain
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	uint8 TestData[] = { 0x01, 0x02, 0x03 };
+	
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
+	
+	FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Three objects should be queued"), Stats.QueuedObjects, 3);
+	TestEqual(TEXT("Three objects should be counted as received"), Stats.ReceivedObjects, (int64)3);
+	
+	TestEqual(TEXT("Drain should deliver every queued object"), Subscriber->DispatchPendingEvents(), 3);
+	
+	Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Queue should be empty after drain"), Stats.QueuedObjects, 0);
+	TestEqual(TEXT("Three objects should be counted as delivered"), Stats.DeliveredObjects, (int64)3);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberReceiveQueueDropNewestTest, "UnrealMoQ.Subscriber.ReceiveQueue.DropNewest", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberReceiveQueueDropNewestTest::RunTest(const FString& Parameters)
+{
+	// Test that a saturated queue rejects new objects and counts them
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	FMoqSubscribeOptions Options;
+	Options.ReceiveQueueCapacity = 4;
+	Options.OverflowPolicy = EMoqOverflowPolicy::DropNewest;
+	Subscriber->ApplyOptions(Options);
+	
+	for (uint8 Index = 0; Index < 6; ++Index)
+	{
+		uint8 TestData[] = { Index };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	const FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Capacity should match options"), Stats.Capacity, 4);
+	TestEqual(TEXT("Queue should be full"), Stats.QueuedObjects, 4);
+	TestEqual(TEXT("Two objects should be dropped"), Stats.DroppedObjects, (int64)2);
+	TestEqual(TEXT("Peak should reach capacity"), Stats.PeakQueuedObjects, 4);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberReceiveQueueDropOldestTest, "UnrealMoQ.Subscriber.ReceiveQueue.DropOldest", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberReceiveQueueDropOldestTest::RunTest(const FString& Parameters)
+{
+	// Test that drop-oldest keeps the most recent objects
+	TMoqBoundedRing<int32> Ring(4);
+	
+	for (int32 Value = 0; Value < 6; ++Value)
+	{
+		Ring.Enqueue(CopyTemp(Value), EMoqOverflowPolicy::DropOldest);
+	}
+	
+	TestEqual(TEXT("Two objects should be evicted"), Ring.GetNumDropped(), (int64)2);
+	
+	int32 First = INDEX_NONE;
+	TestTrue(TEXT("Ring should not be empty"), Ring.TryDequeue(First));
+	TestEqual(TEXT("Oldest surviving object should be the third one pushed"), First, 2);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberNativePayloadDelegateTest, "UnrealMoQ.Subscriber.NativePayloadDelegate", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberNativePayloadDelegateTest::RunTest(const FString& Parameters)
+{
+	// Test that native listeners receive the payload bytes as a view
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	TArray<uint8> ReceivedData;
+	Subscriber->OnPayloadReceived.AddLambda([&ReceivedData](TConstArrayView<uint8> Data)
+	{
+		ReceivedData.Append(Data.GetData(), Data.Num());
+	});
+	
+	uint8 TestData[] = { 0x10, 0x20, 0x30, 0x40 };
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 4);
+	Subscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("Native listener should receive every byte"), ReceivedData.Num(), 4);
+	TestTrue(TEXT("Native listener should receive the original bytes"), ReceivedData.Num() == 4 && FMemory::Memcmp(ReceivedData.GetData(), TestData, 4) == 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberPayloadPoolReuseTest, "UnrealMoQ.Subscriber.PayloadPool.Reuse", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberPayloadPoolReuseTest::RunTest(const FString& Parameters)
+{
+	// Test that released payload blocks are handed out again
+	FMoqPayloadPool& Pool = FMoqPayloadPool::Get();
+	
+	uint8 TestData[100] = {};
+	{
+		FSharedBuffer First = Pool.CopyFrom(TestData, sizeof(TestData));
+		TestEqual(TEXT("Pooled buffer should report the payload size"), First.GetSize(), (uint64)sizeof(TestData));
+	}
+	
+	const int64 ReusedBefore = Pool.GetNumReused();
+	FSharedBuffer Second = Pool.CopyFrom(TestData, sizeof(TestData));
+	
+	TestTrue(TEXT("Second allocation of the same size class should reuse a block"), Pool.GetNumReused() > ReusedBefore);
+	TestTrue(TEXT("Pooled buffer should contain the copied bytes"), FMemory::Memcmp(Second.GetData(), TestData, sizeof(TestData)) == 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberTrackContentTest, "UnrealMoQ.Subscriber.TrackContent", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberTrackContentTest::RunTest(const FString& Parameters)
+{
+	// Test that track content defaults to lazy decoding and follows the subscribe options
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	TestEqual(TEXT("Track content should default to Auto"), Subscriber->GetTrackContent(), EMoqTrackContent::Auto);
+	
+	FMoqSubscribeOptions Options;
+	Options.Content = EMoqTrackContent::Binary;
+	Subscriber->ApplyOptions(Options);
+	
+	TestEqual(TEXT("Track content should follow the options"), Subscriber->GetTrackContent(), EMoqTrackContent::Binary);
+	
+	// Binary tracks still deliver to native listeners
+	int32 NumPayloads = 0;
+	Subscriber->OnPayloadReceived.AddLambda([&NumPayloads](TConstArrayView<uint8>)
+	{
+		++NumPayloads;
+	});
+	
+	uint8 TestData[] = { 'H', 'e', 'l', 'l', 'o' };
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 5);
+	Subscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("Binary track should still deliver payloads"), NumPayloads, 1);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberDataSinkCallbackThreadTest, "UnrealMoQ.Subscriber.DataSink.CallbackThread", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberDataSinkCallbackThreadTest::RunTest(const FString& Parameters)
+{
+	// Test that a callback thread sink runs inline and can replace game thread delivery
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	int32 NumSinkCalls = 0;
+	uint64 LastSize = 0;
+	TSharedRef<IMoqDataSink, ESPMode::ThreadSafe> Sink = MakeMoqDataSink([&NumSinkCalls, &LastSize](const FSharedBuffer& Payload)
+	{
+		++NumSinkCalls;
+		LastSize = Payload.GetSize();
+	});
+	
+	FMoqDataSinkOptions Options;
+	Options.Thread = EMoqSinkThread::CallbackThread;
+	Subscriber->AddDataSink(Sink, Options);
+	Subscriber->SetGameThreadDeliveryEnabled(false);
+	
+	uint8 TestData[] = { 0x01, 0x02, 0x03 };
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
+	
+	TestEqual(TEXT("Sink should be called from the callback"), NumSinkCalls, 1);
+	TestEqual(TEXT("Sink should see the full payload"), LastSize, (uint64)3);
+	TestEqual(TEXT("Nothing should be queued for the game thread"), Subscriber->GetReceiveQueueStats().QueuedObjects, 0);
+	
+	Subscriber->RemoveDataSink(Sink);
+	Subscriber->SetGameThreadDeliveryEnabled(true);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 3);
+	
+	TestEqual(TEXT("Removed sink should not be called again"), NumSinkCalls, 1);
+	TestEqual(TEXT("Game thread queue should receive the object"), Subscriber->GetReceiveQueueStats().QueuedObjects, 1);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberDataSinkWorkerTest, "UnrealMoQ.Subscriber.DataSink.Worker", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberDataSinkWorkerTest::RunTest(const FString& Parameters)
+{
+	// Test that a worker sink receives every object, in order, off the game thread
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	constexpr int32 NumObjects = 64;
+	std::atomic<int32> NumReceived{ 0 };
+	std::atomic<bool> bInOrder{ true };
+	std::atomic<bool> bOffGameThread{ true };
+	
+	Subscriber->AddDataSink(MakeMoqDataSink([&NumReceived, &bInOrder, &bOffGameThread](const FSharedBuffer& Payload)
+	{
+		const int32 Expected = NumReceived.load();
+		if (static_cast<const uint8*>(Payload.GetData())[0] != static_cast<uint8>(Expected))
+		{
+			bInOrder = false;
+		}
+		if (IsInGameThread())
+		{
+			bOffGameThread = false;
+		}
+		NumReceived.store(Expected + 1);
+	}));
+	
+	for (int32 Index = 0; Index < NumObjects; ++Index)
+	{
+		uint8 TestData[] = { static_cast<uint8>(Index) };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	const double Deadline = FPlatformTime::Seconds() + 5.0;
+	while (NumReceived.load() < NumObjects && FPlatformTime::Seconds() < Deadline)
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+	
+	TestEqual(TEXT("Worker sink should receive every object"), NumReceived.load(), NumObjects);
+	TestTrue(TEXT("Worker sink should receive objects in order"), bInOrder.load());
+	TestTrue(TEXT("Worker sink should not run on the game thread"), bOffGameThread.load());
+	
+	// Release the sink (and the locals it captures) before returning
+	Subscriber->ConditionalBeginDestroy();
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberConflateTest, "UnrealMoQ.Subscriber.ReceiveQueue.Conflate", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberConflateTest::RunTest(const FString& Parameters)
+{
+	// Test that conflation delivers only the newest object and counts the rest as superseded
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	FMoqSubscribeOptions Options;
+	Options.ReceiveMode = EMoqReceiveMode::Conflate;
+	Subscriber->ApplyOptions(Options);
+	
+	TArray<uint8> Delivered;
+	Subscriber->OnPayloadReceived.AddLambda([&Delivered](TConstArrayView<uint8> Payload)
+	{
+		Delivered.Add(Payload[0]);
+	});
+	
+	for (uint8 Index = 0; Index < 4; ++Index)
+	{
+		uint8 TestData[] = { Index };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Only one object should be waiting"), Stats.QueuedObjects, 1);
+	TestEqual(TEXT("Three objects should be superseded"), Stats.SupersededObjects, (int64)3);
+	
+	TestEqual(TEXT("Drain should deliver a single object"), Subscriber->DispatchPendingEvents(), 1);
+	TestEqual(TEXT("Only the newest object should be delivered"), Delivered, TArray<uint8>({ 3 }));
+	TestEqual(TEXT("A second drain should have nothing to deliver"), Subscriber->DispatchPendingEvents(), 0);
+	
+	uint8 TestData[] = { 7 };
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	Subscriber->DispatchPendingEvents();
+	
+	Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Later objects should still be delivered"), Delivered, TArray<uint8>({ 3, 7 }));
+	TestEqual(TEXT("Every object should be counted as received"), Stats.ReceivedObjects, (int64)5);
+	TestEqual(TEXT("Superseded count should not change without overlap"), Stats.SupersededObjects, (int64)3);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberDispatchBudgetTest, "UnrealMoQ.Subscriber.ReceiveQueue.DispatchBudget", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberDispatchBudgetTest::RunTest(const FString& Parameters)
+{
+	// Test that an exhausted budget carries the backlog over without losing or reordering objects
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	TArray<uint8> Delivered;
+	Subscriber->OnPayloadReceived.AddLambda([&Delivered](TConstArrayView<uint8> Payload)
+	{
+		Delivered.Add(Payload[0]);
+	});
+	
+	for (uint8 Index = 0; Index < 5; ++Index)
+	{
+		uint8 TestData[] = { Index };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	FPlatformProcess::Sleep(0.002f);
+	TestTrue(TEXT("Backlog age should come from the queue head before any drain"), Subscriber->GetReceiveQueueStats().BacklogAgeMs >= 1.0f);
+	
+	TestEqual(TEXT("Nothing should be delivered once the budget is spent"), Subscriber->DispatchPendingEvents(FPlatformTime::Seconds() - 1.0), 0);
+	
+	FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Every object should still be waiting"), Stats.QueuedObjects, 5);
+	TestEqual(TEXT("The cut-short drain should be counted"), Stats.BudgetDeferrals, (int64)1);
+	TestTrue(TEXT("Backlog age should be reported"), Stats.BacklogAgeMs >= 0.0f);
+	
+	TestEqual(TEXT("An unbounded drain should deliver the backlog"), Subscriber->DispatchPendingEvents(), 5);
+	TestEqual(TEXT("Objects should be delivered in arrival order"), Delivered, TArray<uint8>({ 0, 1, 2, 3, 4 }));
+	
+	Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Backlog should be empty"), Stats.QueuedObjects, 0);
+	TestEqual(TEXT("Backlog age should reset"), Stats.BacklogAgeMs, 0.0f);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberBatchTest, "UnrealMoQ.Subscriber.ReceiveQueue.Batch", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberBatchTest::RunTest(const FString& Parameters)
+{
+	// Test that one drain produces a single batch with every object and its sequence number
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	int32 NumBatches = 0;
+	TArray<int64> Sequences;
+	TArray<uint8> Payloads;
+	Subscriber->OnPayloadBatchReceived.AddLambda([&NumBatches, &Sequences, &Payloads](TConstArrayView<FMoqReceivedObject> Batch)
+	{
+		++NumBatches;
+		for (const FMoqReceivedObject& Object : Batch)
+		{
+			Sequences.Add(Object.Sequence);
+			Payloads.Add(Object.GetData()[0]);
+		}
+	});
+	
+	for (uint8 Index = 0; Index < 3; ++Index)
+	{
+		uint8 TestData[] = { static_cast<uint8>(10 + Index) };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	TestEqual(TEXT("Drain should deliver every object"), Subscriber->DispatchPendingEvents(), 3);
+	TestEqual(TEXT("Batch event should fire once per drain"), NumBatches, 1);
+	TestEqual(TEXT("Batch should carry arrival sequence numbers"), Sequences, TArray<int64>({ 0, 1, 2 }));
+	TestEqual(TEXT("Batch should carry payloads in order"), Payloads, TArray<uint8>({ 10, 11, 12 }));
+	
+	Subscriber->DispatchPendingEvents();
+	TestEqual(TEXT("An empty drain should not fire the batch event"), NumBatches, 1);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberPollTest, "UnrealMoQ.Subscriber.ReceiveQueue.Poll", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberPollTest::RunTest(const FString& Parameters)
+{
+	// Test pulling objects instead of having them broadcast
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	FMoqSubscribeOptions Options;
+	Options.bAutoDispatch = false;
+	Subscriber->ApplyOptions(Options);
+	TestFalse(TEXT("Auto dispatch should be disabled by options"), Subscriber->IsAutoDispatchEnabled());
+	
+	int32 NumBroadcasts = 0;
+	Subscriber->OnPayloadReceived.AddLambda([&NumBroadcasts](TConstArrayView<uint8> Payload)
+	{
+		++NumBroadcasts;
+	});
+	
+	for (uint8 Index = 0; Index < 4; ++Index)
+	{
+		uint8 TestData[] = { Index };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	FMoqReceivedObject Object;
+	TestTrue(TEXT("TryDequeue should return the oldest object"), Subscriber->TryDequeue(Object) && Object.GetData()[0] == 0);
+	
+	TArray<FMoqReceivedObject> Objects;
+	TestEqual(TEXT("DrainInto should respect MaxObjects"), Subscriber->DrainInto(Objects, 2), 2);
+	TestEqual(TEXT("DrainInto should keep arrival order"), Objects[1].GetData()[0], (uint8)2);
+	
+	const TArray<FMoqReceivedMessage> Messages = Subscriber->PollMessages();
+	TestEqual(TEXT("PollMessages should return the rest"), Messages.Num(), 1);
+	TestEqual(TEXT("PollMessages should keep the sequence number"), Messages.Num() == 1 ? Messages[0].Sequence : INDEX_NONE, (int64)3);
+	
+	TestFalse(TEXT("Queue should be empty"), Subscriber->TryDequeue(Object));
+	TestEqual(TEXT("Pulled objects should count as delivered"), Subscriber->GetReceiveQueueStats().DeliveredObjects, (int64)4);
+	TestEqual(TEXT("Nothing should have been broadcast"), NumBroadcasts, 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberPollCarriedOverTest, "UnrealMoQ.Subscriber.ReceiveQueue.PollCarriedOver", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberPollCarriedOverTest::RunTest(const FString& Parameters)
+{
+	// Test that pulling after a budget-limited drain starts with the object the budget held back
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	for (uint8 Index = 0; Index < 3; ++Index)
+	{
+		uint8 TestData[] = { Index };
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), TestData, 1);
+	}
+	
+	TestEqual(TEXT("Spent budget should deliver nothing"), Subscriber->DispatchPendingEvents(FPlatformTime::Seconds() - 1.0), 0);
+	
+	TArray<FMoqReceivedObject> Objects;
+	TestEqual(TEXT("DrainInto should return every waiting object"), Subscriber->DrainInto(Objects), 3);
+	TestTrue(TEXT("Held-back object should come first"), Objects.Num() == 3 && Objects[0].GetData()[0] == 0 && Objects[1].GetData()[0] == 1 && Objects[2].GetData()[0] == 2);
+	
+	FMoqReceivedObject Object;
+	TestFalse(TEXT("Queue should be empty"), Subscriber->TryDequeue(Object));
+	TestEqual(TEXT("Nothing should be reported as waiting"), Subscriber->GetReceiveQueueStats().QueuedObjects, 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberStaleCallbackHandleTest, "UnrealMoQ.Subscriber.OnDataReceivedCallback.StaleHandle", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberStaleCallbackHandleTest::RunTest(const FString& Parameters)
+{
+	// Test that callbacks arriving after destruction are dropped without touching the subscriber
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	void* UserData = Subscriber->GetCallbackUserData();
+	TestNotNull(TEXT("Subscriber should get a callback handle"), UserData);
+	
+	Subscriber->ConditionalBeginDestroy();
+	TestNull(TEXT("Destroyed subscriber should release its callback handle"), Subscriber->GetCallbackUserData());
+	
+	uint8 TestData[] = { 0x01, 0x02, 0x03 };
+	UMoqSubscriber::OnDataReceivedCallback(UserData, TestData, 3);
+	
+	UMoqSubscriber* Replacement = NewObject<UMoqSubscriber>();
+	UMoqSubscriber::OnDataReceivedCallback(UserData, TestData, 3);
+	TestEqual(TEXT("A stale handle should never reach a newer subscriber"), Replacement->GetReceiveQueueStats().ReceivedObjects, (int64)0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberEnvelopeSplitTest, "UnrealMoQ.Subscriber.Envelope.Split", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberEnvelopeSplitTest::RunTest(const FString& Parameters)
+{
+	// Test that a coalesced object is delivered as the separate payloads it carries, only when decoding is enabled
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	
+	TArray<uint8> Delivered;
+	Subscriber->OnPayloadReceived.AddLambda([&Delivered](TConstArrayView<uint8> Payload)
+	{
+		Delivered.Add(static_cast<uint8>(Payload.Num()));
+	});
+	
+	TArray<uint8> Coalesced;
+	MoqEnvelope::WriteHeader(Coalesced, MoqEnvelope::EKind::Coalesced);
+	for (uint8 Size = 1; Size <= 3; ++Size)
+	{
+		MoqEnvelope::WriteVarint(Coalesced, Size);
+		Coalesced.AddZeroed(Size);
+	}
+	
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Coalesced.GetData(), Coalesced.Num());
+	Subscriber->DispatchPendingEvents();
+	TestEqual(TEXT("Without decoding the envelope should arrive as one object"), Delivered, TArray<uint8>({ static_cast<uint8>(Coalesced.Num()) }));
+	
+	Delivered.Reset();
+	Subscriber->SetEnvelopeDecodingEnabled(true);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Coalesced.GetData(), Coalesced.Num());
+	Subscriber->DispatchPendingEvents();
+	TestEqual(TEXT("Each coalesced payload should arrive as its own object"), Delivered, TArray<uint8>({ 1, 2, 3 }));
+	
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Coalesced.GetData(), Coalesced.Num() - 1);
+	TestEqual(TEXT("A truncated envelope should be counted as malformed"), Subscriber->GetReceiveQueueStats().MalformedObjects, (int64)1);
+	TestEqual(TEXT("A truncated envelope should deliver nothing"), Subscriber->DispatchPendingEvents(), 0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberEnvelopeCompressedTest, "UnrealMoQ.Subscriber.Envelope.Compressed", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberEnvelopeCompressedTest::RunTest(const FString& Parameters)
+{
+	// Test that compressed objects are restored, and need their dictionary registered first
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	Subscriber->SetEnvelopeDecodingEnabled(true);
+	
+	TArray<TArray<uint8>> Delivered;
+	Subscriber->OnPayloadReceived.AddLambda([&Delivered](TConstArrayView<uint8> Payload)
+	{
+		Delivered.Add(TArray<uint8>(Payload));
+	});
+	
+	TArray<uint8> Original;
+	for (int32 Index = 0; Index < 64; ++Index)
+	{
+		Original.Append({ 0x10, 0x20, 0x30, 0x40 });
+	}
+	const TArray<uint8> Dictionary = { 0x10, 0x20, 0x30, 0x40, 0x10, 0x20, 0x30, 0x40 };
+	
+	TArray<uint8> Envelope;
+	MoqEnvelope::WriteHeader(Envelope, MoqEnvelope::EKind::Compressed);
+	Envelope.Add(static_cast<uint8>(EMoqCompression::ZlibDictionary));
+	MoqEnvelope::WriteVarint(Envelope, MoqCompression::GetDictionaryId(Dictionary));
+	MoqEnvelope::WriteVarint(Envelope, Original.Num());
+	TestTrue(TEXT("Payload should compress"), MoqCompression::Compress(EMoqCompression::ZlibDictionary, Original, Dictionary, Envelope));
+	
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Envelope.GetData(), Envelope.Num());
+	TestEqual(TEXT("Without the dictionary the object should be discarded"), Subscriber->GetReceiveQueueStats().MalformedObjects, (int64)1);
+	
+	Subscriber->AddCompressionDictionary(Dictionary);
+	UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Envelope.GetData(), Envelope.Num());
+	Subscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("One object should be delivered"), Delivered.Num(), 1);
+	TestTrue(TEXT("Delivered payload should be the decompressed original"), Delivered.Num() == 1 && Delivered[0] == Original);
+	
+	const FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Decompressed bytes should be counted"), Stats.DecompressedBytes, (int64)Original.Num());
+	TestEqual(TEXT("Compressed bytes should be counted"), Stats.CompressedBytes, (int64)Envelope.Num());
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberEnvelopeDeltaTest, "UnrealMoQ.Subscriber.Envelope.Delta", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberEnvelopeDeltaTest::RunTest(const FString& Parameters)
+{
+	// Test that deltas rebuild full state and that a lost object skips deltas until the next keyframe
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	Subscriber->SetEnvelopeDecodingEnabled(true);
+	
+	TArray<TArray<uint8>> Delivered;
+	Subscriber->OnPayloadReceived.AddLambda([&Delivered](TConstArrayView<uint8> Payload)
+	{
+		Delivered.Add(TArray<uint8>(Payload));
+	});
+	
+	TArray<TArray<uint8>> States;
+	for (int32 Tick = 0; Tick < 4; ++Tick)
+	{
+		TArray<uint8> State;
+		State.Init(0x42, 64);
+		State[Tick] = static_cast<uint8>(Tick + 1);
+		States.Add(State);
+	}
+	
+	auto MakeKeyframe = [](uint64 Sequence, const TArray<uint8>& State)
+	{
+		TArray<uint8> Object;
+		MoqEnvelope::WriteHeader(Object, MoqEnvelope::EKind::Keyframe);
+		MoqEnvelope::WriteVarint(Object, Sequence);
+		Object.Append(State);
+		return Object;
+	};
+	auto MakeDelta = [](uint64 Sequence, const TArray<uint8>& Base, const TArray<uint8>& State)
+	{
+		TArray<uint8> Object;
+		MoqEnvelope::WriteHeader(Object, MoqEnvelope::EKind::Delta);
+		MoqEnvelope::WriteVarint(Object, Sequence);
+		MoqEnvelope::WriteVarint(Object, State.Num());
+		MoqDelta::Encode(Base, State, Object);
+		return Object;
+	};
+	auto Receive = [Subscriber](const TArray<uint8>& Object)
+	{
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Object.GetData(), Object.Num());
+	};
+	
+	Receive(MakeDelta(0, TArray<uint8>(), States[0]));
+	Receive(MakeKeyframe(1, States[0]));
+	Receive(MakeDelta(2, States[0], States[1]));
+	// Sequence 3 is lost, so the delta against it cannot be applied
+	Receive(MakeDelta(4, States[2], States[3]));
+	Receive(MakeKeyframe(5, States[3]));
+	Subscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("Keyframes and the applicable delta should be delivered"), Delivered.Num(), 3);
+	if (Delivered.Num() == 3)
+	{
+		TestEqual(TEXT("Keyframe should deliver its state"), Delivered[0], States[0]);
+		TestEqual(TEXT("Delta should deliver the full rebuilt state"), Delivered[1], States[1]);
+		TestEqual(TEXT("Resync keyframe should deliver its state"), Delivered[2], States[3]);
+	}
+	
+	const FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Keyframes should be counted"), Stats.KeyframeObjects, (int64)2);
+	TestEqual(TEXT("Applied deltas should be counted"), Stats.DeltaObjects, (int64)1);
+	TestEqual(TEXT("Deltas without a base should be skipped"), Stats.SkippedDeltaObjects, (int64)2);
+	TestEqual(TEXT("Skipped deltas are not malformed"), Stats.MalformedObjects, (int64)0);
+	
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqSubscriberEnvelopeGroupedTest, "UnrealMoQ.Subscriber.Envelope.Grouped", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqSubscriberEnvelopeGroupedTest::RunTest(const FString& Parameters)
+{
+	// Test that group and object ids reach listeners, including from coalesced objects, and that joining waits for a group start
+	UMoqSubscriber* Subscriber = NewObject<UMoqSubscriber>();
+	FMoqSubscribeOptions Options;
+	Options.bDecodeEnvelopes = true;
+	Options.bJoinAtGroupStart = true;
+	Subscriber->ApplyOptions(Options);
+	
+	TArray<FMoqReceivedObject> Delivered;
+	Subscriber->OnPayloadBatchReceived.AddLambda([&Delivered](TConstArrayView<FMoqReceivedObject> Objects)
+	{
+		Delivered.Append(Objects.GetData(), Objects.Num());
+	});
+	
+	auto MakeGrouped = [](uint64 GroupId, uint64 ObjectId, const TArray<uint8>& Payload)
+	{
+		TArray<uint8> Object;
+		MoqEnvelope::WriteHeader(Object, MoqEnvelope::EKind::Grouped);
+		MoqEnvelope::WriteVarint(Object, GroupId);
+		MoqEnvelope::WriteVarint(Object, ObjectId);
+		Object.Append(Payload);
+		return Object;
+	};
+	auto MakeCoalesced = [](const TArray<TArray<uint8>>& Items)
+	{
+		TArray<uint8> Object;
+		MoqEnvelope::WriteHeader(Object, MoqEnvelope::EKind::Coalesced);
+		for (const TArray<uint8>& Item : Items)
+		{
+			MoqEnvelope::WriteVarint(Object, Item.Num());
+			Object.Append(Item);
+		}
+		return Object;
+	};
+	auto Receive = [Subscriber](const TArray<uint8>& Object)
+	{
+		UMoqSubscriber::OnDataReceivedCallback(Subscriber->GetCallbackUserData(), Object.GetData(), Object.Num());
+	};
+	
+	// Joined in the middle of group 3
+	Receive(MakeGrouped(3, 2, { 1, 2 }));
+	Receive(MakeCoalesced({ MakeGrouped(4, 0, { 3 }), MakeGrouped(4, 1, { MoqEnvelope::MagicByte, 4 }) }));
+	Receive(MakeGrouped(4, 2, { 5 }));
+	Subscriber->DispatchPendingEvents();
+	
+	TestEqual(TEXT("Objects from the group start on should be delivered"), Delivered.Num(), 3);
+	if (Delivered.Num() == 3)
+	{
+		TestEqual(TEXT("Group start should carry its group id"), Delivered[0].GroupId, (int64)4);
+		TestEqual(TEXT("Group start should be object 0"), Delivered[0].ObjectId, (int64)0);
+		TestEqual(TEXT("Group start payload should be unframed"), TArray<uint8>(Delivered[0].GetData()), TArray<uint8>({ 3 }));
+		TestEqual(TEXT("Coalesced objects should keep their own ids"), Delivered[1].ObjectId, (int64)1);
+		TestEqual(TEXT("Payloads starting with the magic byte should be delivered as published"), TArray<uint8>(Delivered[1].GetData()), TArray<uint8>({ MoqEnvelope::MagicByte, 4 }));
+		TestEqual(TEXT("Later objects should follow in order"), Delivered[2].ObjectId, (int64)2);
+	}
+	
+	const FMoqReceiveQueueStats Stats = Subscriber->GetReceiveQueueStats();
+	TestEqual(TEXT("Objects before the group start should be skipped"), Stats.SkippedBeforeGroupStart, (int64)1);
+	TestEqual(TEXT("Grouped objects are not malformed"), Stats.MalformedObjects, (int64)0);
+	
+	return true;
+}
@@ -0,0 +1,201 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "MoqUtf8.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/AutomationTest.h"
+#include "MoqAutomationTestFlags.h"
+
+namespace
+{
+TArray<uint8> Utf8Bytes(const FString& Text)
+{
+	FTCHARToUTF8 Converter(*Text);
+	return TArray<uint8>(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+}
+
+/** The receive path before the shared kernel: scalar validation, FUTF8ToTCHAR, then a scan for U+FFFD */
+bool LegacyDecode(const TArray<uint8>& Data, FString& OutText)
+{
+	if (!MoqUtf8::IsValidScalar(Data))
+	{
+		return false;
+	}
+
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data.GetData()), Data.Num());
+	OutText = FString(Converter.Length(), Converter.Get());
+	return !OutText.Contains(TEXT("\uFFFD"));
+}
+
+TArray<uint8> BuildPayload(const FString& Fragment, int32 TargetSize)
+{
+	const TArray<uint8> FragmentBytes = Utf8Bytes(Fragment);
+	TArray<uint8> Payload;
+	Payload.Reserve(TargetSize + FragmentBytes.Num());
+	while (Payload.Num() < TargetSize)
+	{
+		Payload.Append(FragmentBytes);
+	}
+	return Payload;
+}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqUtf8ValidateKnownSequencesTest, "UnrealMoQ.Utf8.Validate.KnownSequences", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqUtf8ValidateKnownSequencesTest::RunTest(const FString& Parameters)
+{
+	// Test well-known valid and invalid sequences against both kernels
+	struct FCase
+	{
+		TArray<uint8> Bytes;
+		bool bValid;
+	};
+
+	const TArray<FCase> Cases =
+	{
+		{ { 'H', 'e', 'l', 'l', 'o' }, true },
+		{ { 0xC3, 0xA9 }, true },                  // é
+		{ { 0xE4, 0xB8, 0x96 }, true },            // 世
+		{ { 0xF0, 0x9F, 0x98, 0x80 }, true },      // 😀
+		{ { 0xC0, 0xAF }, false },                 // Overlong '/'
+		{ { 0xE0, 0x80, 0xAF }, false },           // Overlong 3-byte
+		{ { 0xED, 0xA0, 0x80 }, false },           // Surrogate
+		{ { 0xF4, 0x90, 0x80, 0x80 }, false },     // Above U+10FFFF
+		{ { 0x80 }, false },                       // Lone continuation
+		{ { 0xE4, 0xB8 }, false },                 // Truncated
+		{ { 0xFF, 0xFE, 0xFD }, false }
+	};
+
+	for (const FCase& Case : Cases)
+	{
+		TestEqual(TEXT("Scalar validator should classify the sequence"), MoqUtf8::IsValidScalar(Case.Bytes), Case.bValid);
+		TestEqual(FString::Printf(TEXT("%s validator should classify the sequence"), MoqUtf8::GetKernelName()), MoqUtf8::IsValid(Case.Bytes), Case.bValid);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqUtf8ValidateMatchesScalarTest, "UnrealMoQ.Utf8.Validate.MatchesScalar", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqUtf8ValidateMatchesScalarTest::RunTest(const FString& Parameters)
+{
+	// Test that the vector kernel agrees with the scalar reference on random and near-valid input
+	FRandomStream Random(0x4D6F51);
+	const TArray<uint8> Fragments = Utf8Bytes(TEXT("aé世😀"));
+
+	int32 NumMismatches = 0;
+	for (int32 Iteration = 0; Iteration < 20000; ++Iteration)
+	{
+		TArray<uint8> Data;
+		const int32 Length = Random.RandRange(0, 200);
+		const bool bMostlyValid = Random.RandBool();
+		while (Data.Num() < Length)
+		{
+			if (bMostlyValid)
+			{
+				Data.Add(Fragments[Random.RandRange(0, Fragments.Num() - 1)]);
+			}
+			else
+			{
+				Data.Add(static_cast<uint8>(Random.RandRange(0, 255)));
+			}
+		}
+
+		if (MoqUtf8::IsValid(Data) != MoqUtf8::IsValidScalar(Data))
+		{
+			++NumMismatches;
+		}
+	}
+
+	TestEqual(TEXT("Vector and scalar validators should always agree"), NumMismatches, 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqUtf8DecodeToStringTest, "UnrealMoQ.Utf8.DecodeToString", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FMoqUtf8DecodeToStringTest::RunTest(const FString& Parameters)
+{
+	// Test single-pass decoding across the ASCII fast path and multi-byte sequences
+	const FString Original = TEXT("A long ASCII prefix that spans several blocks, then 世界 and 😀 and é.");
+
+	FString Decoded;
+	TestTrue(TEXT("Valid UTF-8 should decode"), MoqUtf8::DecodeToString(Utf8Bytes(Original), Decoded));
+	TestEqual(TEXT("Decoded text should round trip"), Decoded, Original);
+
+	const TArray<uint8> Invalid = { 'o', 'k', 0xC0, 0xAF };
+	TestFalse(TEXT("Invalid UTF-8 should not decode"), MoqUtf8::DecodeToString(Invalid, Decoded));
+	TestTrue(TEXT("Failed decode should leave the output empty"), Decoded.IsEmpty());
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FMoqUtf8BenchmarkTest, "UnrealMoQ.Utf8.Benchmark", MoqAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FMoqUtf8BenchmarkTest::RunTest(const FString& Parameters)
+{
+	// Compare the shared kernel against the previous validate + convert + rescan path
+	struct FPayloadCase
+	{
+		const TCHAR* Name;
+		TArray<uint8> Bytes;
+	};
+
+	constexpr int32 PayloadSize = 64 * 1024;
+	constexpr int32 Iterations = 200;
+
+	const TArray<FPayloadCase> Payloads =
+	{
+		{ TEXT("ASCII"), BuildPayload(TEXT("{\"pos\":[1.0,2.5,-3.25],\"id\":42}"), PayloadSize) },
+		{ TEXT("Mixed"), BuildPayload(TEXT("player=Zoë score=1200 city=Zürich ✓ "), PayloadSize) },
+		{ TEXT("CJK"), BuildPayload(TEXT("媒体传输协议世界你好こんにちは"), PayloadSize) }
+	};
+
+	AddInfo(FString::Printf(TEXT("Vector kernel: %s"), MoqUtf8::GetKernelName()));
+
+	for (const FPayloadCase& Payload : Payloads)
+	{
+		FString LegacyText;
+		FString KernelText;
+
+		const double LegacyStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			LegacyDecode(Payload.Bytes, LegacyText);
+		}
+		const double LegacySeconds = FPlatformTime::Seconds() - LegacyStart;
+
+		const double KernelStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			MoqUtf8::DecodeToString(Payload.Bytes, KernelText);
+		}
+		const double KernelSeconds = FPlatformTime::Seconds() - KernelStart;
+
+		const double ScalarValidateStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			MoqUtf8::IsValidScalar(Payload.Bytes);
+		}
+		const double ScalarValidateSeconds = FPlatformTime::Seconds() - ScalarValidateStart;
+
+		const double VectorValidateStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+		{
+			MoqUtf8::IsValid(Payload.Bytes);
+		}
+		const double VectorValidateSeconds = FPlatformTime::Seconds() - VectorValidateStart;
+
+		const double MegaBytes = static_cast<double>(Payload.Bytes.Num()) * Iterations / (1024.0 * 1024.0);
+		AddInfo(FString::Printf(TEXT("%s decode: legacy %.1f MB/s, kernel %.1f MB/s | validate: scalar %.1f MB/s, vector %.1f MB/s"),
+			Payload.Name,
+			MegaBytes / FMath::Max(LegacySeconds, UE_DOUBLE_SMALL_NUMBER),
+			MegaBytes / FMath::Max(KernelSeconds, UE_DOUBLE_SMALL_NUMBER),
+			MegaBytes / FMath::Max(ScalarValidateSeconds, UE_DOUBLE_SMALL_NUMBER),
+			MegaBytes / FMath::Max(VectorValidateSeconds, UE_DOUBLE_SMALL_NUMBER)));
+
+		TestEqual(FString::Printf(TEXT("%s: kernel and legacy decode should produce the same text"), Payload.Name), KernelText, LegacyText);
+	}
+
+	return true;
+}
@@ -14,6 +14,7 @@ public class UnrealMoQTests : ModuleRules
 				"Core",
 				"CoreUObject",
 				"Engine",
+				"Json",
 				"UnrealMoQ"
 			}
 		);